@@ -0,0 +1,469 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "QtInclude.h"
+#include "AnimationDriver.h"
+#include "FadeButton.h"
+#include "LogRecord.h"
+#include "LogWidget.h"
+#include "Metrics.h"
+#include "OSCParser.h"
+#include "Toys.h"
+#include "ToyMetro.h"
+#include "Utils.h"
+#include <QtTest>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// feedback tables are label grids loaded from a generated show, so every
+// benchmark runs through the same Load path as a real show file
+class Benchmarks
+	: public QObject
+	, private Toy::Client
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void recv_data();
+	void recv();
+	void getItemsFromQuotedString_data();
+	void getItemsFromQuotedString();
+	void saveShow_data();
+	void saveShow();
+	void loadShow_data();
+	void loadShow();
+	void createPacket_data();
+	void createPacket();
+	void streamFraming_data();
+	void streamFraming();
+	void logWidget_data();
+	void logWidget();
+	void fadeButtonPaint_data();
+	void fadeButtonPaint();
+
+private:
+	EosLog	m_Log;
+
+	virtual bool ToyClient_Send(bool local, char *data, size_t size);
+	virtual bool ToyClient_SendAt(char *data, size_t size, qint64 dueNS, const void *owner);
+	virtual void ToyClient_CancelSends(const void* /*owner*/) {}
+	virtual void ToyClient_ResourceRelativePathToAbsolute(QString& /*path*/) {}
+
+	static void AddTableRows();
+	static void DeleteToys(Toys &toys);
+	static void MakeShow(int numWidgets, bool wildcard, QStringList &lines);
+	static QString MakeLabelPath(int index, bool wildcard);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Benchmarks::ToyClient_Send(bool /*local*/, char *data, size_t /*size*/)
+{
+	delete[] data;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Benchmarks::ToyClient_SendAt(char *data, size_t /*size*/, qint64 /*dueNS*/, const void* /*owner*/)
+{
+	delete[] data;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::DeleteToys(Toys &toys)
+{
+	// Toys::Clear uses deleteLater and there is no event loop running
+	toys.Clear();
+	QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::AddTableRows()
+{
+	QTest::addColumn<int>("numWidgets");
+	QTest::addColumn<bool>("wildcard");
+
+	const int sizes[] = {16, 256, 1024};
+	for(size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+	{
+		QTest::newRow( QString("exact %1").arg(sizes[i]).toUtf8().constData() ) << sizes[i] << false;
+		QTest::newRow( QString("wildcard %1").arg(sizes[i]).toUtf8().constData() ) << sizes[i] << true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString Benchmarks::MakeLabelPath(int index, bool wildcard)
+{
+	if( wildcard )
+		return QString("/eos/out/bench/%1/*").arg(index);
+
+	return QString("/eos/out/bench/%1").arg(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::MakeShow(int numWidgets, bool wildcard, QStringList &lines)
+{
+	int width = qMax(1, qCeil(qSqrt(numWidgets)));
+	int height = ((numWidgets + width - 1) / width);
+
+	QString empty( Utils::QuotedString(QString()) );
+
+	// hidden label grid, see ToyGrid::Save
+	lines << QString("%1, 0, 0, 400, 400, 0, 0, %2, %3, %4, %4, ff282828, 0").arg(static_cast<int>(Toy::TOY_LABEL_GRID)).arg(width).arg(height).arg(empty);
+
+	// see ToyWidget::Save
+	for(int i=0; i<width*height; i++)
+	{
+		lines << QString("1, %1, %1, %2, %1, %1, %3, %1, %1, ffffffff, ffffffff, ffffffff, ffffffff, 0, 100, 0, 100, 120")
+			.arg(empty)
+			.arg( Utils::QuotedString(MakeLabelPath(i,wildcard)) )
+			.arg( Utils::QuotedString(QString("Label %1").arg(i)) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::initTestCase()
+{
+	Metrics::Instantiate();
+	PixmapCache::Instantiate();
+	AnimationDriver::Instantiate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::cleanupTestCase()
+{
+	AnimationDriver::Shutdown();
+	PixmapCache::Shutdown();
+	Metrics::Shutdown();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::recv_data()
+{
+	AddTableRows();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::recv()
+{
+	QFETCH(int, numWidgets);
+	QFETCH(bool, wildcard);
+
+	QStringList lines;
+	MakeShow(numWidgets, wildcard, lines);
+
+	Toys toys(this, /*parent*/0);
+	int index = 0;
+	toys.Load(m_Log, QString(), lines, index);
+
+	// a label update for the middle of the table, matched exactly or by the last pattern tried
+	QString path( MakeLabelPath(numWidgets/2,/*wildcard*/false) );
+	if( wildcard )
+		path.append("/name");
+
+	OSCPacketWriter packetWriter( path.toUtf8().constData() );
+	packetWriter.AddString("bench");
+	size_t size = 0;
+	char *packet = packetWriter.Create(size);
+	QVERIFY(packet != 0);
+
+	QBENCHMARK
+	{
+		toys.Recv(packet, size);
+	}
+
+	delete[] packet;
+	DeleteToys(toys);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::getItemsFromQuotedString_data()
+{
+	QTest::addColumn<QString>("line");
+
+	QTest::newRow("grid") << QString("10, 120, 80, 400, 400, 0, 1, 4, 4, \"Labels\", \"\", ff282828, 0");
+	QTest::newRow("widget") << QString("1, \"/eos/key/go_0\", \"\", \"/eos/out/active/cue/text\", \"\", \"\", \"Go, \"\"Now\"\"\", \"images/go.png\", \"\", ffffffff, ff000000, ffffffff, ff000000, 0, 100, 0, 100, 120");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::getItemsFromQuotedString()
+{
+	QFETCH(QString, line);
+
+	QStringList items;
+	QBENCHMARK
+	{
+		items.clear();
+		Utils::GetItemsFromQuotedString(line, items);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::saveShow_data()
+{
+	AddTableRows();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::saveShow()
+{
+	QFETCH(int, numWidgets);
+	QFETCH(bool, wildcard);
+
+	QStringList lines;
+	MakeShow(numWidgets, wildcard, lines);
+
+	Toys toys(this, /*parent*/0);
+	int index = 0;
+	toys.Load(m_Log, QString(), lines, index);
+
+	QBENCHMARK
+	{
+		lines.clear();
+		toys.Save(m_Log, QString(), lines);
+	}
+
+	DeleteToys(toys);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::loadShow_data()
+{
+	AddTableRows();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::loadShow()
+{
+	QFETCH(int, numWidgets);
+	QFETCH(bool, wildcard);
+
+	QStringList lines;
+	MakeShow(numWidgets, wildcard, lines);
+
+	Toys toys(this, /*parent*/0);
+
+	QBENCHMARK
+	{
+		int index = 0;
+		toys.Load(m_Log, QString(), lines, index);
+		QCoreApplication::sendPostedEvents(0, QEvent::DeferredDelete);
+	}
+
+	DeleteToys(toys);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::createPacket_data()
+{
+	QTest::addColumn<QString>("path");
+	QTest::addColumn<QString>("min");
+	QTest::addColumn<QString>("max");
+	QTest::addColumn<int>("pos");
+
+	QTest::newRow("no args") << QString("/eos/key/go_0") << QString() << QString() << static_cast<int>(FadeMetro::TICK_POS_CENTER);
+	QTest::newRow("float") << QString("/eos/chan/1/param/intens") << QString("0") << QString("55.5") << static_cast<int>(FadeMetro::TICK_POS_RIGHT);
+	QTest::newRow("string") << QString("/eos/cmd") << QString("Chan 1 Thru 10 Full#") << QString("Chan 1 Thru 10 Full#") << static_cast<int>(FadeMetro::TICK_POS_CENTER);
+	QTest::newRow("local") << QString("/local/bench/1") << QString() << QString("1") << static_cast<int>(FadeMetro::TICK_POS_CENTER);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::createPacket()
+{
+	QFETCH(QString, path);
+	QFETCH(QString, min);
+	QFETCH(QString, max);
+	QFETCH(int, pos);
+
+	// the metronome's tick packets, the same builder its scheduled and local sends use
+	ToyMetroGrid grid(this, /*parent*/0, 0);
+	grid.SetGridSize( QSize(1,1) );
+	QCOMPARE(grid.GetWidgets().size(), static_cast<size_t>(1));
+
+	ToyMetroWidget *metro = static_cast<ToyMetroWidget*>( grid.GetWidgets().front() );
+	metro->SetPath(path);
+	metro->SetMin(min);
+	metro->SetMax(max);
+
+	bool local = false;
+	size_t size = 0;
+	char *packet = grid.CreateTickPacket(metro, pos, local, size);
+	QVERIFY(packet != 0);
+	delete[] packet;
+
+	QBENCHMARK
+	{
+		packet = grid.CreateTickPacket(metro, pos, local, size);
+		delete[] packet;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::streamFraming_data()
+{
+	QTest::addColumn<int>("frameMode");
+	QTest::addColumn<int>("numPackets");
+
+	QTest::newRow("1.0 x1") << static_cast<int>(OSCStream::FRAME_MODE_1_0) << 1;
+	QTest::newRow("1.0 x64") << static_cast<int>(OSCStream::FRAME_MODE_1_0) << 64;
+	QTest::newRow("1.1 x1") << static_cast<int>(OSCStream::FRAME_MODE_1_1) << 1;
+	QTest::newRow("1.1 x64") << static_cast<int>(OSCStream::FRAME_MODE_1_1) << 64;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::streamFraming()
+{
+	QFETCH(int, frameMode);
+	QFETCH(int, numPackets);
+
+	OSCStream::EnumFrameMode mode = static_cast<OSCStream::EnumFrameMode>(frameMode);
+
+	OSCPacketWriter packetWriter("/eos/out/active/chan/1/param/intens");
+	packetWriter.AddFloat32(55.5f);
+	size_t packetSize = 0;
+	char *packet = packetWriter.Create(packetSize);
+	QVERIFY(packet != 0);
+
+	// frame on send, then reassemble a burst of frames as one tcp read would deliver them
+	QBENCHMARK
+	{
+		QByteArray stream;
+		for(int i=0; i<numPackets; i++)
+		{
+			size_t frameSize = packetSize;
+			char *frame = OSCStream::CreateFrame(mode, packet, frameSize);
+			if( frame )
+			{
+				stream.append(frame, static_cast<int>(frameSize));
+				delete[] frame;
+			}
+		}
+
+		OSCStream oscStream(mode);
+		oscStream.Add(stream.constData(), static_cast<size_t>(stream.size()));
+		for(;;)
+		{
+			size_t frameSize = 0;
+			char *frame = oscStream.GetNextFrame(frameSize);
+			if( !frame )
+				break;
+			delete[] frame;
+		}
+	}
+
+	delete[] packet;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::logWidget_data()
+{
+	QTest::addColumn<int>("numRecords");
+
+	QTest::newRow("1") << 1;
+	QTest::newRow("100") << 100;
+	QTest::newRow("1000") << 1000;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::logWidget()
+{
+	QFETCH(int, numRecords);
+
+	LOG_RECORD_Q records;
+	for(int i=0; i<numRecords; i++)
+	{
+		sLogRecord record;
+		record.type = EosLog::LOG_MSG_TYPE_RECV;
+		record.timestamp = 0;
+		record.line = QString("[00:00:00] IN  [%1] /eos/out/active/chan/1/param/intens, 55.5(f)").arg(i);
+		records.push_back(record);
+	}
+
+	LogWidget logWidget(1000, /*parent*/0);
+	logWidget.resize(800, 300);
+
+	QBENCHMARK
+	{
+		logWidget.Log(records);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::fadeButtonPaint_data()
+{
+	QTest::addColumn<QSize>("size");
+	QTest::addColumn<QString>("label");
+
+	QTest::newRow("80x80") << QSize(80,80) << QString();
+	QTest::newRow("80x80 label") << QSize(80,80) << QString("Label");
+	QTest::newRow("240x160 label") << QSize(240,160) << QString("Label");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Benchmarks::fadeButtonPaint()
+{
+	QFETCH(QSize, size);
+	QFETCH(QString, label);
+
+	FadeButton button(/*parent*/0);
+	button.setText("Go");
+	button.SetLabel(label);
+	button.resize(size);
+
+	QPixmap pixmap(size);
+
+	QBENCHMARK
+	{
+		button.render(&pixmap);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QTEST_MAIN(Benchmarks)
+#include "Benchmarks.moc"
+
+////////////////////////////////////////////////////////////////////////////////
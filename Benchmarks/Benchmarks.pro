@@ -0,0 +1,32 @@
+# Micro benchmarks for the hot paths of OSCWidgets, built from the app sources.
+#
+#   mkdir build-bench && cd build-bench
+#   qmake ../Benchmarks/Benchmarks.pro && make
+#   QT_QPA_PLATFORM=offscreen ./OSCWidgetsBenchmarks -o results.xml,xml -o -,txt
+#
+# QTest writes machine readable results with -o <file>,xml or -o <file>,csv
+
+APP_ROOT = $$PWD/..
+include($$APP_ROOT/OSCWidgets.pro)
+
+TARGET = OSCWidgetsBenchmarks
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+# app paths are relative to the app project, and main() comes from QTEST_MAIN
+defineReplace(appPaths) {
+    result =
+    for(file, 1) {
+        !equals(file, OSCWidgets/main.cpp): result += $$APP_ROOT/$$file
+    }
+    return($$result)
+}
+
+HEADERS = $$appPaths($$HEADERS)
+SOURCES = $$appPaths($$SOURCES)
+OBJECTIVE_SOURCES = $$appPaths($$OBJECTIVE_SOURCES)
+RESOURCES = $$appPaths($$RESOURCES)
+INCLUDEPATH = $$appPaths($$INCLUDEPATH)
+
+SOURCES += Benchmarks.cpp
@@ -0,0 +1,33 @@
+# Runs an OSCWidgets show without the main window, for bridge and soak
+# deployments on machines with no display, built from the app sources.
+# Toys are still widgets, so this links the same Qt gui modules as the app
+# and runs on the offscreen platform rather than a QCoreApplication.
+#
+#   mkdir build-headless && cd build-headless
+#   qmake ../Headless/Headless.pro && make
+#   ./OSCWidgetsHeadless --help
+
+APP_ROOT = $$PWD/..
+include($$APP_ROOT/OSCWidgets.pro)
+
+TARGET = OSCWidgetsHeadless
+CONFIG += console
+CONFIG -= app_bundle
+
+# app paths are relative to the app project, and main() is our own
+defineReplace(appPaths) {
+    result =
+    for(file, 1) {
+        !equals(file, OSCWidgets/main.cpp): result += $$APP_ROOT/$$file
+    }
+    return($$result)
+}
+
+HEADERS = $$appPaths($$HEADERS)
+SOURCES = $$appPaths($$SOURCES)
+OBJECTIVE_SOURCES = $$appPaths($$OBJECTIVE_SOURCES)
+RESOURCES = $$appPaths($$RESOURCES)
+INCLUDEPATH = $$appPaths($$INCLUDEPATH)
+
+HEADERS += HeadlessHost.h
+SOURCES += HeadlessHost.cpp main.cpp
@@ -0,0 +1,254 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "HeadlessHost.h"
+#include "Utils.h"
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+volatile sig_atomic_t HeadlessHost::sm_Interrupted = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+HeadlessHost::sSettings::sSettings()
+	: seconds(0)
+	, verbose(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+HeadlessHost::HeadlessHost(const sSettings &settings)
+	: m_Settings(settings)
+	, m_Engine(0)
+	, m_StartNS(0)
+{
+	connect(&m_Timer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+HeadlessHost::~HeadlessHost()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool HeadlessHost::Start()
+{
+	Stop();
+
+	if( !m_Settings.logPath.isEmpty() )
+		m_LogFile.Initialize(m_Settings.logPath, 4096*1024, 4);
+
+	if( !m_Settings.metricsPath.isEmpty() )
+	{
+		m_MetricsFile.setFileName(m_Settings.metricsPath);
+		if( !m_MetricsFile.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		{
+			printf("unable to open metrics file \"%s\"\n", m_Settings.metricsPath.toUtf8().constData());
+			return false;
+		}
+
+		QByteArray header;
+		Metrics::GetCSVHeader(header);
+		m_MetricsFile.write(header);
+	}
+
+	Toy::RestoreDefaultSettings();
+	QSettings appSettings("ETC", "OSCWidgets");
+	Engine::LoadAdvancedSettings(appSettings);
+
+	m_Engine = new Engine(*this, m_Log, /*capture*/0, /*toysParent*/0);
+
+	if( !LoadShow() )
+	{
+		FlushLog();
+		return false;
+	}
+
+	METRICS.TakeSnapshot(m_StartSnapshot);
+	m_MetricsSnapshot = m_StartSnapshot;
+	m_StartNS = Utils::GetTimeNS();
+
+	// the engine tick idles down to once a second, this covers the run time
+	m_Timer.start(250);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool HeadlessHost::LoadShow()
+{
+	QStringList lines;
+	if( !Engine::ReadShowFile(m_Settings.showPath,lines) )
+	{
+		m_Log.AddError( QString("Unable to open \"%1\"").arg(QDir::toNativeSeparators(m_Settings.showPath)).toUtf8().constData() );
+		return false;
+	}
+
+	m_Engine->SetShowPath(m_Settings.showPath);
+	m_Log.AddInfo( QString("Loaded \"%1\"").arg(QDir::toNativeSeparators(m_Settings.showPath)).toUtf8().constData() );
+
+	Engine::sNetworkSettings networkSettings;
+	int lineIndex = 0;
+	if(lineIndex < lines.size())
+	{
+		QStringList items;
+		Engine::LoadShowSettings(lines[lineIndex++], networkSettings, items);
+	}
+
+	Toys *toys = m_Engine->GetToys();
+	toys->Load(m_Log, m_Settings.showPath, lines, lineIndex);
+
+	// hidden toys skip painting, generators with an OSC path keep sending
+	toys->ActivateAllToys(false);
+
+	m_Log.AddInfo( QString("%1 toys, %2 %3:%4")
+		.arg(toys->GetList().size())
+		.arg((networkSettings.mode==OSCStream::FRAME_MODE_INVALID) ? "udp" : "tcp")
+		.arg(networkSettings.ip)
+		.arg(networkSettings.port1).toUtf8().constData() );
+
+	m_Engine->Start(networkSettings);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void HeadlessHost::Stop()
+{
+	m_Timer.stop();
+
+	if( m_Engine )
+	{
+		delete m_Engine;
+		m_Engine = 0;
+	}
+
+	FlushLog();
+	m_LogFile.Shutdown();
+	m_MetricsFile.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool HeadlessHost::FlushLog()
+{
+	m_Log.Flush(m_TempLogQ);
+	if( m_TempLogQ.empty() )
+		return false;
+
+	m_LogFormatter.Format(m_TempLogQ, m_LogRecordQ);
+	m_TempLogQ.clear();
+
+	for(LOG_RECORD_Q::const_iterator i=m_LogRecordQ.begin(); i!=m_LogRecordQ.end(); i++)
+	{
+		switch( i->type )
+		{
+			case EosLog::LOG_MSG_TYPE_DEBUG:
+			case EosLog::LOG_MSG_TYPE_RECV:
+			case EosLog::LOG_MSG_TYPE_SEND:
+				if( !m_Settings.verbose )
+					continue;
+				break;
+
+			default:
+				break;
+		}
+
+		printf("%s\n", i->line.toUtf8().constData());
+	}
+	fflush(stdout);
+
+	m_LogFile.Log(m_LogRecordQ);
+	m_LogRecordQ.clear();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void HeadlessHost::UpdateMetrics()
+{
+	// once a second, same as the app's metrics export
+	if( !m_MetricsFile.isOpen() )
+		return;
+	if(Utils::GetTimeNS()-m_MetricsSnapshot.timeNS < 1000000000)
+		return;
+
+	Metrics::sSnapshot snapshot;
+	METRICS.TakeSnapshot(snapshot);
+
+	Metrics::sSnapshot interval;
+	Metrics::GetInterval(snapshot, m_MetricsSnapshot, interval);
+
+	QByteArray line;
+	Metrics::GetCSVLine(interval, QDateTime::currentMSecsSinceEpoch(), line);
+	m_MetricsFile.write(line);
+	m_MetricsFile.flush();
+
+	m_MetricsSnapshot = snapshot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool HeadlessHost::EngineClient_Tick()
+{
+	bool active = FlushLog();
+	UpdateMetrics();
+
+	return active;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void HeadlessHost::onTimeout()
+{
+	qint64 now = Utils::GetTimeNS();
+	if(sm_Interrupted || (m_Settings.seconds>0 && now-m_StartNS>=m_Settings.seconds*Q_INT64_C(1000000000)))
+	{
+		m_Timer.stop();
+		QCoreApplication::quit();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void HeadlessHost::PrintSummary()
+{
+	Metrics::sSnapshot snapshot;
+	METRICS.TakeSnapshot(snapshot);
+
+	Metrics::sSnapshot total;
+	Metrics::GetInterval(snapshot, m_StartSnapshot, total);
+
+	double seconds = qMax(total.timeNS*0.000000001, 0.001);
+	quint64 sent = (total.counters[Metrics::COUNTER_UDP_OUT_PACKETS] + total.counters[Metrics::COUNTER_TCP_OUT_PACKETS]);
+	quint64 recv = (total.counters[Metrics::COUNTER_UDP_IN_PACKETS] + total.counters[Metrics::COUNTER_TCP_IN_PACKETS]);
+
+	printf("\n%.1f seconds\n", seconds);
+	printf("sent     %llu packets (%.0f packets/s)\n", static_cast<unsigned long long>(sent), sent/seconds);
+	printf("received %llu packets (%.0f packets/s)\n", static_cast<unsigned long long>(recv), recv/seconds);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,99 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef HEADLESS_HOST_H
+#define HEADLESS_HOST_H
+
+#ifndef ENGINE_H
+#include "Engine.h"
+#endif
+
+#ifndef LOG_RECORD_H
+#include "LogRecord.h"
+#endif
+
+#ifndef LOG_FILE_H
+#include "LogFile.h"
+#endif
+
+#include <signal.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// runs a show file on an Engine with its toys hidden and no display needed:
+// generators, /local loopback and feedback dispatch all run as they would in
+// the app, the log goes to stdout and optionally a log file, metrics
+// optionally to a csv file
+class HeadlessHost
+	: public QObject
+	, private Engine::Client
+{
+	Q_OBJECT
+
+public:
+	struct sSettings
+	{
+		sSettings();
+
+		QString	showPath;
+		int		seconds;	// 0 = until interrupted
+		QString	logPath;
+		QString	metricsPath;
+		bool	verbose;	// debug, send and recv messages on stdout too
+	};
+
+	HeadlessHost(const sSettings &settings);
+	virtual ~HeadlessHost();
+
+	virtual bool Start();
+	virtual void Stop();
+	virtual void PrintSummary();
+
+	static void Interrupt() {sm_Interrupted = 1;}
+
+private slots:
+	void onTimeout();
+
+private:
+	sSettings			m_Settings;
+	EosLog				m_Log;
+	EosLog::LOG_Q		m_TempLogQ;
+	LOG_RECORD_Q		m_LogRecordQ;
+	LogRecordFormatter	m_LogFormatter;
+	LogFile				m_LogFile;
+	Engine				*m_Engine;
+	QFile				m_MetricsFile;
+	QTimer				m_Timer;
+	Metrics::sSnapshot	m_MetricsSnapshot;
+	Metrics::sSnapshot	m_StartSnapshot;
+	qint64				m_StartNS;
+
+	static volatile sig_atomic_t sm_Interrupted;
+
+	virtual bool LoadShow();
+	virtual bool FlushLog();
+	virtual void UpdateMetrics();
+	virtual bool EngineClient_Tick();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "EosTimer.h"
+#include "QtInclude.h"
+#include "HeadlessHost.h"
+#include "AnimationDriver.h"
+#include "Metrics.h"
+#include "Utils.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void OnInterrupt(int /*sig*/)
+{
+	HeadlessHost::Interrupt();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+	srand( static_cast<unsigned int>(time(0)) );
+
+	EosTimer::Init();
+
+	// toys are still widgets owned by the engine, so this is a full gui application
+	// linking QtGui and QtWidgets; the offscreen platform only spares a window server,
+	// and hidden toys never paint
+	if( !qEnvironmentVariableIsSet("QT_QPA_PLATFORM") )
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QApplication app(argc, argv);
+	app.setApplicationName("OSCWidgetsHeadless");
+	app.setQuitOnLastWindowClosed(false);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Runs an OSCWidgets show file without the main window.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("show", "OSCWidgets show file.");
+
+	QCommandLineOption secondsOption("seconds", "Run time, 0 runs until interrupted.", "s", "0");
+	QCommandLineOption logOption("log", "Also write the log to a rotating log file.", "file");
+	QCommandLineOption metricsOption("metrics", "Export metrics every second to a csv file.", "file");
+	QCommandLineOption verboseOption("verbose", "Print debug, send and recv log messages.");
+	QCommandLineOption probesOption("latency-probes", "Record latency probes and answer load generator echoes.");
+	parser.addOption(secondsOption);
+	parser.addOption(logOption);
+	parser.addOption(metricsOption);
+	parser.addOption(verboseOption);
+	parser.addOption(probesOption);
+	parser.process(app);
+
+	QStringList args = parser.positionalArguments();
+	if(args.size() != 1)
+		parser.showHelp(1);
+
+	HeadlessHost::sSettings settings;
+	settings.showPath = QFileInfo(args[0]).absoluteFilePath();
+	settings.seconds = parser.value(secondsOption).toInt();
+	settings.logPath = parser.value(logOption);
+	settings.metricsPath = parser.value(metricsOption);
+	settings.verbose = parser.isSet(verboseOption);
+
+	Metrics::Instantiate();
+	METRICS.SetLatencyProbes( parser.isSet(probesOption) );
+	PixmapCache::Instantiate();
+	AnimationDriver::Instantiate();
+
+	int result = 1;
+	{
+		HeadlessHost host(settings);
+		if( host.Start() )
+		{
+			signal(SIGINT, OnInterrupt);
+			signal(SIGTERM, OnInterrupt);
+
+			result = app.exec();
+			host.Stop();
+			host.PrintSummary();
+		}
+	}
+
+	AnimationDriver::Shutdown();
+	PixmapCache::Shutdown();
+	Metrics::Shutdown();
+
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,471 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ConsoleStandIn.h"
+#include "Engine.h"
+#include "Utils.h"
+#include "ToyMath.h"
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define FEEDBACK_PATH		"/eos/out/bench"
+#define MAX_CATCH_UP_TICKS	10
+
+volatile sig_atomic_t ConsoleStandIn::sm_Interrupted = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleStandIn::sSettings::sSettings()
+	: tcp(false)
+	, frameMode(OSCStream::FRAME_MODE_1_1)
+	, port(8000)
+	, replyPort(8001)
+	, addresses(100)
+	, rate(30)
+	, labels(0)
+	, wildcard(false)
+	, seconds(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleStandIn::ConsoleStandIn(const sSettings &settings)
+	: m_Settings(settings)
+	, m_TcpServer(0)
+	, m_TcpSocket(0)
+	, m_OSCStream(0)
+	, m_UdpSocket(0)
+	, m_ReplyAddr(QHostAddress::LocalHost)
+	, m_StartNS(0)
+	, m_NextTickNS(0)
+	, m_Tick(0)
+	, m_SentPackets(0)
+	, m_SentBytes(0)
+	, m_RecvPackets(0)
+	, m_RecvBytes(0)
+	, m_EchoSentNS(ECHO_SLOTS, 0)
+	, m_EchoesSent(0)
+{
+	m_Settings.addresses = qMax(0, m_Settings.addresses);
+	m_Settings.labels = qMax(0, m_Settings.labels);
+	m_Settings.rate = qBound(0.1, m_Settings.rate, 10000.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ConsoleStandIn::~ConsoleStandIn()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ConsoleStandIn::Start()
+{
+	Stop();
+
+	if( !m_Settings.recordPath.isEmpty() )
+	{
+		if( !m_Capture.StartFile(m_Settings.recordPath) )
+		{
+			printf("unable to open capture file \"%s\"\n", m_Settings.recordPath.toUtf8().constData());
+			return false;
+		}
+	}
+
+	if( m_Settings.tcp )
+	{
+		m_TcpServer = new QTcpServer(this);
+		connect(m_TcpServer, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+		if( !m_TcpServer->listen(QHostAddress::LocalHost,m_Settings.port) )
+		{
+			printf("unable to listen on tcp port %u: %s\n", static_cast<unsigned int>(m_Settings.port), m_TcpServer->errorString().toUtf8().constData());
+			Stop();
+			return false;
+		}
+
+		printf("listening on tcp 127.0.0.1:%u, OSC %s framing\n", static_cast<unsigned int>(m_Settings.port), (m_Settings.frameMode==OSCStream::FRAME_MODE_1_0) ? "1.0" : "1.1");
+	}
+	else
+	{
+		m_UdpSocket = new QUdpSocket(this);
+		connect(m_UdpSocket, SIGNAL(readyRead()), this, SLOT(onUdpReadyRead()));
+		if( !m_UdpSocket->bind(QHostAddress::LocalHost,m_Settings.port) )
+		{
+			printf("unable to bind udp port %u: %s\n", static_cast<unsigned int>(m_Settings.port), m_UdpSocket->errorString().toUtf8().constData());
+			Stop();
+			return false;
+		}
+
+		m_Peer = PacketCapture::MakePeer(PacketCapture::TRANSPORT_UDP, m_ReplyAddr, m_Settings.replyPort);
+		printf("listening on udp 127.0.0.1:%u, feedback to port %u\n", static_cast<unsigned int>(m_Settings.port), static_cast<unsigned int>(m_Settings.replyPort));
+	}
+
+	printf("feedback: %d addresses + %d labels at %g Hz%s\n", m_Settings.addresses, m_Settings.labels, m_Settings.rate, m_Settings.wildcard ? ", wildcard paths" : "");
+
+	m_StartNS = m_NextTickNS = Utils::GetTimeNS();
+
+	// half the tick period, so late timers catch up on the next event
+	int intervalMS = qMax(1, static_cast<int>(500.0/m_Settings.rate));
+	m_Timer.start(intervalMS, Qt::PreciseTimer, this);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::Stop()
+{
+	m_Timer.stop();
+
+	if( m_TcpSocket )
+	{
+		m_TcpSocket->disconnect(this);
+		m_TcpSocket->abort();
+		m_TcpSocket->deleteLater();
+		m_TcpSocket = 0;
+	}
+
+	if( m_OSCStream )
+	{
+		delete m_OSCStream;
+		m_OSCStream = 0;
+	}
+
+	if( m_TcpServer )
+	{
+		m_TcpServer->close();
+		m_TcpServer->deleteLater();
+		m_TcpServer = 0;
+	}
+
+	if( m_UdpSocket )
+	{
+		m_UdpSocket->close();
+		m_UdpSocket->deleteLater();
+		m_UdpSocket = 0;
+	}
+
+	m_Capture.Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::SendTick()
+{
+	SendEcho();
+
+	// every address sweeps 0..100 once every two seconds, phase shifted by index
+	double t = (m_Tick / m_Settings.rate);
+	for(int i=0; i<m_Settings.addresses; i++)
+	{
+		double phase = (t*0.5 + i/static_cast<double>(m_Settings.addresses));
+		float value = static_cast<float>(50.0 + 50.0*sin(phase*TWO_PI));
+
+		if( m_Settings.wildcard )
+		{
+			// no argument, the last path element is the value (see Toys::Recv)
+			OSCPacketWriter packetWriter( QString(FEEDBACK_PATH "/%1/%2").arg(i).arg(qRound(value)).toUtf8().constData() );
+			Send(packetWriter);
+		}
+		else
+		{
+			OSCPacketWriter packetWriter( QString(FEEDBACK_PATH "/%1").arg(i).toUtf8().constData() );
+			packetWriter.AddFloat32(value);
+			Send(packetWriter);
+		}
+	}
+
+	for(int i=0; i<m_Settings.labels; i++)
+	{
+		OSCPacketWriter packetWriter( QString(FEEDBACK_PATH "/label/%1").arg(i).toUtf8().constData() );
+		packetWriter.AddString( QString("Label %1").arg(m_Tick).toUtf8().constData() );
+		Send(packetWriter);
+	}
+
+	m_Tick++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::SendEcho()
+{
+	// sent ahead of the tick's feedback, so the reply waits behind all of it
+	m_EchoSentNS[m_Tick % ECHO_SLOTS] = Utils::GetTimeNS();
+
+	OSCPacketWriter packetWriter(ENGINE_ECHO_PATH);
+	packetWriter.AddString( QByteArray::number(m_Tick).constData() );
+	Send(packetWriter);
+	m_EchoesSent++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::Send(OSCPacketWriter &packetWriter)
+{
+	size_t size = 0;
+	char *packet = packetWriter.Create(size);
+	if( !packet )
+		return;
+
+	bool sent = false;
+
+	if( m_UdpSocket )
+	{
+		sent = (m_UdpSocket->writeDatagram(packet,static_cast<qint64>(size),m_ReplyAddr,m_Settings.replyPort) == static_cast<qint64>(size));
+	}
+	else if( m_TcpSocket )
+	{
+		size_t frameSize = size;
+		char *frame = OSCStream::CreateFrame(m_Settings.frameMode, packet, frameSize);
+		if( frame )
+		{
+			sent = (m_TcpSocket->write(frame,static_cast<qint64>(frameSize)) == static_cast<qint64>(frameSize));
+			delete[] frame;
+		}
+	}
+
+	if( sent )
+	{
+		// recorded from OSCWidgets' point of view, so feedback replays as inbound
+		m_Capture.Add(PacketCapture::DIRECTION_IN, m_Peer, packet, size);
+		m_SentPackets++;
+		m_SentBytes += size;
+	}
+
+	delete[] packet;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::Recv(char *data, size_t size)
+{
+	RecvEcho(data, size);
+
+	m_Capture.Add(PacketCapture::DIRECTION_OUT, m_Peer, data, size);
+	m_RecvPackets++;
+	m_RecvBytes += size;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::RecvEcho(char *data, size_t size)
+{
+	const size_t pathSize = sizeof(ENGINE_ECHO_REPLY_PATH);
+	if(size<pathSize || memcmp(data,ENGINE_ECHO_REPLY_PATH,pathSize)!=0)
+		return;
+
+	qint64 now = Utils::GetTimeNS();
+
+	size_t argCount = 0xffffffff;
+	OSCArgument *args = OSCArgument::GetArgs(data, size, argCount);
+	if( !args )
+		return;
+
+	std::string str;
+	if(argCount>0 && args[0].GetString(str))
+	{
+		bool ok = false;
+		quint64 tick = QByteArray(str.c_str()).toULongLong(&ok);
+
+		// a slot reused by a newer request means this reply is too late to count
+		if(ok && tick<m_Tick && m_Tick-tick<=ECHO_SLOTS)
+		{
+			qint64 &sentNS = m_EchoSentNS[tick % ECHO_SLOTS];
+			if(sentNS != 0)
+			{
+				m_EchoLatencyUS.Add((now - sentNS) / 1000);
+				sentNS = 0;
+			}
+		}
+	}
+
+	delete[] args;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::timerEvent(QTimerEvent *event)
+{
+	if(event->timerId() != m_Timer.timerId())
+	{
+		QObject::timerEvent(event);
+		return;
+	}
+
+	qint64 now = Utils::GetTimeNS();
+
+	if(sm_Interrupted || (m_Settings.seconds>0 && now-m_StartNS>=m_Settings.seconds*Q_INT64_C(1000000000)))
+	{
+		m_Timer.stop();
+		QCoreApplication::quit();
+		return;
+	}
+
+	qint64 periodNS = static_cast<qint64>(1000000000.0/m_Settings.rate);
+	for(int i=0; m_NextTickNS<=now; i++)
+	{
+		if(i >= MAX_CATCH_UP_TICKS)
+		{
+			// too far behind, drop the missed ticks rather than bursting
+			m_NextTickNS = (now + periodNS);
+			break;
+		}
+
+		SendTick();
+		m_NextTickNS += periodNS;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::onNewConnection()
+{
+	QTcpSocket *socket = m_TcpServer->nextPendingConnection();
+	if( !socket )
+		return;
+
+	if( m_TcpSocket )
+	{
+		// one client at a time, like a console session
+		printf("refused tcp connection from %s:%u\n", socket->peerAddress().toString().toUtf8().constData(), static_cast<unsigned int>(socket->peerPort()));
+		socket->abort();
+		socket->deleteLater();
+		return;
+	}
+
+	m_TcpSocket = socket;
+	m_TcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	connect(m_TcpSocket, SIGNAL(readyRead()), this, SLOT(onTcpReadyRead()));
+	connect(m_TcpSocket, SIGNAL(disconnected()), this, SLOT(onTcpDisconnected()));
+	m_OSCStream = new OSCStream(m_Settings.frameMode);
+	m_Peer = PacketCapture::MakePeer(PacketCapture::TRANSPORT_TCP, m_TcpSocket->peerAddress(), m_TcpSocket->peerPort());
+	printf("tcp client connected from %s:%u\n", m_TcpSocket->peerAddress().toString().toUtf8().constData(), static_cast<unsigned int>(m_TcpSocket->peerPort()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::onTcpReadyRead()
+{
+	if(!m_TcpSocket || !m_OSCStream)
+		return;
+
+	QByteArray data( m_TcpSocket->readAll() );
+	m_OSCStream->Add(data.constData(), static_cast<size_t>(data.size()));
+
+	for(;;)
+	{
+		size_t size = 0;
+		char *frame = m_OSCStream->GetNextFrame(size);
+		if( !frame )
+			break;
+
+		if(size != 0)
+			Recv(frame, size);
+		delete[] frame;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::onTcpDisconnected()
+{
+	printf("tcp client disconnected\n");
+
+	if( m_TcpSocket )
+	{
+		m_TcpSocket->deleteLater();
+		m_TcpSocket = 0;
+	}
+
+	if( m_OSCStream )
+	{
+		delete m_OSCStream;
+		m_OSCStream = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::onUdpReadyRead()
+{
+	QByteArray data;
+	QHostAddress addr;
+	quint16 port = 0;
+
+	while( m_UdpSocket->hasPendingDatagrams() )
+	{
+		data.resize( static_cast<int>(m_UdpSocket->pendingDatagramSize()) );
+		qint64 size = m_UdpSocket->readDatagram(data.data(), data.size(), &addr, &port);
+		if(size <= 0)
+			continue;
+
+		// feedback follows whoever is talking to us
+		if(addr != m_ReplyAddr)
+		{
+			m_ReplyAddr = addr;
+			m_Peer = PacketCapture::MakePeer(PacketCapture::TRANSPORT_UDP, m_ReplyAddr, m_Settings.replyPort);
+		}
+
+		Recv(data.data(), static_cast<size_t>(size));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ConsoleStandIn::PrintSummary()
+{
+	double seconds = ((Utils::GetTimeNS() - m_StartNS) * 0.000000001);
+	if(seconds <= 0)
+		return;
+
+	printf("\n%.1f seconds, %llu feedback ticks\n", seconds, static_cast<unsigned long long>(m_Tick));
+	printf("sent     %llu packets, %llu bytes (%.0f packets/s)\n", static_cast<unsigned long long>(m_SentPackets), static_cast<unsigned long long>(m_SentBytes), m_SentPackets/seconds);
+	printf("received %llu packets, %llu bytes (%.0f packets/s)\n", static_cast<unsigned long long>(m_RecvPackets), static_cast<unsigned long long>(m_RecvBytes), m_RecvPackets/seconds);
+
+	printf("echo     %llu of %llu replied", static_cast<unsigned long long>(m_EchoLatencyUS.count), static_cast<unsigned long long>(m_EchoesSent));
+	if(m_EchoLatencyUS.count != 0)
+	{
+		// log2 buckets, so percentiles are the upper bound of their bucket
+		printf(", round trip us: p50 <=%lld, p90 <=%lld, p99 <=%lld, max %lld",
+			static_cast<long long>(m_EchoLatencyUS.GetPercentile(0.5)),
+			static_cast<long long>(m_EchoLatencyUS.GetPercentile(0.9)),
+			static_cast<long long>(m_EchoLatencyUS.GetPercentile(0.99)),
+			static_cast<long long>(m_EchoLatencyUS.max));
+	}
+	else if(m_EchoesSent != 0)
+		printf(" (turn on latency probes in OSCWidgets)");
+	printf("\n");
+
+	if( !m_Settings.recordPath.isEmpty() )
+	{
+		quint64 packets = 0;
+		quint64 bytes = 0;
+		quint64 dropped = 0;
+		m_Capture.GetStats(packets, bytes, dropped);
+		printf("recorded %llu packets to \"%s\"", static_cast<unsigned long long>(packets), m_Settings.recordPath.toUtf8().constData());
+		if(dropped != 0)
+			printf(", %llu dropped", static_cast<unsigned long long>(dropped));
+		printf("\n");
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,125 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef CONSOLE_STAND_IN_H
+#define CONSOLE_STAND_IN_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#ifndef OSC_PARSER_H
+#include "OSCParser.h"
+#endif
+
+#ifndef PACKET_CAPTURE_H
+#include "PacketCapture.h"
+#endif
+
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+#include <vector>
+#include <signal.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// stands in for a console on localhost: accepts OSCWidgets over tcp or udp,
+// streams synthetic feedback at a fixed rate, and times each tick's echo;
+// OSCWidgets only answers echoes with latency probes on
+// request until OSCWidgets replies with the same sequence number
+class ConsoleStandIn
+	: public QObject
+{
+	Q_OBJECT
+
+public:
+	enum EnumConstants
+	{
+		ECHO_SLOTS	= 1024	// echo requests still awaiting a reply, older ones count as lost
+	};
+
+	struct sSettings
+	{
+		sSettings();
+
+		bool						tcp;
+		OSCStream::EnumFrameMode	frameMode;
+		quint16						port;		// tcp listen or udp input
+		quint16						replyPort;	// udp feedback destination
+		int							addresses;	// feedback addresses per tick
+		double						rate;		// ticks per second
+		int							labels;		// label changes per tick
+		bool						wildcard;	// argument-less paths, for wildcard tables
+		int							seconds;	// 0 = until interrupted
+		QString						recordPath;
+	};
+
+	ConsoleStandIn(const sSettings &settings);
+	virtual ~ConsoleStandIn();
+
+	virtual bool Start();
+	virtual void Stop();
+	virtual void PrintSummary();
+
+	static void Interrupt() {sm_Interrupted = 1;}
+
+protected:
+	sSettings					m_Settings;
+	QTcpServer					*m_TcpServer;
+	QTcpSocket					*m_TcpSocket;
+	OSCStream					*m_OSCStream;
+	QUdpSocket					*m_UdpSocket;
+	QHostAddress				m_ReplyAddr;
+	QBasicTimer					m_Timer;
+	PacketCapture				m_Capture;
+	PacketCapture::sPeer		m_Peer;
+	qint64						m_StartNS;
+	qint64						m_NextTickNS;
+	quint64						m_Tick;
+	quint64						m_SentPackets;
+	quint64						m_SentBytes;
+	quint64						m_RecvPackets;
+	quint64						m_RecvBytes;
+	std::vector<qint64>			m_EchoSentNS;	// by tick % ECHO_SLOTS, 0 once replied
+	quint64						m_EchoesSent;
+	Metrics::sHistogram			m_EchoLatencyUS;
+
+	static volatile sig_atomic_t sm_Interrupted;
+
+	virtual void SendTick();
+	virtual void SendEcho();
+	virtual void Send(OSCPacketWriter &packetWriter);
+	virtual void Recv(char *data, size_t size);
+	virtual void RecvEcho(char *data, size_t size);
+	virtual void timerEvent(QTimerEvent *event);
+
+private slots:
+	void onNewConnection();
+	void onTcpReadyRead();
+	void onTcpDisconnected();
+	void onUdpReadyRead();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,31 @@
+# Console stand-in and synthetic feedback generator for load testing
+# OSCWidgets on one machine, built from the app sources.
+#
+#   mkdir build-loadgen && cd build-loadgen
+#   qmake ../LoadGen/LoadGen.pro && make
+#   ./OSCLoadGen --help
+
+APP_ROOT = $$PWD/..
+include($$APP_ROOT/OSCWidgets.pro)
+
+TARGET = OSCLoadGen
+CONFIG += console
+CONFIG -= app_bundle
+
+# app paths are relative to the app project, and main() is our own
+defineReplace(appPaths) {
+    result =
+    for(file, 1) {
+        !equals(file, OSCWidgets/main.cpp): result += $$APP_ROOT/$$file
+    }
+    return($$result)
+}
+
+HEADERS = $$appPaths($$HEADERS)
+SOURCES = $$appPaths($$SOURCES)
+OBJECTIVE_SOURCES = $$appPaths($$OBJECTIVE_SOURCES)
+RESOURCES = $$appPaths($$RESOURCES)
+INCLUDEPATH = $$appPaths($$INCLUDEPATH)
+
+HEADERS += ConsoleStandIn.h
+SOURCES += ConsoleStandIn.cpp main.cpp
@@ -0,0 +1,93 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdio.h>
+#include "EosTimer.h"
+#include "QtInclude.h"
+#include "ConsoleStandIn.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void OnInterrupt(int /*sig*/)
+{
+	ConsoleStandIn::Interrupt();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char* argv[])
+{
+	EosTimer::Init();
+
+	QCoreApplication app(argc, argv);
+	app.setApplicationName("OSCLoadGen");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Stands in for a console on localhost and streams synthetic OSC feedback to OSCWidgets.");
+	parser.addHelpOption();
+
+	QCommandLineOption tcpOption("tcp", "Accept a tcp connection instead of udp.");
+	QCommandLineOption frameOption("frame", "TCP framing, 1.0 (packet length) or 1.1 (SLIP).", "version", "1.1");
+	QCommandLineOption portOption("port", "TCP listen port or UDP input port.", "port");
+	QCommandLineOption replyPortOption("reply-port", "UDP feedback port.", "port", "8001");
+	QCommandLineOption addressesOption("addresses", "Feedback addresses per tick.", "n", "100");
+	QCommandLineOption rateOption("rate", "Feedback ticks per second.", "hz", "30");
+	QCommandLineOption labelsOption("labels", "Label strings changed per tick.", "n", "0");
+	QCommandLineOption wildcardOption("wildcard", "Send argument-less feedback paths, for wildcard tables.");
+	QCommandLineOption secondsOption("seconds", "Run time, 0 runs until interrupted.", "s", "0");
+	QCommandLineOption recordOption("record", "Record all traffic to an OSCWidgets capture file.", "file");
+	parser.addOption(tcpOption);
+	parser.addOption(frameOption);
+	parser.addOption(portOption);
+	parser.addOption(replyPortOption);
+	parser.addOption(addressesOption);
+	parser.addOption(rateOption);
+	parser.addOption(labelsOption);
+	parser.addOption(wildcardOption);
+	parser.addOption(secondsOption);
+	parser.addOption(recordOption);
+	parser.process(app);
+
+	ConsoleStandIn::sSettings settings;
+	settings.tcp = parser.isSet(tcpOption);
+	settings.frameMode = ((parser.value(frameOption) == "1.0") ? OSCStream::FRAME_MODE_1_0 : OSCStream::FRAME_MODE_1_1);
+	settings.port = (parser.isSet(portOption) ? parser.value(portOption).toUShort() : (settings.tcp ? 3032 : 8000));
+	settings.replyPort = parser.value(replyPortOption).toUShort();
+	settings.addresses = parser.value(addressesOption).toInt();
+	settings.rate = parser.value(rateOption).toDouble();
+	settings.labels = parser.value(labelsOption).toInt();
+	settings.wildcard = parser.isSet(wildcardOption);
+	settings.seconds = parser.value(secondsOption).toInt();
+	settings.recordPath = parser.value(recordOption);
+
+	ConsoleStandIn standIn(settings);
+	if( !standIn.Start() )
+		return 1;
+
+	signal(SIGINT, OnInterrupt);
+	signal(SIGTERM, OnInterrupt);
+
+	int result = app.exec();
+	standIn.Stop();
+	standIn.PrintSummary();
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
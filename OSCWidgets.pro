@@ -7,19 +7,31 @@ QT += network
 CONFIG += c++11
 
 HEADERS = \
+   OSCWidgets/AnimationDriver.h \
+   OSCWidgets/Clock.h \
    OSCWidgets/EditPanel.h \
+   OSCWidgets/Engine.h \
    OSCWidgets/EosPlatform.h \
    OSCWidgets/FadeButton.h \
+   OSCWidgets/GeneratorBank.h \
    OSCWidgets/LogFile.h \
+   OSCWidgets/LogRecord.h \
    OSCWidgets/LogWidget.h \
    OSCWidgets/MainWindow.h \
+   OSCWidgets/Metrics.h \
+   OSCWidgets/MetricsPanel.h \
    OSCWidgets/NetworkThreads.h \
+   OSCWidgets/OutputFilter.h \
+   OSCWidgets/PacketCapture.h \
+   OSCWidgets/PacketReplay.h \
+   OSCWidgets/PixmapLoader.h \
    OSCWidgets/QtInclude.h \
    OSCWidgets/resource.h \
    OSCWidgets/SettingsPanel.h \
    OSCWidgets/Toy.h \
    OSCWidgets/ToyActivity.h \
    OSCWidgets/ToyButton.h \
+   OSCWidgets/ToyCellView.h \
    OSCWidgets/ToyCmd.h \
    OSCWidgets/ToyEncoder.h \
    OSCWidgets/ToyFlicker.h \
@@ -34,6 +46,7 @@ HEADERS = \
    OSCWidgets/ToyWidget.h \
    OSCWidgets/ToyWindow.h \
    OSCWidgets/ToyXY.h \
+   OSCWidgets/Trace.h \
    OSCWidgets/Utils.h \
    EosSyncLib/EosSyncLib/EosLog.h \
    EosSyncLib/EosSyncLib/EosOsc.h \
@@ -44,18 +57,30 @@ HEADERS = \
    EosSyncLib/EosSyncLib/OSCParser.h
 
 SOURCES = \
+   OSCWidgets/AnimationDriver.cpp \
+   OSCWidgets/Clock.cpp \
    OSCWidgets/EditPanel.cpp \
+   OSCWidgets/Engine.cpp \
    OSCWidgets/EosPlatform.cpp \
    OSCWidgets/FadeButton.cpp \
+   OSCWidgets/GeneratorBank.cpp \
    OSCWidgets/LogFile.cpp \
+   OSCWidgets/LogRecord.cpp \
    OSCWidgets/LogWidget.cpp \
    OSCWidgets/main.cpp \
    OSCWidgets/MainWindow.cpp \
+   OSCWidgets/Metrics.cpp \
+   OSCWidgets/MetricsPanel.cpp \
    OSCWidgets/NetworkThreads.cpp \
+   OSCWidgets/OutputFilter.cpp \
+   OSCWidgets/PacketCapture.cpp \
+   OSCWidgets/PacketReplay.cpp \
+   OSCWidgets/PixmapLoader.cpp \
    OSCWidgets/SettingsPanel.cpp \
    OSCWidgets/Toy.cpp \
    OSCWidgets/ToyActivity.cpp \
    OSCWidgets/ToyButton.cpp \
+   OSCWidgets/ToyCellView.cpp \
    OSCWidgets/ToyCmd.cpp \
    OSCWidgets/ToyEncoder.cpp \
    OSCWidgets/ToyFlicker.cpp \
@@ -69,6 +94,7 @@ SOURCES = \
    OSCWidgets/ToyWidget.cpp \
    OSCWidgets/ToyWindow.cpp \
    OSCWidgets/ToyXY.cpp \
+   OSCWidgets/Trace.cpp \
    OSCWidgets/Utils.cpp \
    EosSyncLib/EosSyncLib/EosLog.cpp \
    EosSyncLib/EosSyncLib/EosOsc.cpp \
@@ -124,3 +150,8 @@ INCLUDEPATH = \
 
 #DEFINES = 
 
+
+# timeline tracing, build with: qmake CONFIG+=trace
+trace {
+    DEFINES += OSCWIDGETS_TRACE
+}
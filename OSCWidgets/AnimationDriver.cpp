@@ -0,0 +1,250 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "AnimationDriver.h"
+#include "Utils.h"
+#include "Metrics.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+AnimationDriver *AnimationDriver::sm_Instance = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+AnimationDriver::AnimationDriver()
+	: m_Ticking(false)
+	, m_AvgPaintNS(0)
+	, m_StatsPaints(0)
+	, m_StatsPaintNS(0)
+{
+	m_StatsStartNS = Utils::GetTimeNS();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+AnimationDriver::~AnimationDriver()
+{
+	m_Timer.stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::Start(Client *client)
+{
+	if( !client )
+		return;
+
+	for(CLIENTS::const_iterator i=m_Clients.begin(); i!=m_Clients.end(); i++)
+	{
+		if(*i == client)
+			return;
+	}
+
+	m_Clients.push_back(client);
+
+	if( !m_Timer.isActive() )
+		m_Timer.start(FRAME_MS, this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::Stop(Client *client)
+{
+	for(CLIENTS::iterator i=m_Clients.begin(); i!=m_Clients.end(); i++)
+	{
+		if(*i == client)
+		{
+			// clients may stop, or be deleted, from within their own tick
+			if( m_Ticking )
+				*i = 0;
+			else
+				m_Clients.erase(i);
+			break;
+		}
+	}
+
+	if(!m_Ticking && m_Clients.empty() && m_Dirty.empty())
+		m_Timer.stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t AnimationDriver::GetActiveCount() const
+{
+	size_t count = 0;
+	for(CLIENTS::const_iterator i=m_Clients.begin(); i!=m_Clients.end(); i++)
+	{
+		if( *i )
+			count++;
+	}
+	return count;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::Invalidate(QWidget *widget)
+{
+	if(widget && m_Dirty.insert(widget).second)
+	{
+		m_DirtyQ.push_back(widget);
+
+		if( !m_Timer.isActive() )
+			m_Timer.start(FRAME_MS, this);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::CancelInvalidate(QWidget *widget)
+{
+	// stale queue entries are skipped when flushed
+	m_Dirty.erase(widget);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::AddPaint(qint64 ns)
+{
+	if(ns < 0)
+		ns = 0;
+
+	METRICS.Record(Metrics::HISTOGRAM_PAINT_US, ns/1000);
+
+	m_AvgPaintNS += ((ns - m_AvgPaintNS) / 16);
+	m_StatsPaints++;
+	m_StatsPaintNS += ns;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const AnimationDriver::sPaintStats& AnimationDriver::GetPaintStats()
+{
+	UpdatePaintStats( Utils::GetTimeNS() );
+	return m_PaintStats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::UpdatePaintStats(qint64 nowNS)
+{
+	qint64 elapsedNS = (nowNS - m_StatsStartNS);
+	if(elapsedNS >= 1000000000)
+	{
+		double scale = (1000000000.0 / elapsedNS);
+		m_PaintStats.paintsPerSec = static_cast<unsigned int>( qRound(m_StatsPaints * scale) );
+		m_PaintStats.paintMSPerSec = static_cast<float>(m_StatsPaintNS * scale * 0.000001);
+		m_PaintStats.avgPaintUS = ((m_StatsPaints==0) ? 0 : static_cast<float>(m_StatsPaintNS/(m_StatsPaints*1000.0)));
+		m_StatsStartNS = nowNS;
+		m_StatsPaints = 0;
+		m_StatsPaintNS = 0;
+	}
+
+	m_PaintStats.dirty = static_cast<unsigned int>( m_Dirty.size() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::FlushDirty()
+{
+	// limit the repaints issued per frame to what fits in the paint budget,
+	// the remainder keeps its place in line for the next frame
+	size_t budget = m_DirtyQ.size();
+	if(m_AvgPaintNS > 0)
+	{
+		qint64 fit = ((FRAME_BUDGET_MS*1000000) / m_AvgPaintNS);
+		if(fit < static_cast<qint64>(budget))
+			budget = static_cast<size_t>( qMax(fit,static_cast<qint64>(1)) );
+	}
+
+	size_t n = 0;
+	size_t painted = 0;
+	while(n<m_DirtyQ.size() && painted<budget)
+	{
+		QWidget *widget = m_DirtyQ[n++];
+		if(m_Dirty.erase(widget) != 0)
+		{
+			widget->update();
+			painted++;
+		}
+	}
+
+	m_DirtyQ.erase(m_DirtyQ.begin(), m_DirtyQ.begin()+n);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::timerEvent(QTimerEvent *event)
+{
+	if(event->timerId() != m_Timer.timerId())
+	{
+		QObject::timerEvent(event);
+		return;
+	}
+
+	m_Ticking = true;
+
+	// clients started during the tick are appended, and first ticked next frame
+	size_t count = m_Clients.size();
+	for(size_t i=0; i<count; i++)
+	{
+		Client *client = m_Clients[i];
+		if(client && !client->AnimationClient_Tick())
+			m_Clients[i] = 0;
+	}
+
+	m_Ticking = false;
+
+	size_t n = 0;
+	for(size_t i=0; i<m_Clients.size(); i++)
+	{
+		if( m_Clients[i] )
+			m_Clients[n++] = m_Clients[i];
+	}
+	m_Clients.resize(n);
+
+	FlushDirty();
+
+	if(m_Clients.empty() && m_Dirty.empty())
+	{
+		m_DirtyQ.clear();
+		m_Timer.stop();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::Instantiate()
+{
+	if( !sm_Instance )
+		sm_Instance = new AnimationDriver();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void AnimationDriver::Shutdown()
+{
+	if( sm_Instance )
+	{
+		delete sm_Instance;
+		sm_Instance = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
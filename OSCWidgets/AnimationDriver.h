@@ -0,0 +1,115 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef ANIMATION_DRIVER_H
+#define ANIMATION_DRIVER_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <vector>
+#include <set>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// one frame timer for every widget fade in the app; clients are ticked in a
+// single pass and dropped once they report they are done, and the timer only
+// runs while at least one client is animating or widget is dirty
+//
+// widgets invalidated between frames are repainted together at the end of
+// the next frame, limited to roughly FRAME_BUDGET_MS of measured paint time
+class AnimationDriver
+	: public QObject
+{
+public:
+	enum EnumConstants
+	{
+		FRAME_MS		= 16,
+		FRAME_BUDGET_MS	= 8
+	};
+
+	class Client
+	{
+	public:
+		virtual bool AnimationClient_Tick() = 0;	// return false when finished
+	};
+
+	struct sPaintStats
+	{
+		sPaintStats()
+			: paintsPerSec(0)
+			, paintMSPerSec(0)
+			, avgPaintUS(0)
+			, dirty(0)
+		{}
+
+		unsigned int	paintsPerSec;
+		float			paintMSPerSec;
+		float			avgPaintUS;
+		unsigned int	dirty;
+	};
+
+	AnimationDriver();
+	virtual ~AnimationDriver();
+
+	virtual void Start(Client *client);
+	virtual void Stop(Client *client);
+	virtual size_t GetActiveCount() const;
+	virtual void Invalidate(QWidget *widget);
+	virtual void CancelInvalidate(QWidget *widget);
+	virtual void AddPaint(qint64 ns);
+	virtual const sPaintStats& GetPaintStats();
+
+	static void Instantiate();
+	static void Shutdown();
+	static AnimationDriver& Instance() {return *sm_Instance;}
+
+protected:
+	typedef std::vector<Client*> CLIENTS;
+	typedef std::vector<QWidget*> WIDGETS;
+	typedef std::set<QWidget*> WIDGET_SET;
+
+	QBasicTimer	m_Timer;
+	CLIENTS		m_Clients;	// stopped clients are zeroed during a tick, then compacted
+	bool		m_Ticking;
+	WIDGETS		m_DirtyQ;	// in invalidation order, may hold stale entries
+	WIDGET_SET	m_Dirty;	// authoritative, a widget is only painted if still present
+	qint64		m_AvgPaintNS;
+	qint64		m_StatsStartNS;
+	unsigned int m_StatsPaints;
+	qint64		m_StatsPaintNS;
+	sPaintStats	m_PaintStats;
+
+	virtual void FlushDirty();
+	virtual void UpdatePaintStats(qint64 nowNS);
+	virtual void timerEvent(QTimerEvent *event);
+
+	static AnimationDriver	*sm_Instance;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define ANIM	AnimationDriver::Instance()
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Clock.h"
+#include "Utils.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+static SystemClock sSystemClock;
+
+Clock *Clock::sm_Instance = &sSystemClock;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Clock::SetInstance(Clock *clock)
+{
+	sm_Instance = (clock ? clock : &sSystemClock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 SystemClock::GetTimeNS() const
+{
+	return Utils::GetTimeNS();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int ClockTimer::GetElapsed() const
+{
+	qint64 elapsedNS = (CLOCK.GetTimeNS() - m_StartNS);
+	return ((elapsedNS > 0) ? static_cast<unsigned int>(elapsedNS/1000000) : 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int ClockTimer::Restart()
+{
+	qint64 nowNS = CLOCK.GetTimeNS();
+	if(nowNS < m_StartNS)
+	{
+		// clock was set back or replaced
+		m_StartNS = nowNS;
+		return 0;
+	}
+
+	unsigned int ms = static_cast<unsigned int>((nowNS - m_StartNS)/1000000);
+	m_StartNS += (static_cast<qint64>(ms) * 1000000);
+	return ms;
+}
+
+////////////////////////////////////////////////////////////////////////////////
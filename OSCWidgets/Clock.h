@@ -0,0 +1,99 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// time source for generators and fades, the system clock unless a test or
+// benchmark installs another one before creating toys; gui thread only
+//
+// network threads and metrics always read Utils::GetTimeNS(), so due times
+// handed to ToyClient_SendAt under another clock only make sense to a client
+// that reads the same clock
+class Clock
+{
+public:
+	virtual ~Clock() {}
+
+	virtual qint64 GetTimeNS() const = 0;
+
+	static Clock& Instance() {return *sm_Instance;}
+	static void SetInstance(Clock *clock);	// not owned, 0 restores the system clock
+
+private:
+	static Clock	*sm_Instance;
+};
+
+#define CLOCK	Clock::Instance()
+
+////////////////////////////////////////////////////////////////////////////////
+
+class SystemClock
+	: public Clock
+{
+public:
+	virtual qint64 GetTimeNS() const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// only moves when advanced, so an hour of generator output can run in a loop:
+// advance by the refresh rate, then call the grid's Step
+class VirtualClock
+	: public Clock
+{
+public:
+	VirtualClock(qint64 timeNS=0) : m_TimeNS(timeNS) {}
+
+	virtual qint64 GetTimeNS() const {return m_TimeNS;}
+	virtual void SetTimeNS(qint64 timeNS) {m_TimeNS = timeNS;}
+	virtual void Advance(qint64 ns) {m_TimeNS += ns;}
+	virtual void AdvanceMS(unsigned int ms) {Advance(static_cast<qint64>(ms) * 1000000);}
+
+protected:
+	qint64	m_TimeNS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// EosTimer on the installed clock
+class ClockTimer
+{
+public:
+	ClockTimer() {Start();}
+
+	void Start() {m_StartNS = CLOCK.GetTimeNS();}
+	unsigned int GetElapsed() const;	// ms
+	unsigned int Restart();				// ms, the sub-millisecond remainder carries over
+
+private:
+	qint64	m_StartNS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
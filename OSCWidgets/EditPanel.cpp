@@ -22,6 +22,7 @@
 #include "ToyButton.h"
 #include "ToyMath.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -31,8 +32,13 @@ EditButton::EditButton(QWidget *parent)
 	, m_T(PI_PLUS_PI_2)
 	, m_Alpha(0)
 {
-	m_Timer = new QTimer(this);
-	connect(m_Timer, SIGNAL(timeout()), this, SLOT(onTick()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+EditButton::~EditButton()
+{
+	ANIM.Stop(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -46,12 +52,13 @@ void EditButton::SetSelected(bool selected)
 		if( m_Selected )
 		{
 			m_T = PI_PLUS_PI_2;
-			m_Timer->start(20);
+			m_Timestamp.Start();
+			ANIM.Start(this);
 		}
 		else
 		{
 			m_Alpha = 0;
-			m_Timer->stop();
+			ANIM.Stop(this);
 			update();
 		}
 	}
@@ -61,6 +68,8 @@ void EditButton::SetSelected(bool selected)
 
 void EditButton::paintEvent(QPaintEvent*)
 {
+	TRACE_ZONE("EditButton::paintEvent");
+
 	if(m_Alpha > 0)
 	{
 		QPainter painter(this);
@@ -76,9 +85,10 @@ void EditButton::paintEvent(QPaintEvent*)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void EditButton::onTick()
+bool EditButton::AnimationClient_Tick()
 {
-	m_T += 0.075;
+	// advance at the original 0.075 per 20ms regardless of frame rate
+	m_T += (0.075 * m_Timestamp.Restart()/20.0);
 	qreal opacity = ((1.0 + sin(m_T)) * 0.5);
 	opacity = (0.4 + (opacity*0.6));
 	int alpha = qRound(255 * opacity);
@@ -87,6 +97,8 @@ void EditButton::onTick()
 		m_Alpha = alpha;
 		update();
 	}
+
+	return m_Selected;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -213,6 +225,14 @@ EditPanel::EditPanel(EditPanelClient &client, QWidget *parent)
 	connect(m_BPM, SIGNAL(editingFinished()), this, SLOT(onEditingFinished()));
 	layout->addWidget(m_BPM, row, 1);
 
+	++row;
+	m_SendRateLabel = new QLabel(tr("Send Rate"), this);
+	layout->addWidget(m_SendRateLabel, row, 0);
+	m_SendRate = new QLineEdit(this);
+	SetToolTips(tr("Minimum time between network sends (ms)\n\nBlank = Use Settings\n0 = Send every refresh"), m_SendRateLabel, m_SendRate);
+	connect(m_SendRate, SIGNAL(editingFinished()), this, SLOT(onEditingFinished()));
+	layout->addWidget(m_SendRate, row, 1);
+
 	++row;
 	m_LabelPathLabel = new QLabel(tr("OSC Label"), this);
 	layout->addWidget(m_LabelPathLabel, row, 0);
@@ -794,6 +814,28 @@ void EditPanel::SetBPMEnabled(bool b)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void EditPanel::GetSendRate(QString &n) const
+{
+	n = m_SendRate->text();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EditPanel::SetSendRate(const QString &n)
+{
+	m_SendRate->setText(n);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EditPanel::SetSendRateEnabled(bool b)
+{
+	m_SendRateLabel->setEnabled(b);
+	m_SendRate->setEnabled(b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EditPanel::SetHelpText(const QString &text)
 {
 	m_Help->setText(text);
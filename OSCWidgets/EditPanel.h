@@ -26,30 +26,38 @@
 #include "QtInclude.h"
 #endif
 
+#ifndef EOS_TIMER_H
+#include "EosTimer.h"
+#endif
+
+#ifndef ANIMATION_DRIVER_H
+#include "AnimationDriver.h"
+#endif
+
 class FadeButton;
 
 ////////////////////////////////////////////////////////////////////////////////
 
 class EditButton
 	: public QPushButton
+	, private AnimationDriver::Client
 {
 	Q_OBJECT
 	
 public:
 	EditButton(QWidget *parent);
+	virtual ~EditButton();
 	
 	virtual bool GetSelected() const {return m_Selected;}
 	virtual void SetSelected(bool selected);
 	
-private slots:
-	void onTick();
-	
 protected:
 	bool		m_Selected;
 	int			m_Alpha;
 	qreal		m_T;
-	QTimer		*m_Timer;
+	EosTimer	m_Timestamp;
 	
+	virtual bool AnimationClient_Tick();
 	virtual void paintEvent(QPaintEvent *event);
 };
 
@@ -140,6 +148,9 @@ public:
 	virtual void GetBPM(QString &n) const;
 	virtual void SetBPM(const QString &n);
 	virtual void SetBPMEnabled(bool b);
+	virtual void GetSendRate(QString &n) const;
+	virtual void SetSendRate(const QString &n);
+	virtual void SetSendRateEnabled(bool b);
 	virtual void SetHelpText(const QString &text);
 	
 signals:
@@ -194,6 +205,8 @@ protected:
 	QLineEdit		*m_Max2;
 	QLabel			*m_BPMLabel;
 	QLineEdit		*m_BPM;
+	QLabel			*m_SendRateLabel;
+	QLineEdit		*m_SendRate;
 	QLabel			*m_HiddenLabel;
 	QCheckBox		*m_Hidden;
 	QLabel			*m_Help;
@@ -0,0 +1,525 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Engine.h"
+#include "SettingsPanel.h"
+#include "Utils.h"
+#include "Trace.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+Engine::sNetworkSettings::sNetworkSettings()
+	: mode(OSCStream::FRAME_MODE_INVALID)
+	, ip("127.0.0.1")
+	, port1(8000)
+	, port2(8001)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Engine::Engine(Client &client, EosLog &log, PacketCapture *pCapture, QWidget *pToysParent)
+	: m_pClient(&client)
+	, m_Log(log)
+	, m_pCapture(pCapture)
+	, m_UdpOutThread(0)
+	, m_TcpClientThread(0)
+	, m_Toys(0)
+	, m_Timer(0)
+	, m_IdleTicks(0)
+{
+	m_Toys = new Toys(this, pToysParent);
+
+	m_Timer = new QTimer(this);
+	connect(m_Timer, SIGNAL(timeout()), this, SLOT(onTick()));
+	m_Timer->start(TICK_MS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Engine::~Engine()
+{
+	Shutdown();
+
+	if( m_Toys )
+	{
+		delete m_Toys;
+		m_Toys = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::Start(const sNetworkSettings &settings)
+{
+	Shutdown();
+
+	switch( settings.mode )
+	{
+		case OSCStream::FRAME_MODE_1_0:
+		case OSCStream::FRAME_MODE_1_1:
+			{
+				m_TcpClientThread = new EosTcpClientThread();
+				m_TcpClientThread->SetNotifyTarget(this, "onNetworkActivity");
+				m_TcpClientThread->SetCapture(m_pCapture);
+				m_TcpClientThread->Start(settings.ip, settings.port1, settings.mode);
+			}
+			break;
+			
+		default:
+			{
+				m_UdpOutThread = new EosUdpOutThread();
+				m_UdpOutThread->SetNotifyTarget(this, "onNetworkActivity");
+				m_UdpOutThread->SetCapture(m_pCapture);
+				m_UdpOutThread->Start(settings.ip, settings.port1);
+				
+				StartUdpInThreads(settings.ip, settings.port2);
+			}
+			break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::StartUdpInThreads(const QString &ip, unsigned short port)
+{
+	QHostAddress remoteAddr(ip);
+
+	if(remoteAddr.toIPv4Address() == QHostAddress(QHostAddress::LocalHost).toIPv4Address())
+	{
+		EosUdpInThread *udpInThread = new EosUdpInThread();
+		udpInThread->SetNotifyTarget(this, "onNetworkActivity");
+		udpInThread->SetCapture(m_pCapture);
+		udpInThread->Start(ip, port);
+		m_UdpInThreads.push_back(udpInThread);
+	}
+	else
+	{
+		// 1 input thread per applicable network interface
+		QList<QNetworkInterface> allNics = QNetworkInterface::allInterfaces();
+		for(QList<QNetworkInterface>::const_iterator i=allNics.begin(); i!=allNics.end(); i++)
+		{
+			const QNetworkInterface &nic = *i;
+			if(nic.isValid() && nic.flags().testFlag(QNetworkInterface::IsUp))
+			{
+				QList<QNetworkAddressEntry> addrs = nic.addressEntries();
+				for(QList<QNetworkAddressEntry>::const_iterator j=addrs.begin(); j!=addrs.end(); j++)
+				{
+					QHostAddress addr = j->ip();
+					if(	!addr.isNull() &&
+						addr.protocol()==QAbstractSocket::IPv4Protocol &&
+						remoteAddr.isInSubnet(addr,j->prefixLength()) )
+					{
+						EosUdpInThread *udpInThread = new EosUdpInThread();
+						udpInThread->SetNotifyTarget(this, "onNetworkActivity");
+						udpInThread->SetCapture(m_pCapture);
+						udpInThread->Start(j->ip().toString(), port);
+						m_UdpInThreads.push_back(udpInThread);
+					}
+				}
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::Shutdown()
+{
+	if( m_TcpClientThread )
+	{
+		m_TcpClientThread->Stop();
+		ClearRecvQ();
+		ClearNetEventQ();
+		m_TcpClientThread->Flush(m_TempLogQ, m_RecvQ, m_NetEventQ);
+		m_Log.AddQ(m_TempLogQ);
+		delete m_TcpClientThread;
+		m_TcpClientThread = 0;
+	}
+	
+	for(UDP_IN_THREADS::const_iterator i=m_UdpInThreads.begin(); i!=m_UdpInThreads.end(); i++)
+	{
+		EosUdpInThread *udpInThread = *i;
+
+		udpInThread->Stop();
+		ClearRecvQ();
+		udpInThread->Flush(m_TempLogQ, m_RecvQ);
+		m_Log.AddQ(m_TempLogQ);
+
+		delete udpInThread;
+	}
+	m_UdpInThreads.clear();
+	
+	if( m_UdpOutThread )
+	{
+		m_UdpOutThread->Stop();
+		ClearRecvQ();
+		ClearNetEventQ();
+		m_UdpOutThread->Flush(m_TempLogQ, m_NetEventQ);
+		m_Log.AddQ(m_TempLogQ);
+		delete m_UdpOutThread;
+		m_UdpOutThread = 0;
+	}
+	
+	ClearRecvQ();
+	ClearNetEventQ();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::ClearRecvQ()
+{
+	for(PACKET_Q::const_iterator i=m_RecvQ.begin(); i!=m_RecvQ.end(); i++)
+		delete[] i->data;
+	m_RecvQ.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::ClearNetEventQ()
+{
+	m_NetEventQ.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::ProcessRecvQ()
+{
+	TRACE_ZONE("Engine::ProcessRecvQ");
+
+	if( !m_RecvQ.empty() )
+		METRICS.Record(Metrics::HISTOGRAM_RECV_QUEUE_DEPTH, static_cast<qint64>(m_RecvQ.size()));
+
+	bool latencyProbes = METRICS.GetLatencyProbes();
+
+	for(PACKET_Q::const_iterator i=m_RecvQ.begin(); i!=m_RecvQ.end(); i++)
+	{
+		// echo replies only while probing, so a peer cannot draw traffic from a show by default
+		if(!latencyProbes || !Echo(i->data,i->size))
+			m_Toys->Recv(i->data, i->size, latencyProbes ? i->timeNS : 0);
+		delete[] i->data;
+	}
+	
+	m_RecvQ.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Engine::Echo(char *data, size_t size)
+{
+	// replies after the same queueing and dispatch as any other received packet
+	const size_t pathSize = sizeof(ENGINE_ECHO_PATH);
+	if(size<pathSize || memcmp(data,ENGINE_ECHO_PATH,pathSize)!=0)
+		return false;
+
+	OSCPacketWriter packetWriter(ENGINE_ECHO_REPLY_PATH);
+
+	size_t argCount = 0xffffffff;
+	OSCArgument *args = OSCArgument::GetArgs(data, size, argCount);
+	if( args )
+	{
+		std::string str;
+		for(size_t i=0; i<argCount; i++)
+		{
+			if( args[i].GetString(str) )
+				packetWriter.AddString(str);
+		}
+		delete[] args;
+	}
+
+	size_t replySize = 0;
+	char *reply = packetWriter.Create(replySize);
+	if( reply )
+		Send(false, reply, replySize);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::ProcessNetEventQ()
+{
+	for(NETEVENT_Q::const_iterator i=m_NetEventQ.begin(); i!=m_NetEventQ.end(); i++)
+	{
+		switch( *i )
+		{
+			case NET_EVENT_CONNECTED:
+				m_Toys->Connected();
+				break;
+				
+			case NET_EVENT_DISCONNECTED:
+				m_Toys->Disconnected();
+				break;
+		}
+	}
+	
+	m_NetEventQ.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::onTick()
+{
+	TRACE_ZONE("Engine::onTick");
+
+	m_TickMetrics.Tick(Metrics::HISTOGRAM_EVENT_LOOP_LAG_US, m_Timer->interval());
+
+	bool active = false;
+
+	if( m_UdpOutThread )
+	{
+		ClearRecvQ();
+		ClearNetEventQ();
+		m_UdpOutThread->Flush(m_TempLogQ, m_NetEventQ);
+		active = (active || !m_NetEventQ.empty());
+		m_Log.AddQ(m_TempLogQ);
+		ProcessNetEventQ();
+		ProcessRecvQ();
+	}
+	
+	for(UDP_IN_THREADS::const_iterator i=m_UdpInThreads.begin(); i!=m_UdpInThreads.end(); i++)
+	{
+		ClearRecvQ();
+		(*i)->Flush(m_TempLogQ, m_RecvQ);
+		active = (active || !m_RecvQ.empty());
+		m_Log.AddQ(m_TempLogQ);
+		ProcessRecvQ();
+	}
+	
+	if( m_TcpClientThread )
+	{
+		ClearRecvQ();
+		ClearNetEventQ();
+		m_TcpClientThread->Flush(m_TempLogQ, m_RecvQ, m_NetEventQ);
+		active = (active || !m_RecvQ.empty() || !m_NetEventQ.empty());
+		m_Log.AddQ(m_TempLogQ);
+		ProcessNetEventQ();
+		ProcessRecvQ();
+	}
+
+	ClearRecvQ();
+	ClearNetEventQ();
+
+	if( m_pClient->EngineClient_Tick() )
+		active = true;
+
+	// poll slowly while idle, network threads and sends wake it back up
+	if( active )
+	{
+		WakeTimer();
+	}
+	else if(m_IdleTicks < IDLE_TICKS)
+	{
+		if(++m_IdleTicks == IDLE_TICKS)
+			m_Timer->start(IDLE_TICK_MS);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::onNetworkActivity()
+{
+	WakeTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::WakeTimer()
+{
+	m_IdleTicks = 0;
+	if(m_Timer && m_Timer->interval()!=TICK_MS)
+	{
+		// restarted mid interval, the next tick is not late
+		m_TickMetrics.Reset();
+		m_Timer->start(TICK_MS);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Engine::Send(bool local, char *buf, size_t size)
+{
+	if(buf && size!=0)
+	{
+		WakeTimer();
+
+		if( local )
+		{
+			m_Toys->Recv(buf, size);
+			delete[] buf;
+			return true;
+		}
+		else
+		{
+			sPacket packet;
+			packet.data = buf;
+			packet.size = size;
+			Metrics::InputScope::GetActive(packet.timeNS, packet.source);
+			
+			if( m_UdpOutThread )
+			{
+				if( m_UdpOutThread->Send(packet) )
+					return true;
+			}
+			else if( m_TcpClientThread )
+			{
+				if( m_TcpClientThread->Send(packet) )
+					return true;
+			}
+
+			delete[] buf;
+		}
+	}
+	
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Engine::SendAt(char *buf, size_t size, qint64 dueNS, const void *owner)
+{
+	if(buf && size!=0)
+	{
+		WakeTimer();
+
+		sPacket packet;
+		packet.data = buf;
+		packet.size = size;
+		
+		if( m_UdpOutThread )
+		{
+			if( m_UdpOutThread->SendAt(packet,dueNS,owner) )
+				return true;
+		}
+		else if( m_TcpClientThread )
+		{
+			if( m_TcpClientThread->SendAt(packet,dueNS,owner) )
+				return true;
+		}
+		
+		delete[] buf;
+	}
+	
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::CancelSends(const void *owner)
+{
+	if( m_UdpOutThread )
+		m_UdpOutThread->CancelSends(owner);
+	else if( m_TcpClientThread )
+		m_TcpClientThread->CancelSends(owner);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Engine::ToyClient_Send(bool local, char *data, size_t size)
+{
+	return Send(local, data, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Engine::ToyClient_SendAt(char *data, size_t size, qint64 dueNS, const void *owner)
+{
+	return SendAt(data, size, dueNS, owner);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::ToyClient_CancelSends(const void *owner)
+{
+	CancelSends(owner);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::ToyClient_ResourceRelativePathToAbsolute(QString &path)
+{
+	Toy::ResourceRelativePathToAbsolute(&m_Log, m_ShowPath, path);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Engine::ReadShowFile(const QString &path, QStringList &lines)
+{
+	QFile f(path);
+	if( !f.open(QIODevice::ReadOnly|QIODevice::Text) )
+		return false;
+
+	QTextStream textStream( &f );
+	QString contents( textStream.readAll() );
+	contents.remove('\r');
+	lines = contents.split('\n',QString::KeepEmptyParts);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// items are the leading fields of a show's settings line, see MainWindow::SaveSettings
+void Engine::LoadShowSettings(const QString &line, sNetworkSettings &settings, QStringList &items)
+{
+	// leading settings line of a show file, see MainWindow::SaveSettings
+	items.clear();
+	Utils::GetItemsFromQuotedString(line, items);
+	
+	if(items.size() > 0)
+	{
+		int n = items[0].toInt();
+		if(n<0 || n>=OSCStream::FRAME_MODE_COUNT)
+			n = OSCStream::FRAME_MODE_INVALID;
+		settings.mode = static_cast<OSCStream::EnumFrameMode>(n);
+	}
+	
+	if(items.size() > 1)
+		settings.ip = items[1];
+	
+	if(items.size() > 2)
+		settings.port1 = items[2].toUShort();
+	
+	if(items.size() > 3)
+		settings.port2 = items[3].toUShort();
+	
+	Toy::SetFlickerSeed((items.size() > 7) ? items[7].toUInt() : 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Engine::LoadAdvancedSettings(QSettings &settings)
+{
+	float degrees = (Toy::GetEncoderRadiansPerTick() * (180/M_PI));
+	float radians = (settings.value(SETTING_ENCODER_DEGREES_PER_TICK,degrees).toFloat() * (M_PI/180));
+	Toy::SetEncoderRadiansPerTick(radians);
+	Toy::SetFeedbackDelayMS( settings.value(SETTING_FEEDBACK_DELAY,Toy::GetFeedbackDelayMS()).toUInt() );
+	Toy::SetCmdSendAllDelayMS( settings.value(SETTING_CMD_SEND_ALL_DELAY,Toy::GetCmdSendAllDelayMS()).toUInt() );
+	Toy::SetMetroRefreshRateMS( settings.value(SETTING_METRO_REFRESH_RATE,Toy::GetMetroRefreshRateMS()).toUInt() );
+	Toy::SetSineRefreshRateMS( settings.value(SETTING_SINE_REFRESH_RATE,Toy::GetSineRefreshRateMS()).toUInt() );
+	Toy::SetPedalRefreshRateMS( settings.value(SETTING_PEDAL_REFRESH_RATE,Toy::GetPedalRefreshRateMS()).toUInt() );
+	Toy::SetSineSendRateMS( settings.value(SETTING_SINE_SEND_RATE,Toy::GetSineSendRateMS()).toUInt() );
+	Toy::SetPedalSendRateMS( settings.value(SETTING_PEDAL_SEND_RATE,Toy::GetPedalSendRateMS()).toUInt() );
+	Toy::SetFlickerSendRateMS( settings.value(SETTING_FLICKER_SEND_RATE,Toy::GetFlickerSendRateMS()).toUInt() );
+	Toy::SetSendEpsilon( settings.value(SETTING_SEND_EPSILON,Toy::GetSendEpsilon()).toFloat() );
+	Toy::SetCellGridThreshold( settings.value(SETTING_CELL_GRID_THRESHOLD,Toy::GetCellGridThreshold()).toUInt() );
+	Toy::SetImageCacheMB( settings.value(SETTING_IMAGE_CACHE_MB,Toy::GetImageCacheMB()).toUInt() );
+	PMC.SetBudget(static_cast<qint64>(Toy::GetImageCacheMB()) * 1024 * 1024);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,143 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#ifndef EOS_LOG_H
+#include "EosLog.h"
+#endif
+
+#ifndef TOYS_H
+#include "Toys.h"
+#endif
+
+#ifndef NETWORK_THREADS_H
+#include "NetworkThreads.h"
+#endif
+
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// load tools send a correlation value here and time the reply, see LoadGen;
+// answered only while latency probes are on
+#define ENGINE_ECHO_PATH		"/oscwidgets/echo"
+#define ENGINE_ECHO_REPLY_PATH	"/oscwidgets/out/echo"
+
+////////////////////////////////////////////////////////////////////////////////
+
+// everything a show needs to run without the main window: the network threads,
+// the toys with their recv dispatch table and generators, and the tick that
+// moves packets between them
+//
+// MainWindow and the headless host each own one, the client gets a call every
+// tick after the network queues have been processed
+class Engine
+	: public QObject
+	, private Toy::Client
+{
+	Q_OBJECT
+
+public:
+	enum EnumConstants
+	{
+		TICK_MS			= 100,
+		IDLE_TICK_MS	= 1000,
+		IDLE_TICKS		= 10	// quiet ticks before polling slows to IDLE_TICK_MS
+	};
+
+	struct sNetworkSettings
+	{
+		sNetworkSettings();
+
+		OSCStream::EnumFrameMode	mode;
+		QString						ip;
+		unsigned short				port1;	// udp output or tcp
+		unsigned short				port2;	// udp input
+	};
+
+	class Client
+	{
+	public:
+		virtual bool EngineClient_Tick() = 0;	// return true if the client had activity, keeps polling fast
+	};
+
+	Engine(Client &client, EosLog &log, PacketCapture *pCapture, QWidget *pToysParent);
+	virtual ~Engine();
+
+	virtual Toys* GetToys() const {return m_Toys;}
+	virtual const QString& GetShowPath() const {return m_ShowPath;}
+	virtual void SetShowPath(const QString &path) {m_ShowPath = path;}
+	virtual void Start(const sNetworkSettings &settings);
+	virtual void Shutdown();
+	virtual bool Send(bool local, char *data, size_t size);
+	virtual bool SendAt(char *data, size_t size, qint64 dueNS, const void *owner);
+	virtual void CancelSends(const void *owner);
+	virtual void WakeTimer();
+
+	static bool ReadShowFile(const QString &path, QStringList &lines);
+	static void LoadShowSettings(const QString &line, sNetworkSettings &settings, QStringList &items);
+	static void LoadAdvancedSettings(QSettings &settings);
+
+private slots:
+	void onTick();
+	void onNetworkActivity();
+
+private:
+	typedef std::vector<EosUdpInThread*> UDP_IN_THREADS;
+
+	Client				*m_pClient;
+	EosLog				&m_Log;
+	EosLog::LOG_Q		m_TempLogQ;
+	PacketCapture		*m_pCapture;
+	QString				m_ShowPath;
+	EosUdpOutThread		*m_UdpOutThread;
+	UDP_IN_THREADS		m_UdpInThreads;
+	EosTcpClientThread	*m_TcpClientThread;
+	PACKET_Q			m_RecvQ;
+	NETEVENT_Q			m_NetEventQ;
+	Toys				*m_Toys;
+	QTimer				*m_Timer;
+	unsigned int		m_IdleTicks;
+	Metrics::TickTimer	m_TickMetrics;
+
+	virtual void StartUdpInThreads(const QString &ip, unsigned short port);
+	virtual void ClearRecvQ();
+	virtual void ProcessRecvQ();
+	virtual bool Echo(char *data, size_t size);
+	virtual void ClearNetEventQ();
+	virtual void ProcessNetEventQ();
+	virtual bool ToyClient_Send(bool local, char *data, size_t size);
+	virtual bool ToyClient_SendAt(char *data, size_t size, qint64 dueNS, const void *owner);
+	virtual void ToyClient_CancelSends(const void *owner);
+	virtual void ToyClient_ResourceRelativePathToAbsolute(QString &path);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -20,6 +20,8 @@
 
 #include "FadeButton.h"
 #include "Utils.h"
+#include "Trace.h"
+#include "Toy.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -41,6 +43,10 @@ FadeButton::FadeButton(bool touchEnabled, QWidget *parent)
 
 FadeButton::~FadeButton()
 {
+	ANIM.Stop(this);
+	ANIM.CancelInvalidate(this);
+	PMC.RemoveClient(this);
+
 	for(size_t i=0; i<NUM_IMAGES; i++)
 		SetImagePath(i, QString());
 }
@@ -50,15 +56,11 @@ FadeButton::~FadeButton()
 void FadeButton::Construct(bool touchEnabled)
 {
 	m_Click = 0;
+	m_ClickAnimating = false;
 	m_Hover = 0;
+	m_HoverAnimating = false;
 	m_ImageIndex = 0;
 
-	m_ClickTimer = new QTimer(this);
-	connect(m_ClickTimer, SIGNAL(timeout()), this, SLOT(onClickTimeout()));
-	
-	m_HoverTimer = new QTimer(this);
-	connect(m_HoverTimer, SIGNAL(timeout()), this, SLOT(onHoverTimeout()));
-	
 	connect(this, SIGNAL(pressed()), this, SLOT(onPressed()));
 	connect(this, SIGNAL(released()), this, SLOT(onReleased()));
 
@@ -75,7 +77,7 @@ void FadeButton::SetLabel(const QString &label)
 	if(m_Label != label)
 	{
 		m_Label = label;
-		update();
+		Invalidate();
 	}
 }
 
@@ -98,6 +100,8 @@ void FadeButton::SetImagePath(size_t index, const QString &imagePath)
 		
 		if(img.path != imagePath)
 		{
+			PMC.DestroyScaled(img.path, img.scaledSize, PixmapCache::SCALE_TO_FILL);
+			img.scaledSize = QSize();
 			PMC.Destroy( img.path );
 			img.path = imagePath;
 			PMC.Create( img.path );
@@ -113,7 +117,7 @@ void FadeButton::SetImageIndex(size_t index)
 	if(index<NUM_IMAGES && m_ImageIndex!=index)
 	{
 		m_ImageIndex = index;
-		update();
+		Invalidate();
 	}
 }
 
@@ -124,9 +128,31 @@ void FadeButton::UpdateImage(size_t index)
 	if(index < NUM_IMAGES)
 	{
 		sImage &img = m_Images[index];
-		PMC.GetScaledToFill(img.path, size(), img.pixmap);
-		if(m_ImageIndex == index)
-			update();
+		if(img.scaledSize != size())
+		{
+			PMC.DestroyScaled(img.path, img.scaledSize, PixmapCache::SCALE_TO_FILL);
+			img.scaledSize = size();
+			PMC.CreateScaled(img.path, img.scaledSize, PixmapCache::SCALE_TO_FILL, img.pixmap, this);
+			if(m_ImageIndex == index)
+				Invalidate();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeButton::PixmapCacheClient_Loaded(const QString &path)
+{
+	// swap the placeholder for the decoded image
+	for(size_t i=0; i<NUM_IMAGES; i++)
+	{
+		sImage &img = m_Images[i];
+		if(img.path == path)
+		{
+			PMC.GetScaled(img.path, img.scaledSize, PixmapCache::SCALE_TO_FILL, img.pixmap);
+			if(m_ImageIndex == i)
+				Invalidate();
+		}
 	}
 }
 
@@ -135,15 +161,16 @@ void FadeButton::UpdateImage(size_t index)
 void FadeButton::StartClick()
 {
 	m_ClickTimestamp.Start();
-	m_ClickTimer->start(20);
-	onClickTimeout();
+	m_ClickAnimating = true;
+	ANIM.Start(this);
+	UpdateClick();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void FadeButton::StopClick()
 {
-	m_ClickTimer->stop();
+	m_ClickAnimating = false;
 	SetClick(0);
 }
 
@@ -154,7 +181,7 @@ void FadeButton::SetClick(float percent)
 	if(m_Click != percent)
 	{
 		m_Click = percent;
-		update();
+		Invalidate();
 	}
 }
 
@@ -164,8 +191,9 @@ void FadeButton::Flash()
 {
 	m_Hover = 1.0;
 	m_HoverTimestamp.Start();
-	m_HoverTimer->start(20);
-	onHoverTimeout();
+	m_HoverAnimating = true;
+	ANIM.Start(this);
+	UpdateHover();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -173,15 +201,16 @@ void FadeButton::Flash()
 void FadeButton::StartHover()
 {
 	m_HoverTimestamp.Start();
-	m_HoverTimer->start(20);
-	onHoverTimeout();
+	m_HoverAnimating = true;
+	ANIM.Start(this);
+	UpdateHover();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void FadeButton::StopHover()
 {
-	m_HoverTimer->stop();
+	m_HoverAnimating = false;
 	SetHover(0);
 }
 
@@ -192,7 +221,7 @@ void FadeButton::SetHover(float percent)
 	if(m_Hover != percent)
 	{
 		m_Hover = percent;
-		update();
+		Invalidate();
 	}
 }
 
@@ -258,8 +287,80 @@ void FadeButton::resizeEvent(QResizeEvent *event)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void FadeButton::RenderBackgroundLayer(QPainter &painter, QRectF &r, const QPen &pen, const QColor &brushColor)
+{
+	sBackgroundLayer &layer = m_BackgroundLayer;
+
+	QColor penColor( (pen.style()==Qt::NoPen) ? QColor() : pen.color() );
+	int dpr = devicePixelRatio();
+	if(	layer.pixmap.isNull() ||
+		layer.size!=size() ||
+		layer.dpr!=dpr ||
+		layer.penColor!=penColor ||
+		layer.penWidth!=pen.widthF() ||
+		layer.brushColor!=brushColor )
+	{
+		layer.size = size();
+		layer.dpr = dpr;
+		layer.penColor = penColor;
+		layer.penWidth = pen.widthF();
+		layer.brushColor = brushColor;
+
+		layer.pixmap = QPixmap(layer.size * dpr);
+		layer.pixmap.setDevicePixelRatio(dpr);
+		layer.pixmap.fill(Qt::transparent);
+
+		QPainter layerPainter(&layer.pixmap);
+		layerPainter.setRenderHints(QPainter::Antialiasing);
+		layerPainter.setPen(pen);
+		layerPainter.setBrush(brushColor);
+		QRectF layerRect(r);
+		RenderBackground(layerPainter, layerRect);
+	}
+
+	painter.drawPixmap(0, 0, layer.pixmap);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeButton::UpdateTextLayout(qreal width)
+{
+	sTextLayout &layout = m_TextLayout;
+
+	if(layout.width!=width || layout.font!=font())
+	{
+		layout.width = width;
+		layout.font = font();
+		PrepareStaticText(layout.text, text(), layout.font, layout.width);
+		PrepareStaticText(layout.label, m_Label, layout.font, layout.width);
+	}
+	else
+	{
+		if(layout.text.text() != text())
+			PrepareStaticText(layout.text, text(), layout.font, layout.width);
+		if(layout.label.text() != m_Label)
+			PrepareStaticText(layout.label, m_Label, layout.font, layout.width);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeButton::RenderText(QPainter &painter, const QRectF &r, const QColor &textColor)
+{
+	if(!text().isEmpty() || !m_Label.isEmpty())
+	{
+		UpdateTextLayout( r.width() );
+		painter.setPen(textColor);
+		DrawStaticTextAndLabel(painter, r, m_TextLayout.text, m_TextLayout.label);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void FadeButton::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeButton::paintEvent");
+
 	QRectF r( rect() );
 	r.adjust(1, 1, -1, -1);
 	
@@ -278,12 +379,11 @@ void FadeButton::paintEvent(QPaintEvent* /*event*/)
 		color.setGreenF( qMin(color.greenF()+t,1.0) );
 		color.setBlueF( qMin(color.blueF()+t,1.0) );
 		painter.setBrush(color);
+		painter.setPen(Qt::NoPen);
+		RenderBackground(painter, r);
 	}
 	else
-		painter.setBrush( palette().color(QPalette::Button) );
-
-	painter.setPen(Qt::NoPen);
-	RenderBackground(painter, r);
+		RenderBackgroundLayer(painter, r, QPen(Qt::NoPen), palette().color(QPalette::Button));
 
 	sImage &img = m_Images[m_ImageIndex];
 	if( !img.pixmap.isNull() )
@@ -306,35 +406,7 @@ void FadeButton::paintEvent(QPaintEvent* /*event*/)
 	if( !isEnabled() )
 		textColor = textColor.darker(150);
 
-	if( !text().isEmpty() )
-	{
-		if( m_Label.isEmpty() )
-		{
-			// just text centered
-			painter.setPen(textColor);
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap, text());
-		}
-		else
-		{
-			// both text and label text
-			QRectF textRect;
-			painter.setPen(textColor);
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontPrint, text(), &textRect);
-
-			QRectF labelRect;
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontPrint, m_Label, &labelRect);
-
-			qreal h = (r.height() * 0.5 * (textRect.height()/labelRect.height()));
-			painter.drawText(QRectF(r.x(),r.y(),r.width(),h), Qt::AlignCenter|Qt::TextWordWrap, text());
-			painter.drawText(QRectF(r.x(),r.y()+h,r.width(),r.height()-h), Qt::AlignCenter|Qt::TextWordWrap, m_Label);
-		}
-	}
-	else if( !m_Label.isEmpty() )
-	{
-		// just label text centered
-		painter.setPen(textColor);
-		painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap, m_Label);
-	}
+	RenderText(painter, r, textColor);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -354,21 +426,21 @@ void FadeButton::onReleased()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void FadeButton::onClickTimeout()
+void FadeButton::UpdateClick()
 {
 	int elapsed = m_ClickTimestamp.GetElapsed();
 	float t = (1.0f - elapsed/static_cast<float>(BUTTON_CLICK_MS));
 	if(t <= 0)
 	{
 		t = 0;
-		m_ClickTimer->stop();
+		m_ClickAnimating = false;
 	}
 	SetClick(t);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void FadeButton::onHoverTimeout()
+void FadeButton::UpdateHover()
 {
 	float t = (m_HoverTimestamp.GetElapsed() * BUTTON_HOVER_SPEED);
 	
@@ -378,7 +450,7 @@ void FadeButton::onHoverTimeout()
 		if(hover >= 1.0f)
 		{
 			hover = 1.0f;
-			m_HoverTimer->stop();
+			m_HoverAnimating = false;
 		}
 		SetHover(hover);
 	}
@@ -388,7 +460,7 @@ void FadeButton::onHoverTimeout()
 		if(hover <= 0)
 		{
 			hover = 0;
-			m_HoverTimer->stop();
+			m_HoverAnimating = false;
 		}
 		SetHover(hover);
 	}
@@ -396,12 +468,67 @@ void FadeButton::onHoverTimeout()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void FadeButton::Invalidate()
+{
+	// repainted with the next animation frame, however many times it changes before then
+	m_PaintProbe.Invalidated();
+	ANIM.Invalidate(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool FadeButton::AnimationClient_Tick()
+{
+	if( m_ClickAnimating )
+		UpdateClick();
+
+	if( m_HoverAnimating )
+		UpdateHover();
+
+	return (m_ClickAnimating || m_HoverAnimating);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool FadeButton::IsInputEvent(const QEvent &event)
+{
+	switch( event.type() )
+	{
+		case QEvent::MouseButtonPress:
+		case QEvent::MouseButtonRelease:
+		case QEvent::MouseButtonDblClick:
+		case QEvent::MouseMove:
+		case QEvent::TouchBegin:
+		case QEvent::TouchUpdate:
+		case QEvent::TouchEnd:
+		case QEvent::KeyPress:
+		case QEvent::KeyRelease:
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool FadeButton::event(QEvent *event)
 {
 	if( event )
 	{
+		// packets sent while handling the input carry its arrival time to the wire
+		Metrics::InputScope inputScope( IsInputEvent(*event) ? Toy::GetLatencySource(this) : -1 );
+
 		switch( event->type() )
 		{
+			case QEvent::Paint:
+				{
+					qint64 startNS = Utils::GetTimeNS();
+					bool result = QPushButton::event(event);
+					ANIM.AddPaint(Utils::GetTimeNS() - startNS);
+					m_PaintProbe.Painted();
+					return result;
+				}
+
 			case QEvent::HoverEnter:
 			case QEvent::HoverLeave:
 				StartHover();
@@ -455,3 +582,53 @@ bool FadeButton::event(QEvent *event)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+
+void FadeButton::PrepareStaticText(QStaticText &staticText, const QString &str, const QFont &font, qreal width)
+{
+	QTextOption option(Qt::AlignHCenter);
+	option.setWrapMode(QTextOption::WordWrap);
+	staticText.setTextFormat(Qt::PlainText);
+	staticText.setTextOption(option);
+	staticText.setTextWidth(width);
+	staticText.setText(str);
+	staticText.prepare(QTransform(), font);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeButton::DrawStaticText(QPainter &painter, const QRectF &r, const QStaticText &staticText)
+{
+	// centered vertically within r, horizontal centering comes from the layout
+	qreal y = (r.y() + (r.height()-staticText.size().height())*0.5);
+	painter.drawStaticText(QPointF(r.x(),y), staticText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeButton::DrawStaticTextAndLabel(QPainter &painter, const QRectF &r, const QStaticText &text, const QStaticText &label)
+{
+	if( !text.text().isEmpty() )
+	{
+		if( label.text().isEmpty() )
+		{
+			// just text centered
+			DrawStaticText(painter, r, text);
+		}
+		else
+		{
+			// both text and label text, split by their laid out heights
+			qreal textHeight = text.size().height();
+			qreal labelHeight = label.size().height();
+			qreal h = (r.height() * 0.5 * ((labelHeight>0) ? (textHeight/labelHeight) : 1.0));
+			DrawStaticText(painter, QRectF(r.x(),r.y(),r.width(),h), text);
+			DrawStaticText(painter, QRectF(r.x(),r.y()+h,r.width(),r.height()-h), label);
+		}
+	}
+	else if( !label.text().isEmpty() )
+	{
+		// just label text centered
+		DrawStaticText(painter, r, label);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
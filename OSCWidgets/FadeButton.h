@@ -26,14 +26,28 @@
 #include "QtInclude.h"
 #endif
 
-#ifndef EOS_TIMER_H
-#include "EosTimer.h"
+#ifndef CLOCK_H
+#include "Clock.h"
+#endif
+
+#ifndef ANIMATION_DRIVER_H
+#include "AnimationDriver.h"
+#endif
+
+#ifndef UTILS_H
+#include "Utils.h"
+#endif
+
+#ifndef METRICS_H
+#include "Metrics.h"
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
 
 class FadeButton
 	: public QPushButton
+	, protected AnimationDriver::Client
+	, protected PixmapCache::Client
 {
 	Q_OBJECT
 	
@@ -55,12 +69,14 @@ public:
     virtual void Press(bool user=true);
     virtual void Release(bool user=true);
 	virtual void Flash();
+	virtual void Invalidate();
+	static void PrepareStaticText(QStaticText &staticText, const QString &str, const QFont &font, qreal width);
+	static void DrawStaticText(QPainter &painter, const QRectF &r, const QStaticText &staticText);
+	static void DrawStaticTextAndLabel(QPainter &painter, const QRectF &r, const QStaticText &text, const QStaticText &label);
 	
 private slots:
 	void onPressed();
 	void onReleased();
-	void onClickTimeout();
-	void onHoverTimeout();
 
 private:
 	void Construct(bool touchEnabled);
@@ -69,18 +85,51 @@ protected:
 	struct sImage
 	{
 		QString path;
+		QSize	scaledSize;
+		QPixmap	pixmap;
+	};
+
+	// text and label laid out once, and only again when the font, width or strings change
+	struct sTextLayout
+	{
+		sTextLayout()
+			: width(-1)
+		{}
+
+		QFont		font;
+		qreal		width;
+		QStaticText	text;
+		QStaticText	label;
+	};
+
+	// resting background, rendered once per size and color
+	struct sBackgroundLayer
+	{
+		sBackgroundLayer()
+			: dpr(0)
+			, penWidth(0)
+		{}
+
+		QSize	size;
+		int		dpr;
+		QColor	penColor;
+		qreal	penWidth;
+		QColor	brushColor;
 		QPixmap	pixmap;
 	};
 	
 	float		m_Click;
-	QTimer		*m_ClickTimer;
-	EosTimer	m_ClickTimestamp;
+	bool		m_ClickAnimating;
+	ClockTimer	m_ClickTimestamp;
 	float		m_Hover;
-	QTimer		*m_HoverTimer;
-	EosTimer	m_HoverTimestamp;
+	bool		m_HoverAnimating;
+	ClockTimer	m_HoverTimestamp;
 	QString		m_Label;
 	sImage		m_Images[NUM_IMAGES];
 	size_t		m_ImageIndex;
+	sTextLayout	m_TextLayout;
+	sBackgroundLayer m_BackgroundLayer;
+	Metrics::PaintProbe m_PaintProbe;
 	
 	virtual void StartClick();
 	virtual void StopClick();
@@ -88,12 +137,21 @@ protected:
 	virtual void StartHover();
 	virtual void StopHover();
 	virtual void SetHover(float percent);
+	virtual void UpdateClick();
+	virtual void UpdateHover();
+	virtual bool AnimationClient_Tick();
+	virtual void PixmapCacheClient_Loaded(const QString &path);
 	virtual void AutoSizeFont();
 	virtual void UpdateImage(size_t index);
 	virtual void RenderBackground(QPainter &painter, QRectF &r);
+	virtual void RenderBackgroundLayer(QPainter &painter, QRectF &r, const QPen &pen, const QColor &brushColor);
+	virtual void UpdateTextLayout(qreal width);
+	virtual void RenderText(QPainter &painter, const QRectF &r, const QColor &textColor);
 	virtual void resizeEvent(QResizeEvent *event);
 	virtual void paintEvent(QPaintEvent *event);
 	virtual bool event(QEvent *event);
+
+	static bool IsInputEvent(const QEvent &event);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
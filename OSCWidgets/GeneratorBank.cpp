@@ -0,0 +1,104 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "GeneratorBank.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeneratorBank::Resize(size_t count)
+{
+	sSlot slot;
+	m_Phase.resize(count, slot.phase);
+	m_Speed.resize(count, slot.speed);
+	m_Running.resize(count, 0);
+	m_Min.resize(count, slot.min);
+	m_Max.resize(count, slot.max);
+	m_Value.resize(count, 0);
+	m_Output.resize(count, 0);
+	m_HasRange.resize(count, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeneratorBank::GetSlot(size_t index, sSlot &slot) const
+{
+	slot.phase = m_Phase[index];
+	slot.speed = m_Speed[index];
+	slot.min = m_Min[index];
+	slot.max = m_Max[index];
+	slot.paused = GetPaused(index);
+	slot.hasRange = HasRange(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeneratorBank::SetSlot(size_t index, const sSlot &slot)
+{
+	m_Phase[index] = slot.phase;
+	m_Speed[index] = slot.speed;
+	SetPaused(index, slot.paused);
+	SetRange(index, slot.hasRange, slot.min, slot.max);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeneratorBank::SetRange(size_t index, bool hasRange, float min, float max)
+{
+	m_HasRange[index] = (hasRange ? 1 : 0);
+	m_Min[index] = min;
+	m_Max[index] = max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void GeneratorBank::Advance(unsigned int ms)
+{
+	size_t count = m_Phase.size();
+	if(count==0 || ms==0)
+		return;
+
+	const float dt = static_cast<float>(ms);
+	const float twoPi = static_cast<float>(TWO_PI);
+	const float toCycles = static_cast<float>(1.0/TWO_PI);
+
+	// plain pointers, so the loops below have no aliasing through vector internals
+	float *phase = &m_Phase[0];
+	const float *speed = &m_Speed[0];
+	const float *running = &m_Running[0];
+	const float *minValue = &m_Min[0];
+	const float *maxValue = &m_Max[0];
+	float *value = &m_Value[0];
+	float *output = &m_Output[0];
+
+	// advance and wrap to [0,TWO_PI)
+	for(size_t i=0; i<count; i++)
+	{
+		float p = (phase[i] + dt*speed[i]*running[i]);
+		phase[i] = (p - twoPi*floorf(p*toCycles));
+	}
+
+	for(size_t i=0; i<count; i++)
+		value[i] = FastSin( phase[i] );
+
+	for(size_t i=0; i<count; i++)
+		output[i] = (minValue[i] + (maxValue[i]-minValue[i])*value[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
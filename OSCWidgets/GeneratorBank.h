@@ -0,0 +1,114 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef GENERATOR_BANK_H
+#define GENERATOR_BANK_H
+
+#ifndef TOY_MATH_H
+#include "ToyMath.h"
+#endif
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// per-grid sine generator state stored as parallel arrays, so one tick advances
+// every generator in a single tight loop the compiler can vectorize
+//
+// nothing here is virtual, the accessors inline into the per-tick loops
+class GeneratorBank
+{
+public:
+	struct sSlot
+	{
+		sSlot()
+			: phase(0)
+			, speed(0)
+			, min(0)
+			, max(0)
+			, paused(true)
+			, hasRange(false)
+		{}
+
+		float	phase;
+		float	speed;
+		float	min;
+		float	max;
+		bool	paused;
+		bool	hasRange;
+	};
+
+	size_t GetCount() const {return m_Phase.size();}
+	void Resize(size_t count);
+	void GetSlot(size_t index, sSlot &slot) const;
+	void SetSlot(size_t index, const sSlot &slot);
+	void Advance(unsigned int ms);	// sin(phase), -1..1, and mapped to min..max
+
+	float GetPhase(size_t index) const {return m_Phase[index];}
+	void SetPhase(size_t index, float phase) {m_Phase[index] = phase;}
+	float GetSpeed(size_t index) const {return m_Speed[index];}
+	void SetSpeed(size_t index, float speed) {m_Speed[index] = speed;}
+	bool GetPaused(size_t index) const {return (m_Running[index] == 0);}
+	void SetPaused(size_t index, bool b) {m_Running[index] = (b ? 0.0f : 1.0f);}
+	bool HasRange(size_t index) const {return (m_HasRange[index] != 0);}
+	void SetRange(size_t index, bool hasRange, float min, float max);
+	float GetValue(size_t index) const {return m_Value[index];}
+	float GetOutput(size_t index) const {return m_Output[index];}
+
+	static float FastSin(float x);
+
+protected:
+	typedef std::vector<float>			FLOATS;
+	typedef std::vector<unsigned char>	FLAGS;
+
+	FLOATS		m_Phase;
+	FLOATS		m_Speed;
+	FLOATS		m_Running;	// 1 or 0, multiplied in so the kernel stays branch free
+	FLOATS		m_Min;
+	FLOATS		m_Max;
+	FLOATS		m_Value;
+	FLOATS		m_Output;
+	FLAGS		m_HasRange;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// polynomial sine for x in [0,TWO_PI), written with selects rather than
+// branches so it inlines into the batch loops
+inline float GeneratorBank::FastSin(float x)
+{
+	const float pi = static_cast<float>(M_PI);
+	const float halfPi = static_cast<float>(M_PI_2);
+
+	// [0,TWO_PI) -> [-PI,PI)
+	x = ((x >= pi) ? (x - static_cast<float>(TWO_PI)) : x);
+
+	// [-PI,PI) -> [-PI/2,PI/2]
+	x = ((x > halfPi) ? (pi - x) : x);
+	x = ((x < -halfPi) ? (-pi - x) : x);
+
+	float x2 = (x * x);
+	return (x * (1.0f + x2*(-1.6666667e-1f + x2*(8.3333310e-3f + x2*(-1.9840874e-4f + x2*2.7525562e-6f)))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -19,14 +19,23 @@
 // THE SOFTWARE.
 
 #include "LogFile.h"
-#include <time.h>
+#include "Trace.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOG_FILE_FLUSH_MS			250			// writer batches lines for up to this long
+#define LOG_FILE_WAKE_LINES			1024		// or until this many are queued
+#define LOG_FILE_BLOCK_BYTES		65536		// bytes encoded before each write
+#define LOG_FILE_MAX_QUEUED_LINES	262144		// hard cap if the disk stalls, excess lines are dropped
 
 ////////////////////////////////////////////////////////////////////////////////
 
 LogFile::LogFile()
 	: m_Run(false)
-	, m_FileDepth(0)
-	, m_Mutex(QMutex::Recursive)
+	, m_MaxFileBytes(0)
+	, m_FileCount(0)
+	, m_Dropped(0)
+	, m_DroppedReported(0)
 {
 }
 
@@ -39,16 +48,18 @@ LogFile::~LogFile()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void LogFile::Initialize(const QString &path, int fileDepth)
+void LogFile::Initialize(const QString &path, qint64 maxFileBytes, int fileCount)
 {
 	Shutdown();
 
-	if(fileDepth > 0)
+	if(maxFileBytes>0 && fileCount>0)
 	{
 		m_Run = true;
 		m_Q.clear();
+		m_Dropped = m_DroppedReported = 0;
 		m_Path = path;
-		m_FileDepth = fileDepth;
+		m_MaxFileBytes = maxFileBytes;
+		m_FileCount = fileCount;
 		start();
 	}
 }
@@ -57,84 +68,169 @@ void LogFile::Initialize(const QString &path, int fileDepth)
 
 void LogFile::Shutdown()
 {
+	m_Mutex.lock();
 	m_Run = false;
+	m_Wait.wakeAll();
+	m_Mutex.unlock();
+
+	// writer drains anything still queued before exiting
 	wait();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void LogFile::Log(EosLog::LOG_Q &logQ)
+void LogFile::Log(LOG_RECORD_Q &records)
 {
+	m_Mutex.lock();
+
 	if( m_Run )
 	{
-		m_Mutex.lock();
-		m_Q.swap(logQ);
-		m_Mutex.unlock();
+		if( m_Q.empty() )
+		{
+			m_Q.swap(records);
+		}
+		else
+		{
+			m_Q.reserve(m_Q.size() + records.size());
+			m_Q.insert(m_Q.end(), records.begin(), records.end());
+		}
+
+		if(m_Q.size() > LOG_FILE_MAX_QUEUED_LINES)
+		{
+			size_t excess = (m_Q.size() - LOG_FILE_MAX_QUEUED_LINES);
+			m_Dropped += static_cast<unsigned int>(excess);
+			m_Q.resize(LOG_FILE_MAX_QUEUED_LINES);
+		}
+
+		if(m_Q.size() >= LOG_FILE_WAKE_LINES)
+			m_Wait.wakeOne();
 	}
+
+	m_Mutex.unlock();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void LogFile::run()
+unsigned int LogFile::GetDroppedCount()
+{
+	m_Mutex.lock();
+	unsigned int dropped = m_Dropped;
+	m_Mutex.unlock();
+	return dropped;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QString LogFile::GetRotatedPath(int index) const
+{
+	if(index < 1)
+		return m_Path;
+
+	QFileInfo fi(m_Path);
+	QString name = QString("%1.%2").arg( fi.completeBaseName() ).arg(index);
+	if( !fi.suffix().isEmpty() )
+		name += QString(".%1").arg( fi.suffix() );
+	return fi.dir().absoluteFilePath(name);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool LogFile::OpenFile(QFile &file, bool rotate)
 {
-	while( m_Run )
+	if( file.isOpen() )
+		file.close();
+
+	if( rotate )
 	{
-		QFile file(m_Path);
-		if( file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Text) )
-		{
-			QTextStream stream( &file );
-			stream.setCodec("UTF-8");
-			stream.setGenerateByteOrderMark(true);
+		// shift path.1 -> path.2 etc, oldest falls off the end
+		QFile::remove( GetRotatedPath(m_FileCount-1) );
+		for(int i=m_FileCount-1; i>0; i--)
+			QFile::rename(GetRotatedPath(i-1), GetRotatedPath(i));
+	}
 
-			EosLog::LOG_Q q;
-			int lineCount = 0;
-			bool restart = false;
+	file.setFileName(m_Path);
+	if( !file.open(QIODevice::WriteOnly|QIODevice::Truncate|QIODevice::Text) )
+		return false;
 
-			for(;;)
-			{
-				q.clear();
-				m_Mutex.lock();
-				q.swap(m_Q);
-				m_Mutex.unlock();
+	// utf8 byte order mark
+	file.write("\xEF\xBB\xBF", 3);
+	return true;
+}
 
-				for(EosLog::LOG_Q::const_iterator i=q.begin(); i!=q.end(); i++)
-				{
-					const EosLog::sLogMsg logMsg = *i;
+////////////////////////////////////////////////////////////////////////////////
 
-					tm *t = localtime( &logMsg.timestamp );
+bool LogFile::WriteBlock(QFile &file, QByteArray &block)
+{
+	bool ok = true;
 
-					QString msgText;
-					if( logMsg.text.c_str() )
-						msgText = QString::fromUtf8( logMsg.text.c_str() );
+	if( !block.isEmpty() )
+	{
+		if( file.isOpen() )
+			ok = (file.write(block) == block.size());
+		block.clear();
+	}
 
-					QString itemText = QString("[ %1:%2:%3 ]  %4")
-						.arg(t->tm_hour, 2)
-						.arg(t->tm_min, 2, 10, QChar('0'))
-						.arg(t->tm_sec, 2, 10, QChar('0'))
-						.arg( msgText );
+	return ok;
+}
 
-					stream << itemText;
-					stream << "\n";
+////////////////////////////////////////////////////////////////////////////////
 
-					if(++lineCount > m_FileDepth)
-					{
-						restart = true;
-						break;
-					}
-				}
+void LogFile::run()
+{
+	TRACE_THREAD_NAME("log file");
 
-				if(restart || !m_Run)
-					break;
+	QFile file;
+	OpenFile(file, /*rotate*/false);
 
-				stream.flush();
+	LOG_RECORD_Q q;
+	QByteArray block;
+	block.reserve(LOG_FILE_BLOCK_BYTES);
 
-				msleep(100);
+	for(;;)
+	{
+		m_Mutex.lock();
+		if(m_Run && m_Q.size()<LOG_FILE_WAKE_LINES)
+			m_Wait.wait(&m_Mutex, LOG_FILE_FLUSH_MS);
+		q.swap(m_Q);
+		bool run = m_Run;
+		unsigned int dropped = (m_Dropped - m_DroppedReported);
+		m_DroppedReported = m_Dropped;
+		m_Mutex.unlock();
+
+		if(dropped != 0)
+		{
+			block.append( QString("[LogFile] %1 lines dropped, writer could not keep up\n").arg(dropped).toUtf8() );
+		}
+
+		for(LOG_RECORD_Q::const_iterator i=q.begin(); i!=q.end(); i++)
+		{
+			QByteArray line( i->line.toUtf8() );
+			line.append('\n');
+
+			// rotate before a line would push the file over its size limit
+			qint64 fileBytes = (file.isOpen() ? file.pos() : 0);
+			if(fileBytes>0 && fileBytes+block.size()+line.size()>m_MaxFileBytes)
+			{
+				WriteBlock(file, block);
+				OpenFile(file, /*rotate*/true);
 			}
 
-			stream.flush();
-			file.close();
+			block.append(line);
+			if(block.size() >= LOG_FILE_BLOCK_BYTES)
+				WriteBlock(file, block);
 		}
+
+		q.clear();
+
+		WriteBlock(file, block);
+		if( file.isOpen() )
+			file.flush();
+
+		if( !run )
+			break;
 	}
+
+	file.close();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
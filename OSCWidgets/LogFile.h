@@ -26,12 +26,13 @@
 #include "QtInclude.h"
 #endif
 
-#ifndef EOS_LOG_H
-#include "EosLog.h"
+#ifndef LOG_RECORD_H
+#include "LogRecord.h"
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// writes log records on a background thread in blocks, rotating path -> path.1.ext -> ...
 class LogFile
 	: private QThread
 {
@@ -39,18 +40,26 @@ public:
 	LogFile();
 	virtual ~LogFile();
 
-	virtual void Initialize(const QString &path, int fileDepth);
+	virtual void Initialize(const QString &path, qint64 maxFileBytes, int fileCount);
 	virtual void Shutdown();
-	virtual void Log(EosLog::LOG_Q &logQ);
+	virtual void Log(LOG_RECORD_Q &records);
 	virtual const QString& GetPath() const {return m_Path;}
+	virtual unsigned int GetDroppedCount();
 
 protected:
 	bool			m_Run;
 	QString			m_Path;
-	int				m_FileDepth;
-	EosLog::LOG_Q	m_Q;
+	qint64			m_MaxFileBytes;
+	int				m_FileCount;
+	LOG_RECORD_Q	m_Q;
+	unsigned int	m_Dropped;
+	unsigned int	m_DroppedReported;
 	QMutex			m_Mutex;
+	QWaitCondition	m_Wait;
 
+	virtual QString GetRotatedPath(int index) const;
+	virtual bool OpenFile(QFile &file, bool rotate);
+	virtual bool WriteBlock(QFile &file, QByteArray &block);
 	virtual void run();
 };
 
@@ -0,0 +1,77 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "LogRecord.h"
+#include <time.h>
+#include <stdio.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+LogRecordFormatter::LogRecordFormatter()
+	: m_Timestamp(0)
+	, m_PrefixLen(0)
+{
+	m_Prefix[0] = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogRecordFormatter::Format(const EosLog::LOG_Q &logQ, LOG_RECORD_Q &records)
+{
+	records.reserve(records.size() + logQ.size());
+
+	for(EosLog::LOG_Q::const_iterator i=logQ.begin(); i!=logQ.end(); i++)
+	{
+		const EosLog::sLogMsg &msg = *i;
+
+		// messages arrive in bursts, so the timestamp text rarely changes
+		if(m_PrefixLen==0 || msg.timestamp!=m_Timestamp)
+			UpdatePrefix(msg.timestamp);
+
+		// single utf8 decode of prefix and message together
+		m_Buf.assign(m_Prefix, m_PrefixLen);
+		if( msg.text.c_str() )
+			m_Buf.append( msg.text.c_str() );
+
+		records.push_back( sLogRecord() );
+		sLogRecord &record = records.back();
+		record.type = msg.type;
+		record.timestamp = msg.timestamp;
+		record.line = QString::fromUtf8(m_Buf.c_str(), static_cast<int>(m_Buf.size()));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogRecordFormatter::UpdatePrefix(time_t timestamp)
+{
+	m_Timestamp = timestamp;
+
+	tm *t = localtime( &m_Timestamp );
+	if( t )
+	{
+		int len = sprintf(m_Prefix, "[%2d:%02d:%02d] ", t->tm_hour, t->tm_min, t->tm_sec);
+		m_PrefixLen = ((len>0) ? static_cast<size_t>(len) : 0);
+	}
+	else
+		m_PrefixLen = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
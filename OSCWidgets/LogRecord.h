@@ -0,0 +1,65 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#ifndef EOS_LOG_H
+#include "EosLog.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// a log message formatted once for display, shared by the log widget and log file
+struct sLogRecord
+{
+	EosLog::EnumLogMsgType	type;
+	time_t					timestamp;
+	QString					line;	// "[hh:mm:ss] text"
+};
+
+typedef std::vector<sLogRecord> LOG_RECORD_Q;
+
+////////////////////////////////////////////////////////////////////////////////
+
+class LogRecordFormatter
+{
+public:
+	LogRecordFormatter();
+
+	virtual void Format(const EosLog::LOG_Q &logQ, LOG_RECORD_Q &records);
+
+protected:
+	time_t		m_Timestamp;
+	size_t		m_PrefixLen;
+	char		m_Prefix[32];
+	std::string	m_Buf;
+
+	virtual void UpdatePrefix(time_t timestamp);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -20,6 +20,8 @@
 // THE SOFTWARE.
 
 #include "LogWidget.h"
+#include "AnimationDriver.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -27,6 +29,8 @@ LogWidget::LogWidget(size_t maxLineCount, QWidget *parent)
 	: QWidget(parent)
 	, m_LineHeight(0)
 	, m_LineWidth(0)
+	, m_VScrollBar(0)
+	, m_HScrollBar(0)
 	, m_ForwardingWheelEvent(false)
 	, m_AutoScroll(true)
 {
@@ -51,6 +55,13 @@ LogWidget::LogWidget(size_t maxLineCount, QWidget *parent)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+LogWidget::~LogWidget()
+{
+	ANIM.CancelInvalidate(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void LogWidget::Clear()
 {
 	size_t prevNumLines = GetNumLines();
@@ -65,29 +76,36 @@ void LogWidget::Clear()
 	if(m_LineWidth != prevLineWidth)
 		UpdateHScrollBar();
 
-	update();
+	ANIM.Invalidate(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void LogWidget::Log(EosLog::LOG_Q &logQ)
+void LogWidget::Log(const LOG_RECORD_Q &records)
 {
-	if(logQ.empty() || m_Lines.empty())
+	if(records.empty() || m_Lines.empty())
 		return;
 
 	size_t prevNumLines = GetNumLines();
+	int prevLineWidth = m_LineWidth;
+
+	// lines that would be overwritten within this batch are never shaped
+	LOG_RECORD_Q::const_iterator i = records.begin();
+	size_t maxLineCount = (m_Lines.size() - 1);
+	if(records.size() > maxLineCount)
+		i += (records.size() - maxLineCount);
 
-	for(EosLog::LOG_Q::const_iterator i=logQ.begin(); i!=logQ.end(); i++)
+	for(; i!=records.end(); i++)
 	{
-		const EosLog::sLogMsg &msg = *i;
+		const sLogRecord &record = *i;
 
 		sLine &line = m_Lines[m_Index.tail];
 
-		if( msg.text.c_str() )
+		if( !record.line.isEmpty() )
 		{
-			line.text = QString::fromUtf8( msg.text.c_str() );
+			line.text.setText( record.line );
 
-			switch( msg.type )
+			switch( record.type )
 			{
 				case EosLog::LOG_MSG_TYPE_DEBUG:
 					line.color = MUTED_COLOR;
@@ -115,7 +133,11 @@ void LogWidget::Log(EosLog::LOG_Q &logQ)
 			}
 		}
 		else
-			line.text.clear();
+			line.text.setText( QString() );
+
+		PrepareLine(line);
+		if(line.width > m_LineWidth)
+			m_LineWidth = line.width;
 
 		if(++m_Index.tail >= m_Lines.size())
 			m_Index.tail = 0;
@@ -131,7 +153,10 @@ void LogWidget::Log(EosLog::LOG_Q &logQ)
 	if(GetNumLines() != prevNumLines)
 		UpdateVScrollBar();
 
-	update();
+	if(m_LineWidth != prevLineWidth)
+		UpdateHScrollBar();
+
+	ANIM.Invalidate(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -157,6 +182,55 @@ void LogWidget::GetContentsRect(QRect &r) const
 void LogWidget::UpdateFont()
 {
 	m_LineHeight = QFontMetrics( font() ).height();
+
+	// reshape existing lines in the new font
+	for(size_t i=m_Index.head; i!=m_Index.tail; )
+	{
+		PrepareLine( m_Lines[i] );
+		if(++i >= m_Lines.size())
+			i = 0;
+	}
+
+	UpdateLineWidth();
+
+	// font is first set during construction, before the scroll bars exist
+	if( m_VScrollBar )
+	{
+		UpdateVScrollBar();
+		UpdateHScrollBar();
+	}
+
+	ANIM.Invalidate(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogWidget::PrepareLine(sLine &line)
+{
+	if( line.text.text().isEmpty() )
+	{
+		line.width = 0;
+	}
+	else
+	{
+		line.text.setTextFormat(Qt::PlainText);
+		line.text.prepare(QTransform(), font());
+		line.width = static_cast<int>( ceil(line.text.size().width()) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void LogWidget::UpdateLineWidth()
+{
+	m_LineWidth = 0;
+	for(size_t i=m_Index.head; i!=m_Index.tail; )
+	{
+		if(m_Lines[i].width > m_LineWidth)
+			m_LineWidth = m_Lines[i].width;
+		if(++i >= m_Lines.size())
+			i = 0;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -238,6 +312,8 @@ void LogWidget::resizeEvent(QResizeEvent* /*event*/)
 
 void LogWidget::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("LogWidget::paintEvent");
+
 	QPainter painter(this);
 	painter.fillRect(QRect(0,0,width(),height()), palette().color(QPalette::Window));
 
@@ -249,8 +325,6 @@ void LogWidget::paintEvent(QPaintEvent* /*event*/)
 	int x = 0;
 	int y = 0;
 	int bottom = m_HScrollBar->y();
-	int maxLineWidth = 0;
-	QRect bounds;
 
 	size_t index = m_Index.head;
 
@@ -274,27 +348,20 @@ void LogWidget::paintEvent(QPaintEvent* /*event*/)
 
 	while(index != m_Index.tail)
 	{
-		const sLine &line = m_Lines[index];
-		QRect textRect(x, y, width()-x, m_LineHeight);
 		if(y > bottom)
 			break;
 
-		painter.setPen( line.color );
-		painter.drawText(textRect, Qt::AlignLeft, line.text, &bounds);
+		const sLine &line = m_Lines[index];
+		if(line.width > 0)
+		{
+			painter.setPen( line.color );
+			painter.drawStaticText(x, y, line.text);
+		}
 		y += m_LineHeight;
 
-		if(bounds.width() > maxLineWidth)
-			maxLineWidth = bounds.width();
-
 		if(++index >= m_Lines.size())
 			index = 0;
 	}
-
-	if(m_LineWidth < maxLineWidth)
-	{
-		m_LineWidth = maxLineWidth;
-		UpdateHScrollBar();
-	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -315,14 +382,14 @@ void LogWidget::wheelEvent(QWheelEvent *event)
 
 void LogWidget::onVScrollChanged(int /*value*/)
 {
-	update();
+	ANIM.Invalidate(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void LogWidget::onHScrollChanged(int /*value*/)
 {
-	update();
+	ANIM.Invalidate(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
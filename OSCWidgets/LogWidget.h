@@ -26,8 +26,8 @@
 #include "QtInclude.h"
 #endif
 
-#ifndef EOS_LOG_H
-#include "EosLog.h"
+#ifndef LOG_RECORD_H
+#include "LogRecord.h"
 #endif
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -39,9 +39,10 @@ class LogWidget
 
 public:
 	LogWidget(size_t maxLineCount, QWidget *parent);
+	virtual ~LogWidget();
 
 	virtual void Clear();
-	virtual void Log(EosLog::LOG_Q &logQ);
+	virtual void Log(const LOG_RECORD_Q &records);
 	virtual QSize sizeHint() const {return QSize(400,150);}
 
 private slots:
@@ -51,8 +52,12 @@ private slots:
 protected:
 	struct sLine
 	{
-		QString	text;
-		QColor	color;
+		sLine()
+			: width(0)
+		{}
+		QStaticText	text;	// shaped once on insert
+		QColor		color;
+		int			width;
 	};
 
 	typedef std::vector<sLine> RING_BUFFER;
@@ -81,6 +86,8 @@ protected:
 	virtual size_t GetNumLines() const;
 	virtual void GetContentsRect(QRect &r) const;
 	virtual void UpdateFont();
+	virtual void PrepareLine(sLine &line);
+	virtual void UpdateLineWidth();
 	virtual void UpdateVScrollBar();
 	virtual void UpdateHScrollBar();
 	virtual bool event(QEvent *event);
@@ -21,8 +21,11 @@
 #include "MainWindow.h"
 #include "SettingsPanel.h"
 #include "LogWidget.h"
+#include "MetricsPanel.h"
 #include "Utils.h"
 #include "EosPlatform.h"
+#include "AnimationDriver.h"
+#include "Trace.h"
 #include <time.h>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -64,6 +67,8 @@ void Logo::resizeEvent(QResizeEvent *event)
 
 void Logo::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("Logo::paintEvent");
+
 	if( !m_Scaled.isNull() )
 	{
 		QPainter painter(this);
@@ -180,16 +185,28 @@ MainWindow::MainWindow(EosPlatform *platform, QWidget* parent/*=0*/, Qt::WindowF
 	, m_Settings("ETC", "OSCWidgets")
 	, m_LogDepth(200)
 	, m_Unsaved(false)
-	, m_UdpOutThread(0)
-	, m_TcpClientThread(0)
+	, m_Engine(0)
+	, m_Toys(0)
 	, m_ToyTreeToyIndex(0)
 	, m_ToyTreeType(Toy::TOY_INVALID)
 	, m_CloseAllowed(0)
 	, m_pPlatform(platform)
 	, m_SystemIdleAllowed(true)
+	, m_PaintStatsLabel(0)
+	, m_MenuActionCaptureFile(0)
+	, m_MenuActionCaptureRing(0)
+	, m_Replay(0)
+	, m_ReplaySpeed(1.0)
+	, m_MetricsPanel(0)
+	, m_MenuActionShowMetrics(0)
+	, m_MenuActionExportMetrics(0)
+	, m_MetricsExportJSON(false)
 {
 	Utils::BlockFakeMouseEvents(true);
 
+	m_Replay = new PacketReplay(*this);
+	m_ReplaySpeed = m_Settings.value(SETTING_REPLAY_SPEED, m_ReplaySpeed).toDouble();
+
 	Toy::RestoreDefaultSettings();
 	Toy::SetDefaultWindowIcon( *this );
 
@@ -210,7 +227,9 @@ MainWindow::MainWindow(EosPlatform *platform, QWidget* parent/*=0*/, Qt::WindowF
 	LoadAdvancedSettings();
 	SaveAdvancedSettings();
 
-	m_LogFile.Initialize(QDir(QDir::tempPath()).absoluteFilePath("OSCWidgets.txt"), m_Settings.value(SETTING_FILE_DEPTH,10000).toInt());
+	int fileSizeKB = m_Settings.value(SETTING_FILE_SIZE_KB, 4096).toInt();
+	int fileCount = m_Settings.value(SETTING_FILE_COUNT, 4).toInt();
+	m_LogFile.Initialize(QDir(QDir::tempPath()).absoluteFilePath("OSCWidgets.txt"), static_cast<qint64>(fileSizeKB)*1024, fileCount);
 
 	QGridLayout *layout = new QGridLayout(this);
 
@@ -236,6 +255,7 @@ MainWindow::MainWindow(EosPlatform *platform, QWidget* parent/*=0*/, Qt::WindowF
 	
 	m_Advanced = new AdvancedPanel(this);
 	connect(m_Advanced, SIGNAL(changed()), this, SLOT(onAdvancedChanged()));
+	connect(m_Advanced, SIGNAL(showChanged()), this, SLOT(onToysChanged()));
 	m_Advanced->hide();
 	
 	m_ToyTree = new EosTreeWidget(this);
@@ -258,13 +278,26 @@ MainWindow::MainWindow(EosPlatform *platform, QWidget* parent/*=0*/, Qt::WindowF
 	QGridLayout *logLayout = new QGridLayout(logBase);
 	leftSplitter->addWidget(logBase);
 
-	m_LogWidget = new LogWidget(m_LogDepth, logBase);
-	logLayout->addWidget(m_LogWidget, 0, 0);
+	QSplitter *logSplitter = new QSplitter(Qt::Horizontal, logBase);
+	logLayout->addWidget(logSplitter, 0, 0);
+
+	m_LogWidget = new LogWidget(m_LogDepth, logSplitter);
+	logSplitter->addWidget(m_LogWidget);
+
+	m_MetricsPanel = new MetricsPanel(logSplitter);
+	logSplitter->addWidget(m_MetricsPanel);
+	m_MetricsPanel->setVisible(m_MenuActionShowMetrics && m_MenuActionShowMetrics->isChecked());
+
+	m_PaintStatsLabel = new QLabel(logBase);
+	m_PaintStatsLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+	logLayout->addWidget(m_PaintStatsLabel, 1, 0);
+	UpdatePaintStats();
 
 	m_Log.AddInfo( QString("OSCWidgets v%1").arg(APP_VERSION).toUtf8().constData() );
 	m_Log.AddDebug("Icons designed by Freepik: http://www.flaticon.com/packs/ios7-set-lined-1");
 	
-	m_Toys = new Toys(this, this);
+	m_Engine = new Engine(*this, m_Log, &m_Capture, this);
+	m_Toys = m_Engine->GetToys();
 	connect(m_Toys, SIGNAL(changed()), this, SLOT(onToysChanged()));
 	connect(m_Toys, SIGNAL(toggleMainWindow()), this, SLOT(onToysToggledMainWindow()));
 	if( m_MenuActionFrames )
@@ -274,10 +307,6 @@ MainWindow::MainWindow(EosPlatform *platform, QWidget* parent/*=0*/, Qt::WindowF
 	if( m_OpacityMenu )
 		m_OpacityMenu->SetOpacity( m_Toys->GetOpacity() );
 	
-	QTimer *timer = new QTimer(this);
-	connect(timer, SIGNAL(timeout()), this, SLOT(onTick()));
-	timer->start(100);
-
 	PopulateToyTree();
 	RestoreLastFile();
 	UpdateWindowTitle();
@@ -289,14 +318,18 @@ MainWindow::MainWindow(EosPlatform *platform, QWidget* parent/*=0*/, Qt::WindowF
 
 MainWindow::~MainWindow()
 {
-	Shutdown();
-	
-	if( m_Toys )
+	StopReplay();
+	delete m_Replay;
+	m_Replay = 0;
+
+	if( m_Engine )
 	{
-		delete m_Toys;
+		delete m_Engine;
+		m_Engine = 0;
 		m_Toys = 0;
 	}
 
+	m_Capture.Stop();
 	m_LogFile.Shutdown();
 
 	m_SystemTray->setContextMenu(0);
@@ -347,10 +380,67 @@ QMenuBar* MainWindow::InitMenuBar(bool systemMenuBar)
 
 	QMenu *oscMenu = menuBar->addMenu("&OSC");
 	oscMenu->addAction(QIcon(":/assets/images/MenuIconRefresh.png"), tr("&Clear OSC Labels"), this, SLOT(onMenuClearLabels()));
+	oscMenu->addSeparator();
+	m_MenuActionCaptureFile = oscMenu->addAction( tr("Capture to &File...") );
+	if( m_MenuActionCaptureFile )
+	{
+		m_MenuActionCaptureFile->setCheckable(true);
+		connect(m_MenuActionCaptureFile, SIGNAL(toggled(bool)), this, SLOT(onCaptureFileToggled(bool)));
+	}
+	m_MenuActionCaptureRing = oscMenu->addAction( tr("Capture &Recent Traffic") );
+	if( m_MenuActionCaptureRing )
+	{
+		m_MenuActionCaptureRing->setCheckable(true);
+		connect(m_MenuActionCaptureRing, SIGNAL(toggled(bool)), this, SLOT(onCaptureRingToggled(bool)));
+	}
+	oscMenu->addAction(tr("&Save Recent Traffic..."), this, SLOT(onSaveCaptureRingClicked()));
+	oscMenu->addSeparator();
+	oscMenu->addAction(tr("Replay &Inbound Capture..."), this, SLOT(onReplayInboundClicked()));
+	oscMenu->addAction(tr("Replay O&utbound Capture..."), this, SLOT(onReplayOutboundClicked()));
+	oscMenu->addAction(tr("S&top Replay"), this, SLOT(onStopReplayClicked()));
+	QMenu *replaySpeedMenu = oscMenu->addMenu( tr("Replay Speed") );
+	QActionGroup *replaySpeedGroup = new QActionGroup(replaySpeedMenu);
+	const double replaySpeeds[] = {0.5, 1.0, 2.0, 4.0, 10.0, 0};
+	for(size_t i=0; i<sizeof(replaySpeeds)/sizeof(replaySpeeds[0]); i++)
+	{
+		double speed = replaySpeeds[i];
+		QAction *action = replaySpeedMenu->addAction( (speed>0) ? tr("%1x").arg(speed) : tr("As Fast As Possible") );
+		action->setCheckable(true);
+		action->setData(speed);
+		action->setChecked( qFuzzyCompare(speed+1.0,m_ReplaySpeed+1.0) );
+		replaySpeedGroup->addAction(action);
+	}
+	connect(replaySpeedGroup, SIGNAL(triggered(QAction*)), this, SLOT(onReplaySpeedTriggered(QAction*)));
 
 	QMenu *logMenu = menuBar->addMenu("&Log");
 	logMenu->addAction(QIcon(":/assets/images/MenuIconRefresh.png"), tr("&Clear"), this, SLOT(onClearLogClicked()));
 	logMenu->addAction(QIcon(":/assets/images/MenuIconLog.png"), tr("&View"), this, SLOT(onOpenLogClicked()));
+	logMenu->addAction(tr("&Memory Report"), this, SLOT(onMemoryReportClicked()));
+	logMenu->addSeparator();
+	m_MenuActionShowMetrics = logMenu->addAction( tr("Show Me&trics") );
+	if( m_MenuActionShowMetrics )
+	{
+		m_MenuActionShowMetrics->setCheckable(true);
+		m_MenuActionShowMetrics->setChecked( m_Settings.value(SETTING_SHOW_METRICS,false).toBool() );
+		connect(m_MenuActionShowMetrics, SIGNAL(toggled(bool)), this, SLOT(onShowMetricsToggled(bool)));
+	}
+	QAction *latencyProbes = logMenu->addAction( tr("&Latency Probes") );
+	if( latencyProbes )
+	{
+		METRICS.SetLatencyProbes( m_Settings.value(SETTING_LATENCY_PROBES,false).toBool() );
+		latencyProbes->setCheckable(true);
+		latencyProbes->setChecked( METRICS.GetLatencyProbes() );
+		connect(latencyProbes, SIGNAL(toggled(bool)), this, SLOT(onLatencyProbesToggled(bool)));
+	}
+	m_MenuActionExportMetrics = logMenu->addAction( tr("&Export Metrics...") );
+	if( m_MenuActionExportMetrics )
+	{
+		m_MenuActionExportMetrics->setCheckable(true);
+		connect(m_MenuActionExportMetrics, SIGNAL(toggled(bool)), this, SLOT(onExportMetricsToggled(bool)));
+	}
+#ifdef OSCWIDGETS_TRACE
+	logMenu->addAction(tr("Save T&race..."), this, SLOT(onSaveTraceClicked()));
+#endif
 
 	return (systemMenuBar ? 0 : menuBar);
 }
@@ -361,91 +451,24 @@ void MainWindow::FlushLogQ(EosLog::LOG_Q &logQ)
 {
 	if( !logQ.empty() )
 	{
-		// add timestamp text
-		for(EosLog::LOG_Q::iterator i=logQ.begin(); i!=logQ.end(); i++)
-		{
-			EosLog::sLogMsg &logMsg = *i;
-
-			tm *t = localtime( &logMsg.timestamp );
-
-			QString msgText;
-			if( logMsg.text.c_str() )
-				msgText = QString::fromUtf8( logMsg.text.c_str() );
-
-			QString itemText = QString("[%1:%2:%3] %4")
-				.arg(t->tm_hour, 2)
-				.arg(t->tm_min, 2, 10, QChar('0'))
-				.arg(t->tm_sec, 2, 10, QChar('0'))
-				.arg( msgText );
-
-			logMsg.text = itemText.toUtf8().constData();
-		}
+		// format each line once, shared by widget and file
+		m_LogFormatter.Format(logQ, m_LogRecordQ);
 
 		// add to widget
-		m_LogWidget->Log(logQ);
+		m_LogWidget->Log(m_LogRecordQ);
 
 		// add to file
-		m_LogFile.Log(logQ);
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void MainWindow::Shutdown()
-{
-	if( m_TcpClientThread )
-	{
-		m_TcpClientThread->Stop();
-		ClearRecvQ();
-		ClearNetEventQ();
-		m_TcpClientThread->Flush(m_TempLogQ, m_RecvQ, m_NetEventQ);
-		m_Log.AddQ(m_TempLogQ);
-		delete m_TcpClientThread;
-		m_TcpClientThread = 0;
-	}
-	
-	for(UDP_IN_THREADS::const_iterator i=m_UdpInThreads.begin(); i!=m_UdpInThreads.end(); i++)
-	{
-		EosUdpInThread *udpInThread = *i;
+		m_LogFile.Log(m_LogRecordQ);
 
-		udpInThread->Stop();
-		ClearRecvQ();
-		udpInThread->Flush(m_TempLogQ, m_RecvQ);
-		m_Log.AddQ(m_TempLogQ);
-
-		delete udpInThread;
+		m_LogRecordQ.clear();
 	}
-	m_UdpInThreads.clear();
-	
-	if( m_UdpOutThread )
-	{
-		m_UdpOutThread->Stop();
-		ClearRecvQ();
-		ClearNetEventQ();
-		m_UdpOutThread->Flush(m_TempLogQ, m_NetEventQ);
-		m_Log.AddQ(m_TempLogQ);
-		delete m_UdpOutThread;
-		m_UdpOutThread = 0;
-	}
-	
-	ClearRecvQ();
-	ClearNetEventQ();
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void MainWindow::ClearRecvQ()
-{
-	for(PACKET_Q::const_iterator i=m_RecvQ.begin(); i!=m_RecvQ.end(); i++)
-		delete[] i->data;
-	m_RecvQ.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void MainWindow::ClearNetEventQ()
+void MainWindow::Shutdown()
 {
-	m_NetEventQ.clear();
+	m_Engine->Shutdown();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -476,25 +499,17 @@ void MainWindow::UpdateWindowTitle()
 
 bool MainWindow::LoadFile(const QString &path, bool setLastFile)
 {
-	QFile f(path);
-	if( f.open(QIODevice::ReadOnly|QIODevice::Text) )
+	QStringList lines;
+	if( Engine::ReadShowFile(path,lines) )
 	{
-		QStringList lines;
-		{
-			QTextStream textStream( &f );
-			QString contents( textStream.readAll() );
-			contents.remove('\r');
-			lines = contents.split('\n',QString::KeepEmptyParts);
-		}
-
-		f.close();
-
 		m_FilePath = path;
+		m_Engine->SetShowPath(m_FilePath);
 		m_Log.AddInfo( tr("Loaded \"%1\"").arg(QDir::toNativeSeparators(m_FilePath)).toUtf8().constData() );
 		
 		int lineIndex = 0;
 		LoadSettings(lines, lineIndex);
 		m_Toys->Load(m_Log, path, lines, lineIndex);
+		LogMemoryUsage();
 		Start();
 
 		if( setLastFile )
@@ -538,6 +553,7 @@ bool MainWindow::SaveFile(const QString &path, bool setLastFile)
 		f.close();
 
 		m_FilePath = path;
+		m_Engine->SetShowPath(m_FilePath);
 
 		if( setLastFile )
 		{
@@ -601,6 +617,7 @@ bool MainWindow::SaveSettings(QStringList &lines)
 	line.append( QString(", %1").arg(static_cast<int>(m_Toys->GetFramesEnabled()?1:0)) );
 	line.append( QString(", %1").arg(static_cast<int>(m_Toys->GetTopMost()?1:0)) );
 	line.append( QString(", %1").arg(m_Toys->GetOpacity()) );
+	line.append( QString(", %1").arg(Toy::GetFlickerSeed()) );
 	
 	lines << line;
 	
@@ -613,25 +630,17 @@ bool MainWindow::LoadSettings(QStringList &lines, int &index)
 {
 	if(index>=0 && index<lines.size())
 	{
+		Engine::sNetworkSettings networkSettings;
+		networkSettings.mode = m_SettingsPanel->GetMode();
+		m_SettingsPanel->GetIP(networkSettings.ip);
+		networkSettings.port1 = m_SettingsPanel->GetPort1();
+		networkSettings.port2 = m_SettingsPanel->GetPort2();
 		QStringList items;
-		Utils::GetItemsFromQuotedString(lines[index++], items);
-		
-		if(items.size() > 0)
-		{
-			int n = items[0].toInt();
-			if(n<0 || n>=OSCStream::FRAME_MODE_COUNT)
-				n = OSCStream::FRAME_MODE_INVALID;
-			m_SettingsPanel->SetMode( static_cast<OSCStream::EnumFrameMode>(n) );
-		}
-		
-		if(items.size() > 1)
-			m_SettingsPanel->SetIP( items[1] );
-		
-		if(items.size() > 2)
-			m_SettingsPanel->SetPort1( items[2].toUShort() );
-		
-		if(items.size() > 3)
-			m_SettingsPanel->SetPort2( items[3].toUShort() );
+		Engine::LoadShowSettings(lines[index++], networkSettings, items);
+		m_SettingsPanel->SetMode(networkSettings.mode);
+		m_SettingsPanel->SetIP(networkSettings.ip);
+		m_SettingsPanel->SetPort1(networkSettings.port1);
+		m_SettingsPanel->SetPort2(networkSettings.port2);
 		
 		if(m_MenuActionFrames && items.size()>4)
 			m_MenuActionFrames->setChecked(items[4].toInt() != 0);
@@ -657,105 +666,24 @@ bool MainWindow::LoadSettings(QStringList &lines, int &index)
 
 void MainWindow::Start()
 {
-	Shutdown();
-	
-	OSCStream::EnumFrameMode mode = m_SettingsPanel->GetMode();
-
-	QString ip;
-	m_SettingsPanel->GetIP(ip);
+	Engine::sNetworkSettings settings;
+	settings.mode = m_SettingsPanel->GetMode();
+	m_SettingsPanel->GetIP(settings.ip);
 
-	switch( mode )
+	switch( settings.mode )
 	{
 		case OSCStream::FRAME_MODE_1_0:
 		case OSCStream::FRAME_MODE_1_1:
-			{
-				m_TcpClientThread = new EosTcpClientThread();
-				m_TcpClientThread->Start(ip, m_SettingsPanel->GetTcpPort(), mode);
-			}
+			settings.port1 = m_SettingsPanel->GetTcpPort();
 			break;
-			
+
 		default:
-			{
-				m_UdpOutThread = new EosUdpOutThread();
-				m_UdpOutThread->Start(ip, m_SettingsPanel->GetUdpOutputPort());
-				
-				StartUdpInThreads(ip, m_SettingsPanel->GetUdpInputPort());
-			}
+			settings.port1 = m_SettingsPanel->GetUdpOutputPort();
+			settings.port2 = m_SettingsPanel->GetUdpInputPort();
 			break;
 	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
 
-void MainWindow::StartUdpInThreads(const QString &ip, unsigned short port)
-{
-	QHostAddress remoteAddr(ip);
-
-	if(remoteAddr.toIPv4Address() == QHostAddress(QHostAddress::LocalHost).toIPv4Address())
-	{
-		EosUdpInThread *udpInThread = new EosUdpInThread();
-		udpInThread->Start(ip, port);
-		m_UdpInThreads.push_back(udpInThread);
-	}
-	else
-	{
-		// 1 input thread per applicable network interface
-		QList<QNetworkInterface> allNics = QNetworkInterface::allInterfaces();
-		for(QList<QNetworkInterface>::const_iterator i=allNics.begin(); i!=allNics.end(); i++)
-		{
-			const QNetworkInterface &nic = *i;
-			if(nic.isValid() && nic.flags().testFlag(QNetworkInterface::IsUp))
-			{
-				QList<QNetworkAddressEntry> addrs = nic.addressEntries();
-				for(QList<QNetworkAddressEntry>::const_iterator j=addrs.begin(); j!=addrs.end(); j++)
-				{
-					QHostAddress addr = j->ip();
-					if(	!addr.isNull() &&
-						addr.protocol()==QAbstractSocket::IPv4Protocol &&
-						remoteAddr.isInSubnet(addr,j->prefixLength()) )
-					{
-						EosUdpInThread *udpInThread = new EosUdpInThread();
-						udpInThread->Start(j->ip().toString(), port);
-						m_UdpInThreads.push_back(udpInThread);
-					}
-				}
-			}
-		}
-	}
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void MainWindow::ProcessRecvQ()
-{
-	for(PACKET_Q::const_iterator i=m_RecvQ.begin(); i!=m_RecvQ.end(); i++)
-	{
-		m_Toys->Recv(i->data, i->size);
-		delete[] i->data;
-	}
-	
-	m_RecvQ.clear();
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void MainWindow::ProcessNetEventQ()
-{
-	for(NETEVENT_Q::const_iterator i=m_NetEventQ.begin(); i!=m_NetEventQ.end(); i++)
-	{
-		switch( *i )
-		{
-			case NET_EVENT_CONNECTED:
-				m_Toys->Connected();
-				break;
-				
-			case NET_EVENT_DISCONNECTED:
-				m_Toys->Disconnected();
-				break;
-		}
-	}
-	
-	m_NetEventQ.clear();
+	m_Engine->Start(settings);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -840,14 +768,7 @@ void MainWindow::PopulateToyTree()
 
 void MainWindow::LoadAdvancedSettings()
 {
-	float degrees = (Toy::GetEncoderRadiansPerTick() * (180/M_PI));
-	float radians = (m_Settings.value(SETTING_ENCODER_DEGREES_PER_TICK,degrees).toFloat() * (M_PI/180));
-	Toy::SetEncoderRadiansPerTick(radians);
-	Toy::SetFeedbackDelayMS( m_Settings.value(SETTING_FEEDBACK_DELAY,Toy::GetFeedbackDelayMS()).toUInt() );
-	Toy::SetCmdSendAllDelayMS( m_Settings.value(SETTING_CMD_SEND_ALL_DELAY,Toy::GetCmdSendAllDelayMS()).toUInt() );
-	Toy::SetMetroRefreshRateMS( m_Settings.value(SETTING_METRO_REFRESH_RATE,Toy::GetMetroRefreshRateMS()).toUInt() );
-	Toy::SetSineRefreshRateMS( m_Settings.value(SETTING_SINE_REFRESH_RATE,Toy::GetSineRefreshRateMS()).toUInt() );
-	Toy::SetPedalRefreshRateMS( m_Settings.value(SETTING_PEDAL_REFRESH_RATE,Toy::GetPedalRefreshRateMS()).toUInt() );
+	Engine::LoadAdvancedSettings(m_Settings);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -861,6 +782,12 @@ void MainWindow::SaveAdvancedSettings()
 	m_Settings.setValue(SETTING_METRO_REFRESH_RATE, Toy::GetMetroRefreshRateMS());
 	m_Settings.setValue(SETTING_SINE_REFRESH_RATE, Toy::GetSineRefreshRateMS());
 	m_Settings.setValue(SETTING_PEDAL_REFRESH_RATE, Toy::GetPedalRefreshRateMS());
+	m_Settings.setValue(SETTING_SINE_SEND_RATE, Toy::GetSineSendRateMS());
+	m_Settings.setValue(SETTING_PEDAL_SEND_RATE, Toy::GetPedalSendRateMS());
+	m_Settings.setValue(SETTING_FLICKER_SEND_RATE, Toy::GetFlickerSendRateMS());
+	m_Settings.setValue(SETTING_SEND_EPSILON, Toy::GetSendEpsilon());
+	m_Settings.setValue(SETTING_CELL_GRID_THRESHOLD, Toy::GetCellGridThreshold());
+	m_Settings.setValue(SETTING_IMAGE_CACHE_MB, Toy::GetImageCacheMB());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -897,42 +824,42 @@ void MainWindow::PromptForUnsavedChanges(bool &abortPendingOperation)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void MainWindow::onTick()
+bool MainWindow::EngineClient_Tick()
 {
-	if( m_UdpOutThread )
-	{
-		ClearRecvQ();
-		ClearNetEventQ();
-		m_UdpOutThread->Flush(m_TempLogQ, m_NetEventQ);
-		m_Log.AddQ(m_TempLogQ);
-		ProcessNetEventQ();
-		ProcessRecvQ();
-	}
-	
-	for(UDP_IN_THREADS::const_iterator i=m_UdpInThreads.begin(); i!=m_UdpInThreads.end(); i++)
-	{
-		ClearRecvQ();
-		(*i)->Flush(m_TempLogQ, m_RecvQ);
-		m_Log.AddQ(m_TempLogQ);
-		ProcessRecvQ();
-	}
-	
-	if( m_TcpClientThread )
-	{
-		ClearRecvQ();
-		ClearNetEventQ();
-		m_TcpClientThread->Flush(m_TempLogQ, m_RecvQ, m_NetEventQ);
-		m_Log.AddQ(m_TempLogQ);
-		ProcessNetEventQ();
-		ProcessRecvQ();
-	}
-
 	m_Log.Flush(m_TempLogQ);
+	bool active = !m_TempLogQ.empty();
 	FlushLogQ(m_TempLogQ);
 	m_TempLogQ.clear();
-	
-	ClearRecvQ();
-	ClearNetEventQ();
+
+	UpdatePaintStats();
+	UpdateMetrics();
+
+	return active;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::UpdatePaintStats()
+{
+	if( m_PaintStatsLabel )
+	{
+		const AnimationDriver::sPaintStats &stats = ANIM.GetPaintStats();
+		QString text( tr("paints/sec: %1   paint time: %2 ms/sec (%3 us avg)   pending: %4")
+			.arg(stats.paintsPerSec)
+			.arg(stats.paintMSPerSec, 0, 'f', 1)
+			.arg(stats.avgPaintUS, 0, 'f', 0)
+			.arg(stats.dirty) );
+
+		const qint64 MB = (1024 * 1024);
+		if(PMC.GetBudget() > 0)
+			text.append( tr("   images: %1 of %2 MB").arg(PMC.GetBytes()/static_cast<double>(MB),0,'f',1).arg(PMC.GetBudget()/MB) );
+		else
+			text.append( tr("   images: %1 MB").arg(PMC.GetBytes()/static_cast<double>(MB),0,'f',1) );
+		if(PMC.GetEvictions() != 0)
+			text.append( tr(" (%1 evicted)").arg(PMC.GetEvictions()) );
+		if(m_PaintStatsLabel->text() != text)
+			m_PaintStatsLabel->setText(text);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -945,7 +872,9 @@ void MainWindow::onNewFileClicked()
 	{
 		Shutdown();
 		m_Toys->Clear();
+		Toy::SetFlickerSeed(0);
 		m_FilePath.clear();
+		m_Engine->SetShowPath(m_FilePath);
 		m_Settings.setValue(SETTING_LAST_FILE, m_FilePath);
 		QString path;
 		GetPersistentSavePath(path);
@@ -1036,6 +965,322 @@ void MainWindow::onOpenLogClicked()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void MainWindow::onMemoryReportClicked()
+{
+	LogMemoryUsage();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::LogMemoryUsage()
+{
+	ToyWidget::sMemoryUsage usage;
+	m_Toys->GetMemoryUsage(usage);
+	
+	QString msg = tr("Memory: %1 toys, %2 widgets (%3 drawn as cells), %4 child widgets, %5 KB property text (%6 KB unshared)")
+		.arg(usage.toys)
+		.arg(usage.widgets)
+		.arg(usage.cells)
+		.arg(usage.childWidgets)
+		.arg(usage.textBytes/1024.0, 0, 'f', 1)
+		.arg(usage.unsharedTextBytes/1024.0, 0, 'f', 1);
+	m_Log.AddInfo( msg.toUtf8().constData() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onCaptureFileToggled(bool b)
+{
+	if( b )
+	{
+		StopCapture();
+
+		QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+		QString path = QFileDialog::getSaveFileName(this, tr("Capture to File"), dir, tr("OSC Capture (*.osccapture)"), 0, QFileDialog::DontUseNativeDialog);
+		if( !path.isEmpty() )
+		{
+			if( m_Capture.StartFile(path) )
+			{
+				m_Log.AddInfo( tr("Capturing OSC to \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+				return;
+			}
+
+			m_Log.AddError( tr("Unable to open capture file \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+		}
+
+		m_MenuActionCaptureFile->blockSignals(true);
+		m_MenuActionCaptureFile->setChecked(false);
+		m_MenuActionCaptureFile->blockSignals(false);
+	}
+	else if(m_Capture.GetMode() == PacketCapture::MODE_FILE)
+		StopCapture();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onCaptureRingToggled(bool b)
+{
+	if( b )
+	{
+		StopCapture();
+
+		int seconds = m_Settings.value(SETTING_CAPTURE_RING_SECONDS, 60).toInt();
+		m_Capture.StartRing(seconds);
+		m_Log.AddInfo( tr("Capturing the last %1 seconds of OSC").arg(seconds).toUtf8().constData() );
+	}
+	else if(m_Capture.GetMode() == PacketCapture::MODE_RING)
+		StopCapture();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onSaveCaptureRingClicked()
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+	QString path = QFileDialog::getSaveFileName(this, tr("Save Recent Traffic"), dir, tr("OSC Capture (*.osccapture)"), 0, QFileDialog::DontUseNativeDialog);
+	if( !path.isEmpty() )
+	{
+		if( m_Capture.SaveRing(path) )
+			m_Log.AddInfo( tr("Saved recent OSC to \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+		else
+			m_Log.AddError( tr("Unable to save capture file \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onReplayInboundClicked()
+{
+	StartReplay(PacketCapture::DIRECTION_IN);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onReplayOutboundClicked()
+{
+	StartReplay(PacketCapture::DIRECTION_OUT);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onStopReplayClicked()
+{
+	StopReplay();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onReplaySpeedTriggered(QAction *action)
+{
+	if( action )
+	{
+		m_ReplaySpeed = action->data().toDouble();
+		m_Settings.setValue(SETTING_REPLAY_SPEED, m_ReplaySpeed);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::StartReplay(PacketCapture::EnumDirection direction)
+{
+	StopReplay();
+
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+	QString path = QFileDialog::getOpenFileName(this, tr("Replay Capture"), dir, tr("OSC Capture (*.osccapture)\nAll Files (*)"), 0, QFileDialog::DontUseNativeDialog);
+	if( path.isEmpty() )
+		return;
+
+	if( m_Replay->Start(path,direction,m_ReplaySpeed) )
+	{
+		QString speed = ((m_ReplaySpeed>0) ? tr("%1x").arg(m_ReplaySpeed) : tr("as fast as possible"));
+		m_Log.AddInfo( tr("Replaying %1 %2 packets from \"%3\" at %4")
+			.arg(m_Replay->GetCount())
+			.arg((direction==PacketCapture::DIRECTION_IN) ? tr("inbound") : tr("outbound"))
+			.arg(QDir::toNativeSeparators(path))
+			.arg(speed).toUtf8().constData() );
+	}
+	else
+		m_Log.AddError( tr("Unable to replay capture file \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::StopReplay()
+{
+	if(m_Replay && m_Replay->IsRunning())
+	{
+		if(m_Replay->GetDirection() == PacketCapture::DIRECTION_OUT)
+			m_Engine->CancelSends(m_Replay);
+
+		m_Log.AddInfo( tr("Replay stopped after %1 of %2 packets").arg(m_Replay->GetPosition()).arg(m_Replay->GetCount()).toUtf8().constData() );
+		m_Replay->Stop();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::PacketReplayClient_Recv(char *data, size_t size)
+{
+	m_Toys->Recv(data, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool MainWindow::PacketReplayClient_Send(char *data, size_t size, qint64 dueNS)
+{
+	return m_Engine->SendAt(data, size, dueNS, m_Replay);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::PacketReplayClient_Finished()
+{
+	qint64 elapsedNS = m_Replay->GetElapsedNS();
+	double seconds = (elapsedNS * 0.000000001);
+	m_Log.AddInfo( tr("Replay finished: %1 packets in %2 sec (%3 packets/sec)")
+		.arg(m_Replay->GetCount())
+		.arg(seconds, 0, 'f', 3)
+		.arg((seconds>0) ? (m_Replay->GetCount()/seconds) : 0, 0, 'f', 0).toUtf8().constData() );
+	m_Replay->Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onShowMetricsToggled(bool b)
+{
+	m_Settings.setValue(SETTING_SHOW_METRICS, b);
+
+	if( m_MetricsPanel )
+		m_MetricsPanel->setVisible(b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onLatencyProbesToggled(bool b)
+{
+	m_Settings.setValue(SETTING_LATENCY_PROBES, b);
+	METRICS.SetLatencyProbes(b);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onExportMetricsToggled(bool b)
+{
+	if( m_MetricsExportFile.isOpen() )
+	{
+		m_Log.AddInfo( tr("Stopped exporting metrics to \"%1\"").arg(QDir::toNativeSeparators(m_MetricsExportFile.fileName())).toUtf8().constData() );
+		m_MetricsExportFile.close();
+	}
+
+	if( !b )
+		return;
+
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+	QString path = QFileDialog::getSaveFileName(this, tr("Export Metrics"), dir, tr("CSV (*.csv)\nJSON Lines (*.json)"), 0, QFileDialog::DontUseNativeDialog);
+	if( !path.isEmpty() )
+	{
+		m_MetricsExportFile.setFileName(path);
+		if( m_MetricsExportFile.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		{
+			m_MetricsExportJSON = path.endsWith(".json", Qt::CaseInsensitive);
+			if( !m_MetricsExportJSON )
+			{
+				QByteArray header;
+				Metrics::GetCSVHeader(header);
+				m_MetricsExportFile.write(header);
+			}
+
+			m_Log.AddInfo( tr("Exporting metrics every second to \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+			return;
+		}
+
+		m_Log.AddError( tr("Unable to open metrics file \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+	}
+
+	m_MenuActionExportMetrics->blockSignals(true);
+	m_MenuActionExportMetrics->setChecked(false);
+	m_MenuActionExportMetrics->blockSignals(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::onSaveTraceClicked()
+{
+#ifdef OSCWIDGETS_TRACE
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+	QString path = QFileDialog::getSaveFileName(this, tr("Save Trace"), dir, tr("Chrome Trace (*.json)"), 0, QFileDialog::DontUseNativeDialog);
+	if( path.isEmpty() )
+		return;
+
+	if( Trace::Save(path) )
+		m_Log.AddInfo( tr("Saved trace to \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+	else
+		m_Log.AddError( tr("Unable to save trace to \"%1\"").arg(QDir::toNativeSeparators(path)).toUtf8().constData() );
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::UpdateMetrics()
+{
+	// once a second, so rates and histograms cover a fixed interval
+	if(Utils::GetTimeNS()-m_MetricsSnapshot.timeNS < 1000000000)
+		return;
+
+	Metrics::sSnapshot snapshot;
+	METRICS.TakeSnapshot(snapshot);
+
+	if(m_MetricsSnapshot.timeNS != 0)
+	{
+		Metrics::sSnapshot interval;
+		Metrics::GetInterval(snapshot, m_MetricsSnapshot, interval);
+
+		if(m_MetricsPanel && m_MetricsPanel->isVisible())
+			m_MetricsPanel->Update(interval);
+
+		if( m_MetricsExportFile.isOpen() )
+		{
+			QByteArray line;
+			if( m_MetricsExportJSON )
+				Metrics::GetJSONLine(interval, QDateTime::currentMSecsSinceEpoch(), line);
+			else
+				Metrics::GetCSVLine(interval, QDateTime::currentMSecsSinceEpoch(), line);
+			m_MetricsExportFile.write(line);
+			m_MetricsExportFile.flush();
+		}
+	}
+
+	m_MetricsSnapshot = snapshot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MainWindow::StopCapture()
+{
+	PacketCapture::EnumMode mode = m_Capture.GetMode();
+	if(mode == PacketCapture::MODE_OFF)
+		return;
+
+	m_Capture.Stop();
+
+	quint64 packets = 0;
+	quint64 bytes = 0;
+	quint64 dropped = 0;
+	m_Capture.GetStats(packets, bytes, dropped);
+	m_Log.AddInfo( tr("Capture stopped: %1 packets, %2 KB (%3 dropped)").arg(packets).arg(bytes/1024.0, 0, 'f', 1).arg(dropped).toUtf8().constData() );
+
+	// only one capture mode runs at a time
+	QAction *action = ((mode==PacketCapture::MODE_FILE) ? m_MenuActionCaptureFile : m_MenuActionCaptureRing);
+	if( action )
+	{
+		action->blockSignals(true);
+		action->setChecked(false);
+		action->blockSignals(false);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
 	if(m_CloseAllowed != 0)
@@ -1081,6 +1326,7 @@ void MainWindow::onSettingsChanged()
 
 void MainWindow::onAdvancedClicked()
 {
+	m_Advanced->Load();
 	m_Advanced->show();
 }
 
@@ -1090,6 +1336,7 @@ void MainWindow::onAdvancedChanged()
 {
 	SaveAdvancedSettings();
 	m_Toys->RefreshAdvancedSettings();
+	PMC.SetBudget(static_cast<qint64>(Toy::GetImageCacheMB()) * 1024 * 1024);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1294,49 +1541,6 @@ void MainWindow::onSystemTrayActivated(QSystemTrayIcon::ActivationReason reason)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-bool MainWindow::ToyClient_Send(bool local, char *buf, size_t size)
-{
-	if(buf && size!=0)
-	{
-		if( local )
-		{
-			m_Toys->Recv(buf, size);
-			delete[] buf;
-			return true;
-		}
-		else
-		{
-			sPacket packet;
-			packet.data = buf;
-			packet.size = size;
-			
-			if( m_UdpOutThread )
-			{
-				if( m_UdpOutThread->Send(packet) )
-					return true;
-			}
-			else if( m_TcpClientThread )
-			{
-				if( m_TcpClientThread->Send(packet) )
-					return true;
-			}
-
-			delete[] buf;
-		}
-	}
-	
-	return false;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void MainWindow::ToyClient_ResourceRelativePathToAbsolute(QString &path)
-{
-	Toy::ResourceRelativePathToAbsolute(&m_Log, m_FilePath,	path);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
 void MainWindow::SetSystemIdleAllowed(bool b)
 {
 	if(m_SystemIdleAllowed != b)
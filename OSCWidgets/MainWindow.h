@@ -30,19 +30,24 @@
 #include "EosLog.h"
 #endif
 
-#ifndef TOYS_H
-#include "Toys.h"
-#endif
-
-#ifndef NETWORK_THREADS_H
-#include "NetworkThreads.h"
+#ifndef ENGINE_H
+#include "Engine.h"
 #endif
 
 #ifndef LOG_FILE_H
 #include "LogFile.h"
 #endif
 
+#ifndef PACKET_REPLAY_H
+#include "PacketReplay.h"
+#endif
+
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
 class LogWidget;
+class MetricsPanel;
 class EosPlatform;
 class SettingsPanel;
 class AdvancedPanel;
@@ -128,7 +133,8 @@ protected:
 
 class MainWindow
 	: public QWidget
-	, private Toy::Client
+	, private Engine::Client
+	, private PacketReplay::Client
 {
 	Q_OBJECT
 
@@ -142,13 +148,24 @@ protected:
 	virtual void closeEvent(QCloseEvent *event);
 
 private slots:
-	void onTick();
 	void onNewFileClicked();
 	void onOpenFileClicked();
 	void onSaveFileClicked();
 	void onSaveAsFileClicked();
 	void onClearLogClicked();
 	void onOpenLogClicked();
+	void onMemoryReportClicked();
+	void onCaptureFileToggled(bool b);
+	void onCaptureRingToggled(bool b);
+	void onSaveCaptureRingClicked();
+	void onReplayInboundClicked();
+	void onReplayOutboundClicked();
+	void onStopReplayClicked();
+	void onReplaySpeedTriggered(QAction *action);
+	void onShowMetricsToggled(bool b);
+	void onLatencyProbesToggled(bool b);
+	void onExportMetricsToggled(bool b);
+	void onSaveTraceClicked();
 	void onSettingsChanged();
 	void onAdvancedClicked();
 	void onAdvancedChanged();
@@ -179,14 +196,26 @@ private:
 		TOY_TREE_ROLE_TOY_TYPE
 	};
 
-	typedef std::vector<EosUdpInThread*> UDP_IN_THREADS;
-
 	EosLog				m_Log;
 	EosLog::LOG_Q		m_TempLogQ;
+	LOG_RECORD_Q		m_LogRecordQ;
+	LogRecordFormatter	m_LogFormatter;
 	LogWidget			*m_LogWidget;
+	QLabel				*m_PaintStatsLabel;
 	QSettings			m_Settings;
 	int					m_LogDepth;
 	LogFile				m_LogFile;
+	PacketCapture		m_Capture;
+	QAction				*m_MenuActionCaptureFile;
+	QAction				*m_MenuActionCaptureRing;
+	PacketReplay		*m_Replay;
+	double				m_ReplaySpeed;
+	MetricsPanel		*m_MetricsPanel;
+	QAction				*m_MenuActionShowMetrics;
+	QAction				*m_MenuActionExportMetrics;
+	Metrics::sSnapshot	m_MetricsSnapshot;
+	QFile				m_MetricsExportFile;
+	bool				m_MetricsExportJSON;
 	QString				m_FilePath;
 	bool				m_Unsaved;
 	QAction				*m_MenuActionFrames;
@@ -194,12 +223,8 @@ private:
 	OpacityMenu			*m_OpacityMenu;
 	SettingsPanel		*m_SettingsPanel;
 	AdvancedPanel		*m_Advanced;
-	EosUdpOutThread		*m_UdpOutThread;
-	UDP_IN_THREADS		m_UdpInThreads;
-	EosTcpClientThread	*m_TcpClientThread;
-	PACKET_Q			m_RecvQ;
-	NETEVENT_Q			m_NetEventQ;
 	EosTreeWidget		*m_ToyTree;
+	Engine				*m_Engine;
 	Toys				*m_Toys;
 	size_t				m_ToyTreeToyIndex;
 	Toy::EnumToyType	m_ToyTreeType;
@@ -210,7 +235,6 @@ private:
 	bool				m_SystemIdleAllowed;
 
 	virtual void Start();
-	virtual void StartUdpInThreads(const QString &ip, unsigned short port);
 	virtual void Shutdown();
 	virtual void GetPersistentSavePath(QString &path) const;
 	virtual void UpdateWindowTitle();
@@ -219,12 +243,7 @@ private:
 	virtual bool SaveFile(const QString &path, bool setLastFile);
 	virtual bool SaveSettings(QStringList &lines);
 	virtual bool LoadSettings(QStringList &lines, int &index);
-	virtual void ClearRecvQ();
-	virtual void ProcessRecvQ();
-	virtual void ClearNetEventQ();
-	virtual void ProcessNetEventQ();
-	virtual bool ToyClient_Send(bool local, char *data, size_t size);
-	virtual void ToyClient_ResourceRelativePathToAbsolute(QString &path);
+	virtual bool EngineClient_Tick();
 	virtual void PopulateToyTree();
 	virtual void MakeToyIcon(const Toy &toy, const QSize &iconSize, QIcon &icon) const;
 	virtual void LoadAdvancedSettings();
@@ -232,6 +251,15 @@ private:
 	virtual void PromptForUnsavedChanges(bool &abortPendingOperation);
 	virtual QMenuBar* InitMenuBar(bool systemMenuBar);
 	virtual void SetSystemIdleAllowed(bool b);
+	virtual void UpdatePaintStats();
+	virtual void LogMemoryUsage();
+	virtual void StopCapture();
+	virtual void StartReplay(PacketCapture::EnumDirection direction);
+	virtual void StopReplay();
+	virtual void PacketReplayClient_Recv(char *data, size_t size);
+	virtual bool PacketReplayClient_Send(char *data, size_t size, qint64 dueNS);
+	virtual void PacketReplayClient_Finished();
+	virtual void UpdateMetrics();
 };
 
 ////////////////////////////////////////////////////////////////////////////////
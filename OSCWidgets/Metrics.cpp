@@ -0,0 +1,535 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Metrics.h"
+#include "Utils.h"
+#include "Toy.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define PAINT_PROBE_STALE_NS	Q_INT64_C(1000000000)	// a receive that never caused a paint
+
+Q_STATIC_ASSERT(Toy::TOY_COUNT <= Metrics::LATENCY_SOURCE_COUNT);
+
+Metrics *Metrics::sm_Instance = 0;
+qint64 Metrics::InputScope::sm_TimeNS = 0;
+int Metrics::InputScope::sm_Source = -1;
+qint64 Metrics::RecvScope::sm_RecvNS = 0;
+int Metrics::RecvScope::sm_Source = -1;
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::sHistogram::sHistogram()
+	: count(0)
+	, sum(0)
+	, max(0)
+{
+	memset(buckets, 0, sizeof(buckets));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::sHistogram::Add(qint64 value)
+{
+	// single threaded use, the shared histograms go through RecordValue
+	if(value < 0)
+		value = 0;
+
+	count++;
+	sum += value;
+	buckets[GetBucket(value)]++;
+	if(value > max)
+		max = value;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int Metrics::sHistogram::GetBucket(qint64 value)
+{
+	int bucket = 0;
+	for(quint64 v=static_cast<quint64>(qMax(static_cast<qint64>(0),value)); v!=0 && bucket<BUCKET_COUNT-1; v>>=1)
+		bucket++;
+	return bucket;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+double Metrics::sHistogram::GetMean() const
+{
+	return ((count==0) ? 0 : (sum/static_cast<double>(count)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 Metrics::sHistogram::GetPercentile(double p) const
+{
+	if(count == 0)
+		return 0;
+
+	// upper bound of the bucket holding the p'th value, never above the observed max
+	quint64 target = static_cast<quint64>(ceil(count * qBound(0.0,p,1.0)));
+	quint64 n = 0;
+	for(int i=0; i<BUCKET_COUNT; i++)
+	{
+		n += buckets[i];
+		if(n>=target && n!=0)
+			return qMin((static_cast<qint64>(1)<<i) - 1, max);
+	}
+	return max;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::sSnapshot::sSnapshot()
+	: timeNS(0)
+{
+	memset(counters, 0, sizeof(counters));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::TickTimer::Tick(EnumHistogram histogram, int intervalMS)
+{
+	qint64 nowNS = Utils::GetTimeNS();
+	qint64 intervalNS = (static_cast<qint64>(intervalMS) * 1000000);
+
+	// owners Reset when they stop or restart the timer, so any gap left is a stall
+	if(m_LastNS!=0 && intervalNS>0)
+	{
+		qint64 lateNS = (nowNS - m_LastNS - intervalNS);
+		METRICS.Record(histogram, qMax(static_cast<qint64>(0),lateNS)/1000);
+	}
+
+	m_LastNS = nowNS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::InputScope::InputScope(int source)
+	: m_Active(false)
+{
+	// nested events keep the outermost input
+	if(source>=0 && sm_Source<0)
+	{
+		sm_TimeNS = Utils::GetTimeNS();
+		sm_Source = source;
+		m_Active = true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::InputScope::~InputScope()
+{
+	if( m_Active )
+	{
+		sm_TimeNS = 0;
+		sm_Source = -1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Metrics::InputScope::GetActive(qint64 &timeNS, int &source)
+{
+	if(sm_Source < 0)
+		return false;
+
+	timeNS = sm_TimeNS;
+	source = sm_Source;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::RecvScope::RecvScope(qint64 recvNS, int source)
+	: m_Active(false)
+{
+	if(recvNS!=0 && source>=0 && sm_Source<0)
+	{
+		sm_RecvNS = recvNS;
+		sm_Source = source;
+		m_Active = true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::RecvScope::~RecvScope()
+{
+	if( m_Active )
+	{
+		sm_RecvNS = 0;
+		sm_Source = -1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Metrics::RecvScope::GetActive(qint64 &recvNS, int &source)
+{
+	if(sm_Source < 0)
+		return false;
+
+	recvNS = sm_RecvNS;
+	source = sm_Source;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::PaintProbe::Invalidated()
+{
+	// repaints not caused by a receive (hover, animation, edits) leave the probe alone
+	qint64 recvNS = 0;
+	int source = -1;
+	if( !RecvScope::GetActive(recvNS,source) )
+		return;
+
+	if(m_RecvNS==0 || recvNS-m_RecvNS>PAINT_PROBE_STALE_NS)
+	{
+		m_RecvNS = recvNS;
+		m_Source = source;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::PaintProbe::Painted()
+{
+	if(m_RecvNS != 0)
+	{
+		METRICS.RecordLatency(LATENCY_RECV_TO_PAINT_US, m_Source, (Utils::GetTimeNS()-m_RecvNS)/1000);
+		m_RecvNS = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Metrics::Metrics()
+	: m_LatencyProbes(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Record(EnumHistogram histogram, qint64 value)
+{
+	RecordValue(m_Histograms[histogram], value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::RecordLatency(EnumLatency latency, int source, qint64 value)
+{
+	if(source>=0 && source<LATENCY_SOURCE_COUNT)
+		RecordValue(m_Latencies[latency][source], value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::RecordValue(sAtomicHistogram &h, qint64 value)
+{
+	if(value < 0)
+		value = 0;
+
+	h.count.fetchAndAddRelaxed(1);
+	h.sum.fetchAndAddRelaxed(value);
+	h.buckets[sHistogram::GetBucket(value)].fetchAndAddRelaxed(1);
+
+	qint64 max = h.max.load();
+	while(value>max && !h.max.testAndSetRelaxed(max,value))
+		max = h.max.load();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::TakeSnapshot(sSnapshot &snapshot)
+{
+	snapshot.timeNS = Utils::GetTimeNS();
+
+	for(int i=0; i<COUNTER_COUNT; i++)
+		snapshot.counters[i] = m_Counters[i].load();
+
+	for(int i=0; i<HISTOGRAM_COUNT; i++)
+		Take(m_Histograms[i], snapshot.histograms[i]);
+
+	for(int i=0; i<LATENCY_COUNT; i++)
+	{
+		for(int j=0; j<LATENCY_SOURCE_COUNT; j++)
+			Take(m_Latencies[i][j], snapshot.latencies[i][j]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Take(sAtomicHistogram &src, sHistogram &dst)
+{
+	dst.count = src.count.load();
+	dst.sum = src.sum.load();
+	dst.max = src.max.fetchAndStoreRelaxed(0);
+	for(int i=0; i<BUCKET_COUNT; i++)
+		dst.buckets[i] = src.buckets[i].load();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::GetInterval(const sSnapshot &current, const sSnapshot &previous, sSnapshot &interval)
+{
+	interval.timeNS = (current.timeNS - previous.timeNS);
+
+	for(int i=0; i<COUNTER_COUNT; i++)
+		interval.counters[i] = (current.counters[i] - previous.counters[i]);
+
+	for(int i=0; i<HISTOGRAM_COUNT; i++)
+		Subtract(current.histograms[i], previous.histograms[i], interval.histograms[i]);
+
+	for(int i=0; i<LATENCY_COUNT; i++)
+	{
+		for(int j=0; j<LATENCY_SOURCE_COUNT; j++)
+			Subtract(current.latencies[i][j], previous.latencies[i][j], interval.latencies[i][j]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Subtract(const sHistogram &cur, const sHistogram &prev, sHistogram &dst)
+{
+	dst.count = (cur.count - prev.count);
+	dst.sum = (cur.sum - prev.sum);
+	dst.max = cur.max;
+	for(int i=0; i<BUCKET_COUNT; i++)
+		dst.buckets[i] = (cur.buckets[i] - prev.buckets[i]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* Metrics::GetCounterName(EnumCounter counter)
+{
+	switch( counter )
+	{
+		case COUNTER_UDP_IN_PACKETS:	return "udp_in_packets";
+		case COUNTER_UDP_IN_BYTES:		return "udp_in_bytes";
+		case COUNTER_UDP_OUT_PACKETS:	return "udp_out_packets";
+		case COUNTER_UDP_OUT_BYTES:		return "udp_out_bytes";
+		case COUNTER_TCP_IN_PACKETS:	return "tcp_in_packets";
+		case COUNTER_TCP_IN_BYTES:		return "tcp_in_bytes";
+		case COUNTER_TCP_OUT_PACKETS:	return "tcp_out_packets";
+		case COUNTER_TCP_OUT_BYTES:		return "tcp_out_bytes";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* Metrics::GetHistogramName(EnumHistogram histogram)
+{
+	switch( histogram )
+	{
+		case HISTOGRAM_RECV_QUEUE_DEPTH:	return "recv_queue_depth";
+		case HISTOGRAM_SEND_QUEUE_DEPTH:	return "send_queue_depth";
+		case HISTOGRAM_DISPATCH_US:			return "dispatch_us";
+		case HISTOGRAM_WILDCARD_US:			return "wildcard_us";
+		case HISTOGRAM_PAINT_US:			return "paint_us";
+		case HISTOGRAM_GENERATOR_JITTER_US:	return "generator_jitter_us";
+		case HISTOGRAM_EVENT_LOOP_LAG_US:	return "event_loop_lag_us";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* Metrics::GetLatencyName(EnumLatency latency)
+{
+	switch( latency )
+	{
+		case LATENCY_INPUT_TO_WIRE_US:	return "input_to_wire_us";
+		case LATENCY_RECV_TO_PAINT_US:	return "recv_to_paint_us";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+const char* Metrics::GetLatencySourceName(int source)
+{
+	// untranslated, these name export columns
+	switch( source )
+	{
+		case Toy::TOY_BUTTON_GRID:		return "button";
+		case Toy::TOY_PEDAL_GRID:		return "pedal";
+		case Toy::TOY_SLIDER_GRID:		return "fader";
+		case Toy::TOY_ENCODER_GRID:		return "encoder";
+		case Toy::TOY_XY_GRID:			return "xy";
+		case Toy::TOY_METRO_GRID:		return "metro";
+		case Toy::TOY_CMD_GRID:			return "cmd";
+		case Toy::TOY_SINE_GRID:		return "sine";
+		case Toy::TOY_FLICKER_GRID:		return "flicker";
+		case Toy::TOY_ACTIVITY_GRID:	return "activity";
+		case Toy::TOY_LABEL_GRID:		return "label";
+		case Toy::TOY_WINDOW:			return "window";
+	}
+
+	return "";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::GetCSVHeader(QByteArray &line)
+{
+	line = "time";
+
+	for(int i=0; i<COUNTER_COUNT; i++)
+		line += QByteArray(",") + GetCounterName( static_cast<EnumCounter>(i) ) + "_per_sec";
+
+	for(int i=0; i<HISTOGRAM_COUNT; i++)
+		AddCSVHeader(GetHistogramName(static_cast<EnumHistogram>(i)), line);
+
+	for(int i=0; i<LATENCY_COUNT; i++)
+	{
+		for(int j=0; j<Toy::TOY_COUNT; j++)
+			AddCSVHeader(GetLatencyName(static_cast<EnumLatency>(i)) + QByteArray("_") + GetLatencySourceName(j), line);
+	}
+
+	line += "\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::AddCSVHeader(const QByteArray &name, QByteArray &line)
+{
+	line += "," + name + "_count," + name + "_mean," + name + "_p50," + name + "_p99," + name + "_max";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::GetCSVLine(const sSnapshot &interval, qint64 wallMS, QByteArray &line)
+{
+	double seconds = qMax(interval.timeNS*0.000000001, 0.001);
+
+	line = QDateTime::fromMSecsSinceEpoch(wallMS).toString(Qt::ISODate).toUtf8();
+
+	for(int i=0; i<COUNTER_COUNT; i++)
+		line += "," + QByteArray::number(interval.counters[i]/seconds, 'f', 1);
+
+	for(int i=0; i<HISTOGRAM_COUNT; i++)
+		AddCSVValues(interval.histograms[i], line);
+
+	for(int i=0; i<LATENCY_COUNT; i++)
+	{
+		for(int j=0; j<Toy::TOY_COUNT; j++)
+			AddCSVValues(interval.latencies[i][j], line);
+	}
+
+	line += "\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::AddCSVValues(const sHistogram &h, QByteArray &line)
+{
+	line += "," + QByteArray::number(h.count);
+	line += "," + QByteArray::number(h.GetMean(), 'f', 1);
+	line += "," + QByteArray::number(h.GetPercentile(0.5));
+	line += "," + QByteArray::number(h.GetPercentile(0.99));
+	line += "," + QByteArray::number(h.max);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::GetJSONLine(const sSnapshot &interval, qint64 wallMS, QByteArray &line)
+{
+	// one object per line, so a periodic export stays valid json lines while being written
+	double seconds = qMax(interval.timeNS*0.000000001, 0.001);
+
+	line = "{\"time\":\"" + QDateTime::fromMSecsSinceEpoch(wallMS).toString(Qt::ISODate).toUtf8() + "\"";
+	line += ",\"interval_sec\":" + QByteArray::number(seconds, 'f', 3);
+
+	line += ",\"per_sec\":{";
+	for(int i=0; i<COUNTER_COUNT; i++)
+	{
+		if(i != 0)
+			line += ",";
+		line += QByteArray("\"") + GetCounterName( static_cast<EnumCounter>(i) ) + "\":" + QByteArray::number(interval.counters[i]/seconds, 'f', 1);
+	}
+	line += "}";
+
+	for(int i=0; i<HISTOGRAM_COUNT; i++)
+	{
+		line += QByteArray(",\"") + GetHistogramName( static_cast<EnumHistogram>(i) ) + "\":";
+		AddJSONValues(interval.histograms[i], line);
+	}
+
+	// latencies only for the toy types that produced samples
+	for(int i=0; i<LATENCY_COUNT; i++)
+	{
+		line += QByteArray(",\"") + GetLatencyName( static_cast<EnumLatency>(i) ) + "\":{";
+		bool first = true;
+		for(int j=0; j<Toy::TOY_COUNT; j++)
+		{
+			const sHistogram &h = interval.latencies[i][j];
+			if(h.count != 0)
+			{
+				line += QByteArray(first ? "\"" : ",\"") + GetLatencySourceName(j) + "\":";
+				AddJSONValues(h, line);
+				first = false;
+			}
+		}
+		line += "}";
+	}
+
+	line += "}\n";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::AddJSONValues(const sHistogram &h, QByteArray &line)
+{
+	line += "{\"count\":" + QByteArray::number(h.count);
+	line += ",\"mean\":" + QByteArray::number(h.GetMean(), 'f', 1);
+	line += ",\"p50\":" + QByteArray::number(h.GetPercentile(0.5));
+	line += ",\"p99\":" + QByteArray::number(h.GetPercentile(0.99));
+	line += ",\"max\":" + QByteArray::number(h.max);
+	line += "}";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Instantiate()
+{
+	if( !sm_Instance )
+		sm_Instance = new Metrics();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Metrics::Shutdown()
+{
+	if( sm_Instance )
+	{
+		delete sm_Instance;
+		sm_Instance = 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
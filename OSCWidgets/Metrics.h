@@ -0,0 +1,218 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// process wide counters and log2 bucketed histograms, safe to update from any
+// thread without locking; the gui takes a snapshot once a second for display
+// and export, and rates and histograms are shown for the interval between them
+class Metrics
+{
+public:
+	// each _PACKETS counter is followed by its _BYTES counter, see AddPacket
+	enum EnumCounter
+	{
+		COUNTER_UDP_IN_PACKETS,
+		COUNTER_UDP_IN_BYTES,
+		COUNTER_UDP_OUT_PACKETS,
+		COUNTER_UDP_OUT_BYTES,
+		COUNTER_TCP_IN_PACKETS,
+		COUNTER_TCP_IN_BYTES,
+		COUNTER_TCP_OUT_PACKETS,
+		COUNTER_TCP_OUT_BYTES,
+
+		COUNTER_COUNT
+	};
+
+	enum EnumHistogram
+	{
+		HISTOGRAM_RECV_QUEUE_DEPTH,
+		HISTOGRAM_SEND_QUEUE_DEPTH,
+		HISTOGRAM_DISPATCH_US,
+		HISTOGRAM_WILDCARD_US,
+		HISTOGRAM_PAINT_US,
+		HISTOGRAM_GENERATOR_JITTER_US,
+		HISTOGRAM_EVENT_LOOP_LAG_US,
+
+		HISTOGRAM_COUNT
+	};
+
+	// optional end to end probes, kept per source toy type
+	enum EnumLatency
+	{
+		LATENCY_INPUT_TO_WIRE_US,	// user input on a toy until its packet is sent
+		LATENCY_RECV_TO_PAINT_US,	// socket receive until the widget it changed is painted
+
+		LATENCY_COUNT
+	};
+
+	enum EnumConstants
+	{
+		BUCKET_COUNT			= 32,	// bucket n holds values up to 2^n-1
+		LATENCY_SOURCE_COUNT	= 16	// indexed by Toy::EnumToyType
+	};
+
+	struct sHistogram
+	{
+		sHistogram();
+		quint64	count;
+		qint64	sum;
+		qint64	max;	// over the interval only
+		quint64	buckets[BUCKET_COUNT];
+
+		void Add(qint64 value);
+		double GetMean() const;
+		qint64 GetPercentile(double p) const;
+
+		static int GetBucket(qint64 value);
+	};
+
+	struct sSnapshot
+	{
+		sSnapshot();
+		qint64		timeNS;
+		quint64		counters[COUNTER_COUNT];
+		sHistogram	histograms[HISTOGRAM_COUNT];
+		sHistogram	latencies[LATENCY_COUNT][LATENCY_SOURCE_COUNT];
+	};
+
+	// records how late a periodic timer fired relative to its interval
+	class TickTimer
+	{
+	public:
+		TickTimer() : m_LastNS(0) {}
+		void Tick(EnumHistogram histogram, int intervalMS);
+		void Reset() {m_LastNS = 0;}
+
+	private:
+		qint64	m_LastNS;
+	};
+
+	// packets sent while a scope is open carry the time its input arrived, gui thread only;
+	// a negative source opens nothing
+	class InputScope
+	{
+	public:
+		InputScope(int source);
+		~InputScope();
+
+		static bool GetActive(qint64 &timeNS, int &source);
+
+	private:
+		bool	m_Active;
+
+		static qint64	sm_TimeNS;
+		static int		sm_Source;
+	};
+
+	// receives dispatched while a scope is open are probed through to paint, gui thread only;
+	// a zero receive time or negative source opens nothing
+	class RecvScope
+	{
+	public:
+		RecvScope(qint64 recvNS, int source);
+		~RecvScope();
+
+		static bool GetActive(qint64 &recvNS, int &source);
+
+	private:
+		bool	m_Active;
+
+		static qint64	sm_RecvNS;
+		static int		sm_Source;
+	};
+
+	// holds the oldest unpainted receive time of a widget until it paints, gui thread only;
+	// only a receive that invalidates the widget is stamped
+	class PaintProbe
+	{
+	public:
+		PaintProbe() : m_RecvNS(0), m_Source(0) {}
+		void Invalidated();
+		void Painted();
+
+	private:
+		qint64	m_RecvNS;
+		int		m_Source;
+	};
+
+	Metrics();
+	virtual ~Metrics() {}
+
+	void Add(EnumCounter counter, quint64 n) {m_Counters[counter].fetchAndAddRelaxed(n);}
+	void AddPacket(EnumCounter packets, size_t bytes) {Add(packets,1); Add(static_cast<EnumCounter>(packets+1),bytes);}
+	virtual void Record(EnumHistogram histogram, qint64 value);
+	virtual void RecordLatency(EnumLatency latency, int source, qint64 value);
+	virtual bool GetLatencyProbes() const {return (m_LatencyProbes.load() != 0);}
+	virtual void SetLatencyProbes(bool b) {m_LatencyProbes.store(b ? 1 : 0);}
+	virtual void TakeSnapshot(sSnapshot &snapshot);
+
+	static void GetInterval(const sSnapshot &current, const sSnapshot &previous, sSnapshot &interval);
+	static const char* GetCounterName(EnumCounter counter);
+	static const char* GetHistogramName(EnumHistogram histogram);
+	static const char* GetLatencyName(EnumLatency latency);
+	static const char* GetLatencySourceName(int source);
+	static void GetCSVHeader(QByteArray &line);
+	static void GetCSVLine(const sSnapshot &interval, qint64 wallMS, QByteArray &line);
+	static void GetJSONLine(const sSnapshot &interval, qint64 wallMS, QByteArray &line);
+
+	static void Instantiate();
+	static void Shutdown();
+	static Metrics& Instance() {return *sm_Instance;}
+
+protected:
+	struct sAtomicHistogram
+	{
+		QAtomicInteger<quint64>	count;
+		QAtomicInteger<qint64>	sum;
+		QAtomicInteger<qint64>	max;
+		QAtomicInteger<quint64>	buckets[BUCKET_COUNT];
+	};
+
+	QAtomicInteger<quint64>	m_Counters[COUNTER_COUNT];
+	sAtomicHistogram		m_Histograms[HISTOGRAM_COUNT];
+	sAtomicHistogram		m_Latencies[LATENCY_COUNT][LATENCY_SOURCE_COUNT];
+	QAtomicInt				m_LatencyProbes;
+
+	static Metrics	*sm_Instance;
+
+	static void RecordValue(sAtomicHistogram &h, qint64 value);
+	static void Take(sAtomicHistogram &src, sHistogram &dst);
+	static void Subtract(const sHistogram &cur, const sHistogram &prev, sHistogram &dst);
+	static void AddCSVHeader(const QByteArray &name, QByteArray &line);
+	static void AddCSVValues(const sHistogram &h, QByteArray &line);
+	static void AddJSONValues(const sHistogram &h, QByteArray &line);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define METRICS	Metrics::Instance()
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
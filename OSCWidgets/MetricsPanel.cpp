@@ -0,0 +1,119 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "MetricsPanel.h"
+#include "Toy.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+MetricsPanel::MetricsPanel(QWidget *parent)
+	: QWidget(parent)
+{
+	QGridLayout *layout = new QGridLayout(this);
+	layout->setContentsMargins(0, 0, 0, 0);
+
+	m_Tree = new QTreeWidget(this);
+	m_Tree->setColumnCount(COL_COUNT);
+	m_Tree->setRootIsDecorated(false);
+	m_Tree->setUniformRowHeights(true);
+	m_Tree->setSelectionMode(QAbstractItemView::NoSelection);
+	m_Tree->setHeaderLabels(QStringList() << tr("Metric") << tr("Count/sec") << tr("Mean") << tr("p50") << tr("p99") << tr("Max"));
+	layout->addWidget(m_Tree, 0, 0);
+
+	for(int i=0; i<Metrics::COUNTER_COUNT; i++)
+	{
+		QTreeWidgetItem *item = new QTreeWidgetItem(m_Tree);
+		item->setText(COL_NAME, Metrics::GetCounterName(static_cast<Metrics::EnumCounter>(i)));
+		m_CounterItems.push_back(item);
+	}
+
+	for(int i=0; i<Metrics::HISTOGRAM_COUNT; i++)
+	{
+		QTreeWidgetItem *item = new QTreeWidgetItem(m_Tree);
+		item->setText(COL_NAME, Metrics::GetHistogramName(static_cast<Metrics::EnumHistogram>(i)));
+		m_HistogramItems.push_back(item);
+	}
+
+	// per toy type, each row appears once it has samples
+	for(int i=0; i<Metrics::LATENCY_COUNT; i++)
+	{
+		QTreeWidgetItem *parentItem = new QTreeWidgetItem(m_Tree);
+		parentItem->setText(COL_NAME, Metrics::GetLatencyName(static_cast<Metrics::EnumLatency>(i)));
+		parentItem->setExpanded(true);
+
+		for(int j=0; j<Metrics::LATENCY_SOURCE_COUNT; j++)
+		{
+			QTreeWidgetItem *item = 0;
+			if(j < Toy::TOY_COUNT)
+			{
+				QString name;
+				Toy::GetName(static_cast<Toy::EnumToyType>(j), name);
+				item = new QTreeWidgetItem(parentItem);
+				item->setText(COL_NAME, name);
+				item->setHidden(true);
+			}
+			m_LatencyItems.push_back(item);
+		}
+	}
+
+	for(int i=COL_RATE; i<COL_COUNT; i++)
+		m_Tree->header()->setSectionResizeMode(i, QHeaderView::ResizeToContents);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MetricsPanel::Update(const Metrics::sSnapshot &interval)
+{
+	double seconds = qMax(interval.timeNS*0.000000001, 0.001);
+
+	for(int i=0; i<Metrics::COUNTER_COUNT; i++)
+		m_CounterItems[i]->setText(COL_RATE, QString::number(interval.counters[i]/seconds, 'f', 0));
+
+	// histograms show samples per second, then their distribution over the interval
+	for(int i=0; i<Metrics::HISTOGRAM_COUNT; i++)
+		UpdateItem(m_HistogramItems[i], interval.histograms[i], seconds);
+
+	for(int i=0; i<Metrics::LATENCY_COUNT; i++)
+	{
+		for(int j=0; j<Metrics::LATENCY_SOURCE_COUNT; j++)
+		{
+			QTreeWidgetItem *item = m_LatencyItems[i*Metrics::LATENCY_SOURCE_COUNT + j];
+			const Metrics::sHistogram &h = interval.latencies[i][j];
+			if(item && (h.count!=0 || !item->isHidden()))
+			{
+				item->setHidden(false);
+				UpdateItem(item, h, seconds);
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MetricsPanel::UpdateItem(QTreeWidgetItem *item, const Metrics::sHistogram &h, double seconds)
+{
+	item->setText(COL_RATE, QString::number(h.count/seconds, 'f', 0));
+	item->setText(COL_MEAN, QString::number(h.GetMean(), 'f', 1));
+	item->setText(COL_P50, QString::number(h.GetPercentile(0.5)));
+	item->setText(COL_P99, QString::number(h.GetPercentile(0.99)));
+	item->setText(COL_MAX, QString::number(h.max));
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,68 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef METRICS_PANEL_H
+#define METRICS_PANEL_H
+
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// table of per second counter rates and histogram summaries, shown beside the log
+class MetricsPanel
+	: public QWidget
+{
+public:
+	MetricsPanel(QWidget *parent);
+
+	virtual void Update(const Metrics::sSnapshot &interval);
+	virtual QSize sizeHint() const {return QSize(400,150);}
+
+protected:
+	enum EnumColumns
+	{
+		COL_NAME,
+		COL_RATE,
+		COL_MEAN,
+		COL_P50,
+		COL_P99,
+		COL_MAX,
+
+		COL_COUNT
+	};
+
+	typedef std::vector<QTreeWidgetItem*> ITEMS;
+
+	QTreeWidget	*m_Tree;
+	ITEMS		m_CounterItems;
+	ITEMS		m_HistogramItems;
+	ITEMS		m_LatencyItems;	// LATENCY_SOURCE_COUNT per latency, 0 for unused sources
+
+	virtual void UpdateItem(QTreeWidgetItem *item, const Metrics::sHistogram &h, double seconds);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
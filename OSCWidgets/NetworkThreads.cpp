@@ -22,6 +22,9 @@
 #include "EosUdp.h"
 #include "EosTcp.h"
 #include "EosTimer.h"
+#include "Utils.h"
+#include "Metrics.h"
+#include "Trace.h"
 
 #ifdef WIN32
 	#include <WinSock2.h>
@@ -31,6 +34,130 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static void RecordInputToWire(const sPacket &packet)
+{
+	if(packet.timeNS != 0)
+		METRICS.RecordLatency(Metrics::LATENCY_INPUT_TO_WIRE_US, packet.source, (Utils::GetTimeNS()-packet.timeNS)/1000);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool TimedPacketQ::GetNextDue(qint64 &dueNS) const
+{
+	if( m_Q.empty() )
+		return false;
+
+	dueNS = m_Q.begin()->first;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimedPacketQ::Add(const sPacket &packet, qint64 dueNS, const void *owner)
+{
+	sTimedPacket timedPacket;
+	timedPacket.packet = packet;
+	timedPacket.dueNS = dueNS;
+	timedPacket.owner = owner;
+	m_Q.insert( Q::value_type(dueNS,timedPacket) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimedPacketQ::Cancel(const void *owner)
+{
+	for(Q::iterator i=m_Q.begin(); i!=m_Q.end(); )
+	{
+		if(i->second.owner == owner)
+		{
+			delete[] i->second.packet.data;
+			m_Q.erase(i++);
+		}
+		else
+			i++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimedPacketQ::Clear()
+{
+	for(Q::const_iterator i=m_Q.begin(); i!=m_Q.end(); i++)
+		delete[] i->second.packet.data;
+	m_Q.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimedPacketQ::TakeDue(qint64 untilNS, TIMED_PACKETS &packets)
+{
+	while(!m_Q.empty() && m_Q.begin()->first<=untilNS)
+	{
+		packets.push_back(m_Q.begin()->second);
+		m_Q.erase( m_Q.begin() );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void TimedPacketQ::WaitUntil(qint64 dueNS)
+{
+	// only ever called within HOLD_WINDOW_NS of the due time, so yield rather than sleep
+	while(Utils::GetTimeNS() < dueNS)
+		QThread::yieldCurrentThread();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int TimedPacketQ::GetWaitMS(qint64 dueNS, unsigned int maxMS)
+{
+	// 0 once the packet can be taken
+	qint64 holdNS = (dueNS - HOLD_WINDOW_NS - Utils::GetTimeNS());
+	if(holdNS <= 0)
+		return 0;
+
+	// one long wait that stops short by the timer slack, then short waits up to the hold window
+	qint64 waitMS = ((holdNS - TIMER_SLACK_NS) / 1000000);
+	if(waitMS < SLACK_WAIT_MS)
+		waitMS = SLACK_WAIT_MS;
+
+	return ((waitMS < maxMS) ? static_cast<unsigned int>(waitMS) : maxMS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+NetworkNotifier::NetworkNotifier()
+	: m_Target(0)
+	, m_Method(0)
+	, m_Pending(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkNotifier::SetTarget(QObject *target, const char *method)
+{
+	m_Target = target;
+	m_Method = method;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkNotifier::Notify()
+{
+	if(m_Target && m_Method && m_Pending.testAndSetOrdered(0,1))
+		QMetaObject::invokeMethod(m_Target, m_Method, Qt::QueuedConnection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void NetworkNotifier::Reset()
+{
+	m_Pending.fetchAndStoreOrdered(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 OSCHandler::OSCHandler(Client &client)
 	: m_pClient(&client)
 {
@@ -50,6 +177,8 @@ EosUdpOutThread::EosUdpOutThread()
 	: m_Port(0)
 	, m_Run(false)
 	, m_Mutex(QMutex::Recursive)
+	, m_WakePending(false)
+	, m_Capture(0)
 {
 }
 
@@ -78,11 +207,14 @@ void EosUdpOutThread::Start(const QString &ip, unsigned short port)
 void EosUdpOutThread::Stop()
 {
 	m_Run = false;
+	Wake();
 	wait();
 	
 	for(PACKET_Q::const_iterator i=m_Q.begin(); i!=m_Q.end(); i++)
 		delete[] i->data;
 	m_Q.clear();
+
+	m_TimedQ.Clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -94,6 +226,7 @@ bool EosUdpOutThread::Send(sPacket &packet)
 		m_Mutex.lock();
 		m_Q.push_back(packet);
 		m_Mutex.unlock();
+		Wake();
 		return true;
 	}
 	return false;
@@ -101,9 +234,36 @@ bool EosUdpOutThread::Send(sPacket &packet)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool EosUdpOutThread::SendAt(sPacket &packet, qint64 dueNS, const void *owner)
+{
+	if(packet.data && packet.size!=0)
+	{
+		m_Mutex.lock();
+		m_TimedQ.Add(packet, dueNS, owner);
+		m_Mutex.unlock();
+		Wake();
+		return true;
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosUdpOutThread::CancelSends(const void *owner)
+{
+	m_Mutex.lock();
+	m_TimedQ.Cancel(owner);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EosUdpOutThread::Flush(EosLog::LOG_Q &logQ, NETEVENT_Q &netEventQ)
 {
+	TRACE_ZONE("EosUdpOutThread::Flush");
+
 	m_Mutex.lock();
+	m_Notifier.Reset();
 	m_Log.Flush(logQ);
 	m_NetEventQ.swap(netEventQ);
 	m_Mutex.unlock();
@@ -113,6 +273,8 @@ void EosUdpOutThread::Flush(EosLog::LOG_Q &logQ, NETEVENT_Q &netEventQ)
 
 void EosUdpOutThread::run()
 {
+	TRACE_THREAD_NAME("udp output");
+
 	QString msg = QString("udp output %1:%2 thread started").arg(m_Ip).arg(m_Port);
 	m_PrivateLog.AddInfo( msg.toUtf8().constData() );
 	UpdateLog();
@@ -121,6 +283,7 @@ void EosUdpOutThread::run()
 	EosTimer reconnectTimer;
 	
 	m_Prefix = QString("OUT [%1:%2] ").arg(m_Ip).arg(m_Port).toUtf8().constData();
+	PacketCapture::sPeer capturePeer = PacketCapture::MakePeer(PacketCapture::TRANSPORT_UDP, QHostAddress(m_Ip), m_Port);
 	
 	// outer loop for auto-reconnect
 	while( m_Run )
@@ -131,34 +294,62 @@ void EosUdpOutThread::run()
 			m_Mutex.lock();
 			m_NetEventQ.push_back(NET_EVENT_CONNECTED);
 			m_Mutex.unlock();
+			m_Notifier.Notify();
 		
 			OSCParser logParser;
 			logParser.SetRoot(new OSCMethod());
 
 			// run
 			PACKET_Q q;
+			TimedPacketQ::TIMED_PACKETS timedQ;
 			while( m_Run )
 			{
 				m_Mutex.lock();
 				m_Q.swap(q);
+				m_TimedQ.TakeDue(Utils::GetTimeNS()+TimedPacketQ::HOLD_WINDOW_NS, timedQ);
 				m_Mutex.unlock();
+
+				if( !q.empty() )
+					METRICS.Record(Metrics::HISTOGRAM_SEND_QUEUE_DEPTH, static_cast<qint64>(q.size()));
 				
 				for(PACKET_Q::const_iterator i=q.begin(); i!=q.end(); i++)
 				{
 					if( udpOut->SendPacket(m_PrivateLog,i->data,static_cast<int>(i->size)) )
+					{
+						if( m_Capture )
+							m_Capture->Add(PacketCapture::DIRECTION_OUT, capturePeer, i->data, i->size);
+						METRICS.AddPacket(Metrics::COUNTER_UDP_OUT_PACKETS, i->size);
+						RecordInputToWire(*i);
 						logParser.PrintPacket(*this, i->data, i->size);
+					}
 					delete[] i->data;
 				}
 				q.clear();
+
+				// timed packets go out on their due time, not on the next poll
+				for(TimedPacketQ::TIMED_PACKETS::const_iterator i=timedQ.begin(); i!=timedQ.end(); i++)
+				{
+					TimedPacketQ::WaitUntil(i->dueNS);
+					if( udpOut->SendPacket(m_PrivateLog,i->packet.data,static_cast<int>(i->packet.size)) )
+					{
+						if( m_Capture )
+							m_Capture->Add(PacketCapture::DIRECTION_OUT, capturePeer, i->packet.data, i->packet.size);
+						METRICS.AddPacket(Metrics::COUNTER_UDP_OUT_PACKETS, i->packet.size);
+						logParser.PrintPacket(*this, i->packet.data, i->packet.size);
+					}
+					delete[] i->packet.data;
+				}
+				timedQ.clear();
 				
 				UpdateLog();
 
-				msleep(1);
+				WaitForWork();
 			}
 			
 			m_Mutex.lock();
 			m_NetEventQ.push_back(NET_EVENT_DISCONNECTED);
 			m_Mutex.unlock();
+			m_Notifier.Notify();
 		}
 		
 		delete udpOut;
@@ -182,6 +373,35 @@ void EosUdpOutThread::run()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void EosUdpOutThread::Wake()
+{
+	m_WakeMutex.lock();
+	m_WakePending = true;
+	m_Wake.wakeAll();
+	m_WakeMutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosUdpOutThread::WaitForWork()
+{
+	// block until more packets are queued or the next timed packet is nearly due
+	unsigned int waitMS = TimedPacketQ::IDLE_WAIT_MS;
+	qint64 dueNS = 0;
+	m_Mutex.lock();
+	if( m_TimedQ.GetNextDue(dueNS) )
+		waitMS = TimedPacketQ::GetWaitMS(dueNS, waitMS);
+	m_Mutex.unlock();
+
+	m_WakeMutex.lock();
+	if(!m_WakePending && waitMS!=0)
+		m_Wake.wait(&m_WakeMutex, waitMS);
+	m_WakePending = false;
+	m_WakeMutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EosUdpOutThread::OSCParserClient_Log(const std::string &message)
 {
 	m_LogMsg = (m_Prefix + message);
@@ -205,6 +425,8 @@ EosUdpInThread::EosUdpInThread()
 	: m_Port(0)
 	, m_Run(false)
 	, m_Mutex(QMutex::Recursive)
+	, m_Capture(0)
+	, m_RecvNS(0)
 {
 }
 
@@ -243,9 +465,12 @@ void EosUdpInThread::Stop()
 
 void EosUdpInThread::Flush(EosLog::LOG_Q &logQ, PACKET_Q &recvQ)
 {
+	TRACE_ZONE("EosUdpInThread::Flush");
+
 	recvQ.clear();
 	
 	m_Mutex.lock();
+	m_Notifier.Reset();
 	m_Log.Flush(logQ);
 	m_Q.swap(recvQ);
 	m_Mutex.unlock();
@@ -255,6 +480,8 @@ void EosUdpInThread::Flush(EosLog::LOG_Q &logQ, PACKET_Q &recvQ)
 
 void EosUdpInThread::run()
 {
+	TRACE_THREAD_NAME("udp input");
+
 	QString msg = QString("udp input %1:%2 thread started").arg(m_Ip).arg(m_Port);
 	m_PrivateLog.AddInfo( msg.toUtf8().constData() );
 	UpdateLog();
@@ -284,7 +511,11 @@ void EosUdpInThread::run()
 				const char *data = udpIn->RecvPacket(m_PrivateLog, 100, 0, len, &addr, &addrSize);
 				if(data && len>0)
 				{
+					m_RecvNS = Utils::GetTimeNS();
 					QHostAddress host( reinterpret_cast<const sockaddr*>(&addr) );
+					if( m_Capture )
+						m_Capture->Add(PacketCapture::DIRECTION_IN, PacketCapture::MakePeer(PacketCapture::TRANSPORT_UDP,host,ntohs(addr.sin_port)), data, static_cast<size_t>(len));
+					METRICS.AddPacket(Metrics::COUNTER_UDP_IN_PACKETS, static_cast<size_t>(len));
 					m_Prefix = QString("IN  [%1:%2] ").arg( host.toString() ).arg(m_Port).toUtf8().constData();
 					parser.PrintPacket(*this, data, static_cast<size_t>(len));
 
@@ -360,11 +591,13 @@ void EosUdpInThread::OSCHandlerClient_Recv(OSCParserClient& /*client*/, char *bu
 		sPacket packet;
 		packet.size = size;
 		packet.data = new char[packet.size];
+		packet.timeNS = m_RecvNS;
 		memcpy(packet.data, buf, packet.size);
 
 		m_Mutex.lock();
 		m_Q.push_back(packet);
 		m_Mutex.unlock();
+		m_Notifier.Notify();
 	}
 }
 
@@ -375,6 +608,10 @@ EosTcpClientThread::EosTcpClientThread()
 	, m_LogMsgType(EosLog::LOG_MSG_TYPE_INFO)
 	, m_Run(false)
 	, m_Mutex(QMutex::Recursive)
+	, m_Capture(0)
+	, m_RecvNS(0)
+	, m_TimedLeadNS(0)
+	, m_TimedLastNS(0)
 {
 }
 
@@ -409,6 +646,9 @@ void EosTcpClientThread::Stop()
 	for(PACKET_Q::const_iterator i=m_SendQ.begin(); i!=m_SendQ.end(); i++)
 		delete[] i->data;
 	m_SendQ.clear();
+
+	m_TimedQ.Clear();
+	m_TimedLastNS = 0;
 	
 	for(PACKET_Q::const_iterator i=m_RecvQ.begin(); i!=m_RecvQ.end(); i++)
 		delete[] i->data;
@@ -431,11 +671,43 @@ bool EosTcpClientThread::Send(sPacket &packet)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool EosTcpClientThread::SendAt(sPacket &packet, qint64 dueNS, const void *owner)
+{
+	if(packet.data && packet.size!=0)
+	{
+		qint64 nowNS = Utils::GetTimeNS();
+		qint64 leadNS = (dueNS - nowNS);
+
+		m_Mutex.lock();
+		m_TimedQ.Add(packet, dueNS, owner);
+		if(m_TimedLastNS==0 || nowNS-m_TimedLastNS>static_cast<qint64>(TimedPacketQ::LEAD_EXPIRE_MS)*1000000 || leadNS<m_TimedLeadNS)
+			m_TimedLeadNS = leadNS;
+		m_TimedLastNS = nowNS;
+		m_Mutex.unlock();
+		return true;
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void EosTcpClientThread::CancelSends(const void *owner)
+{
+	m_Mutex.lock();
+	m_TimedQ.Cancel(owner);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void EosTcpClientThread::Flush(EosLog::LOG_Q &logQ, PACKET_Q &recvQ, NETEVENT_Q &netEventQ)
 {
+	TRACE_ZONE("EosTcpClientThread::Flush");
+
 	recvQ.clear();
 	
 	m_Mutex.lock();
+	m_Notifier.Reset();
 	m_Log.Flush(logQ);
 	m_RecvQ.swap(recvQ);
 	m_NetEventQ.swap(netEventQ);
@@ -446,6 +718,8 @@ void EosTcpClientThread::Flush(EosLog::LOG_Q &logQ, PACKET_Q &recvQ, NETEVENT_Q
 
 void EosTcpClientThread::run()
 {
+	TRACE_THREAD_NAME("tcp client");
+
 	QString msg = QString("tcp client %1:%2 thread started").arg(m_Ip).arg(m_Port);
 	m_PrivateLog.AddInfo( msg.toUtf8().constData() );
 	UpdateLog();
@@ -464,6 +738,7 @@ void EosTcpClientThread::run()
 			parser.SetRoot(new OSCHandler(*this));
 			std::string inPrefix = QString("TCPIN [%1:%2] ").arg(m_Ip).arg(m_Port).toUtf8().constData();
 			std::string outPrefix = QString("TCPOUT [%1:%2] ").arg(m_Ip).arg(m_Port).toUtf8().constData();
+			PacketCapture::sPeer capturePeer = PacketCapture::MakePeer(PacketCapture::TRANSPORT_TCP, QHostAddress(m_Ip), m_Port);
 			
 			sPacket packet;
 
@@ -483,13 +758,29 @@ void EosTcpClientThread::run()
 				m_Mutex.lock();
 				m_NetEventQ.push_back(NET_EVENT_CONNECTED);
 				m_Mutex.unlock();
+				m_Notifier.Notify();
 			
 				PACKET_Q sendQ;
+				TimedPacketQ::TIMED_PACKETS timedQ;
 				OSCStream oscStream(m_FrameMode);
 				do
 				{
+					// block in recv, but no longer than the next timed packet allows
+					unsigned int recvMS = TimedPacketQ::IDLE_WAIT_MS;
+					qint64 dueNS = 0;
+					qint64 nowNS = Utils::GetTimeNS();
+					m_Mutex.lock();
+					if( m_TimedQ.GetNextDue(dueNS) )
+						recvMS = TimedPacketQ::GetWaitMS(dueNS, recvMS);
+					// nor longer than the notice a packet queued during the recv is likely to get
+					if(m_TimedLastNS!=0 && nowNS-m_TimedLastNS<=static_cast<qint64>(TimedPacketQ::LEAD_EXPIRE_MS)*1000000)
+						recvMS = TimedPacketQ::GetWaitMS(nowNS+m_TimedLeadNS, recvMS);
+					m_Mutex.unlock();
+
 					size_t len = 0;
-					const char *data = tcp->Recv(m_PrivateLog, 100, len);
+					const char *data = tcp->Recv(m_PrivateLog, recvMS, len);
+					if(data && len!=0)
+						m_RecvNS = Utils::GetTimeNS();
 					
 					oscStream.Add(data, len);
 					
@@ -498,6 +789,9 @@ void EosTcpClientThread::run()
 						packet.data = oscStream.GetNextFrame(packet.size);
 						if(packet.data && packet.size!=0)
 						{
+							if( m_Capture )
+								m_Capture->Add(PacketCapture::DIRECTION_IN, capturePeer, packet.data, packet.size);
+							METRICS.AddPacket(Metrics::COUNTER_TCP_IN_PACKETS, packet.size);
 							m_Prefix = inPrefix;
 							m_LogMsgType = EosLog::LOG_MSG_TYPE_RECV;
 							parser.PrintPacket(*this, packet.data, packet.size);
@@ -508,12 +802,22 @@ void EosTcpClientThread::run()
 							break;
 					}
 
-					msleep(1);
-
 					m_Mutex.lock();
 					m_SendQ.swap(sendQ);
+					m_TimedQ.TakeDue(Utils::GetTimeNS()+TimedPacketQ::HOLD_WINDOW_NS, timedQ);
 					m_Mutex.unlock();
 
+					if( !sendQ.empty() )
+						METRICS.Record(Metrics::HISTOGRAM_SEND_QUEUE_DEPTH, static_cast<qint64>(sendQ.size()));
+
+					// timed packets join the send queue once due
+					for(TimedPacketQ::TIMED_PACKETS::const_iterator i=timedQ.begin(); i!=timedQ.end(); i++)
+					{
+						TimedPacketQ::WaitUntil(i->dueNS);
+						sendQ.push_back(i->packet);
+					}
+					timedQ.clear();
+
 					sPacket framedPacket;
 					for(PACKET_Q::iterator i=sendQ.begin(); m_Run && i!=sendQ.end(); i++)
 					{
@@ -523,6 +827,10 @@ void EosTcpClientThread::run()
 						{
 							if( tcp->Send(m_PrivateLog,framedPacket.data,framedPacket.size) )
 							{
+								if( m_Capture )
+									m_Capture->Add(PacketCapture::DIRECTION_OUT, capturePeer, i->data, i->size);
+								METRICS.AddPacket(Metrics::COUNTER_TCP_OUT_PACKETS, i->size);
+								RecordInputToWire(*i);
 								m_Prefix = outPrefix;
 								m_LogMsgType = EosLog::LOG_MSG_TYPE_SEND;
 								parser.PrintPacket(*this, i->data, i->size);
@@ -534,14 +842,13 @@ void EosTcpClientThread::run()
 					sendQ.clear();
 				
 					UpdateLog();
-
-					msleep(1);
 				}
 				while(m_Run && tcp->GetConnectState()==EosTcp::CONNECT_CONNECTED);
 				
 				m_Mutex.lock();
 				m_NetEventQ.push_back(NET_EVENT_DISCONNECTED);
 				m_Mutex.unlock();
+				m_Notifier.Notify();
 			}
 		}
 
@@ -592,11 +899,13 @@ void EosTcpClientThread::OSCHandlerClient_Recv(OSCParserClient& /*client*/, char
 		sPacket packet;
 		packet.size = size;
 		packet.data = new char[packet.size];
+		packet.timeNS = m_RecvNS;
 		memcpy(packet.data, buf, packet.size);
 
 		m_Mutex.lock();
 		m_RecvQ.push_back(packet);
 		m_Mutex.unlock();
+		m_Notifier.Notify();
 	}
 }
 
@@ -34,14 +34,28 @@
 #include "OSCParser.h"
 #endif
 
+#ifndef PACKET_CAPTURE_H
+#include "PacketCapture.h"
+#endif
+
 #include <vector>
+#include <map>
 
 ////////////////////////////////////////////////////////////////////////////////
 
 struct sPacket
 {
+	sPacket()
+		: data(0)
+		, size(0)
+		, timeNS(0)
+		, source(-1)
+	{}
+
 	char	*data;
 	size_t	size;
+	qint64	timeNS;	// latency probes: user input for sends, socket receive for recvs, 0 = none
+	int		source;	// latency probes: toy type of the input, see Metrics::InputScope
 };
 
 enum EnumNetworkEvent
@@ -55,6 +69,73 @@ typedef std::vector<EnumNetworkEvent> NETEVENT_Q;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// packets held until a due time, see Utils::GetTimeNS
+class TimedPacketQ
+{
+public:
+	enum EnumConstants
+	{
+		HOLD_WINDOW_NS	= 2000000,	// packets due this soon are taken and sent on time by the network thread
+#ifdef WIN32
+		TIMER_SLACK_NS	= 16000000,	// os sleeps can overrun this much, so wake early
+#else
+		TIMER_SLACK_NS	= 1000000,
+#endif
+		SLACK_WAIT_MS	= 1,		// waits inside the slack are this short, rather than spinning
+		IDLE_WAIT_MS	= 100,		// longest a network thread blocks with nothing due
+		LEAD_EXPIRE_MS	= 5000		// a thread that cannot be woken stops expecting timed packets after this
+	};
+
+	struct sTimedPacket
+	{
+		sPacket		packet;
+		qint64		dueNS;
+		const void	*owner;		// identifies the sender, for cancellation
+	};
+
+	typedef std::vector<sTimedPacket> TIMED_PACKETS;
+
+	TimedPacketQ() {}
+	virtual ~TimedPacketQ() {Clear();}
+
+	virtual bool IsEmpty() const {return m_Q.empty();}
+	virtual bool GetNextDue(qint64 &dueNS) const;
+	virtual void Add(const sPacket &packet, qint64 dueNS, const void *owner);
+	virtual void Cancel(const void *owner);
+	virtual void Clear();
+	virtual void TakeDue(qint64 untilNS, TIMED_PACKETS &packets);
+
+	static void WaitUntil(qint64 dueNS);
+	static unsigned int GetWaitMS(qint64 dueNS, unsigned int maxMS);
+
+protected:
+	typedef std::multimap<qint64,sTimedPacket> Q;
+
+	Q	m_Q;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// lets a network thread wake a gui thread object when it queues received
+// packets or network events, at most once between flushes
+class NetworkNotifier
+{
+public:
+	NetworkNotifier();
+	virtual ~NetworkNotifier() {}
+
+	virtual void SetTarget(QObject *target, const char *method);
+	virtual void Notify();
+	virtual void Reset();
+
+protected:
+	QObject		*m_Target;
+	const char	*m_Method;
+	QAtomicInt	m_Pending;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class OSCHandler
 	: public OSCMethod
 {
@@ -85,7 +166,11 @@ public:
 
 	virtual void Start(const QString &ip, unsigned short port);
 	virtual void Stop();
+	virtual void SetNotifyTarget(QObject *target, const char *method) {m_Notifier.SetTarget(target, method);}
+	virtual void SetCapture(PacketCapture *capture) {m_Capture = capture;}
 	virtual bool Send(sPacket &packet);
+	virtual bool SendAt(sPacket &packet, qint64 dueNS, const void *owner);
+	virtual void CancelSends(const void *owner);
 	virtual void Flush(EosLog::LOG_Q &logQ, NETEVENT_Q &netEventQ);
 
 protected:
@@ -95,12 +180,20 @@ protected:
 	EosLog			m_Log;
 	EosLog			m_PrivateLog;
 	PACKET_Q		m_Q;
+	TimedPacketQ	m_TimedQ;
 	NETEVENT_Q		m_NetEventQ;
 	QMutex			m_Mutex;
+	QMutex			m_WakeMutex;
+	QWaitCondition	m_Wake;
+	bool			m_WakePending;
+	NetworkNotifier	m_Notifier;
+	PacketCapture	*m_Capture;
 	std::string		m_Prefix;
 	std::string		m_LogMsg;
 
 	virtual void run();
+	virtual void Wake();
+	virtual void WaitForWork();
 	virtual void UpdateLog();
 	
 private:
@@ -121,6 +214,8 @@ public:
 
 	virtual void Start(const QString &ip, unsigned short port);
 	virtual void Stop();
+	virtual void SetNotifyTarget(QObject *target, const char *method) {m_Notifier.SetTarget(target, method);}
+	virtual void SetCapture(PacketCapture *capture) {m_Capture = capture;}
 	virtual void Flush(EosLog::LOG_Q &logQ, PACKET_Q &recvQ);
 
 protected:
@@ -131,6 +226,9 @@ protected:
 	EosLog			m_PrivateLog;
 	PACKET_Q		m_Q;
 	QMutex			m_Mutex;
+	NetworkNotifier	m_Notifier;
+	PacketCapture	*m_Capture;
+	qint64			m_RecvNS;
 	std::string		m_Prefix;
 	std::string		m_LogMsg;
 
@@ -156,7 +254,11 @@ public:
 
 	virtual void Start(const QString &ip, unsigned short port, OSCStream::EnumFrameMode frameMode);
 	virtual void Stop();
+	virtual void SetNotifyTarget(QObject *target, const char *method) {m_Notifier.SetTarget(target, method);}
+	virtual void SetCapture(PacketCapture *capture) {m_Capture = capture;}
 	virtual bool Send(sPacket &packet);
+	virtual bool SendAt(sPacket &packet, qint64 dueNS, const void *owner);
+	virtual void CancelSends(const void *owner);
 	virtual void Flush(EosLog::LOG_Q &logQ, PACKET_Q &recvQ, NETEVENT_Q &netEventQ);
 
 protected:
@@ -168,8 +270,14 @@ protected:
 	EosLog						m_PrivateLog;
 	PACKET_Q					m_RecvQ;
 	PACKET_Q					m_SendQ;
+	TimedPacketQ				m_TimedQ;
 	NETEVENT_Q					m_NetEventQ;
 	QMutex						m_Mutex;
+	NetworkNotifier				m_Notifier;
+	PacketCapture				*m_Capture;
+	qint64						m_RecvNS;
+	qint64						m_TimedLeadNS;	// least notice SendAt has had lately, a blocked recv cannot be woken
+	qint64						m_TimedLastNS;
 	std::string					m_Prefix;
 	std::string					m_LogMsg;
 	EosLog::EnumLogMsgType		m_LogMsgType;
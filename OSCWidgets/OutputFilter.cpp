@@ -0,0 +1,78 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "OutputFilter.h"
+#include <math.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+OutputFilter::OutputFilter()
+	: m_Sent(0)
+	, m_Pending(0)
+	, m_SentNS(0)
+	, m_HasSent(false)
+	, m_HasPending(false)
+	, m_Forced(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputFilter::Reset()
+{
+	m_HasSent = false;
+	m_HasPending = false;
+	m_Forced = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void OutputFilter::SetValue(float value, float epsilon, bool force)
+{
+	m_Pending = value;
+
+	// forced values (end points) stay pending until sent
+	if( force )
+		m_Forced = true;
+
+	// a value that returns within epsilon before it was sent cancels the pending send
+	m_HasPending = (m_Forced || !m_HasSent || fabsf(value-m_Sent)>epsilon);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool OutputFilter::TakeValue(qint64 nowNS, unsigned int rateMS, float &value)
+{
+	if( !m_HasPending )
+		return false;
+
+	if(m_HasSent && rateMS!=0 && (nowNS-m_SentNS)<static_cast<qint64>(rateMS)*1000000)
+		return false;
+
+	value = m_Pending;
+	m_Sent = m_Pending;
+	m_SentNS = nowNS;
+	m_HasSent = true;
+	m_HasPending = false;
+	m_Forced = false;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,56 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef OUTPUT_FILTER_H
+#define OUTPUT_FILTER_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// holds the latest generated value for one widget and releases it to the
+// network no faster than the send rate, and only once it moves by more than
+// epsilon from the last value sent; the display keeps its own refresh rate
+class OutputFilter
+{
+public:
+	OutputFilter();
+	virtual ~OutputFilter() {}
+
+	virtual void Reset();
+	virtual void SetValue(float value, float epsilon, bool force);
+	virtual bool TakeValue(qint64 nowNS, unsigned int rateMS, float &value);
+	virtual bool HasPending() const {return m_HasPending;}
+
+protected:
+	float	m_Sent;
+	float	m_Pending;
+	qint64	m_SentNS;
+	bool	m_HasSent;
+	bool	m_HasPending;
+	bool	m_Forced;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,323 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PacketCapture.h"
+#include "Utils.h"
+#include "Trace.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define CAPTURE_FLUSH_MS			250			// writer batches packets for up to this long
+#define CAPTURE_BLOCK_BYTES			65536		// or until this many bytes are pending
+#define CAPTURE_MAX_PENDING_BYTES	67108864	// hard cap if the disk stalls, excess packets are dropped
+#define CAPTURE_RING_BLOCK_BYTES	65536		// ring is trimmed a whole block at a time
+
+////////////////////////////////////////////////////////////////////////////////
+
+PacketCapture::PacketCapture()
+	: m_Mode(MODE_OFF)
+	, m_Run(false)
+	, m_RingNS(0)
+	, m_RingStartWallMS(0)
+	, m_RingStartNS(0)
+	, m_Packets(0)
+	, m_Bytes(0)
+	, m_Dropped(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PacketCapture::~PacketCapture()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PacketCapture::StartFile(const QString &path)
+{
+	Stop();
+
+	m_File.setFileName(path);
+	if( !m_File.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		return false;
+
+	m_Path = path;
+	m_Pending.clear();
+	m_Pending.reserve(CAPTURE_BLOCK_BYTES);
+	WriteFileHeader(m_Pending, QDateTime::currentMSecsSinceEpoch(), Utils::GetTimeNS());
+	m_Packets = m_Bytes = m_Dropped = 0;
+	m_Run = true;
+	m_Mode.fetchAndStoreOrdered(MODE_FILE);
+	start();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::StartRing(int seconds)
+{
+	Stop();
+
+	m_Mutex.lock();
+	m_Ring.clear();
+	m_RingNS = (static_cast<qint64>(qMax(1,seconds)) * 1000000000);
+	m_RingStartWallMS = QDateTime::currentMSecsSinceEpoch();
+	m_RingStartNS = Utils::GetTimeNS();
+	m_Packets = m_Bytes = m_Dropped = 0;
+	m_Mode.fetchAndStoreOrdered(MODE_RING);
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::Stop()
+{
+	m_Mutex.lock();
+	m_Mode.fetchAndStoreOrdered(MODE_OFF);
+	m_Run = false;
+	m_Wait.wakeAll();
+	m_Mutex.unlock();
+
+	// writer drains anything still pending before exiting
+	wait();
+
+	if( m_File.isOpen() )
+		m_File.close();
+
+	// ring contents are kept so they can still be saved
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PacketCapture::EnumMode PacketCapture::GetMode() const
+{
+	return static_cast<EnumMode>( m_Mode.load() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PacketCapture::SaveRing(const QString &path)
+{
+	BLOCKS blocks;
+	QByteArray header;
+
+	m_Mutex.lock();
+	blocks = m_Ring;	// implicitly shared, only the block still being filled is ever copied
+	WriteFileHeader(header, m_RingStartWallMS, m_RingStartNS);
+	m_Mutex.unlock();
+
+	QFile file(path);
+	if( !file.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		return false;
+
+	bool ok = (file.write(header) == header.size());
+	for(BLOCKS::const_iterator i=blocks.begin(); ok && i!=blocks.end(); i++)
+		ok = (file.write(i->data) == i->data.size());
+
+	file.close();
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::Add(EnumDirection direction, const sPeer &peer, const char *data, size_t size)
+{
+	// cheap early out, this is called for every packet on every network thread
+	if(m_Mode.load()==MODE_OFF || data==0 || size==0)
+		return;
+
+	sRecord record;
+	record.timeNS = Utils::GetTimeNS();
+	record.peer = peer;
+	record.direction = direction;
+	record.data = data;
+	record.size = size;
+
+	m_Mutex.lock();
+
+	switch( m_Mode.load() )
+	{
+		case MODE_FILE:
+			if((m_Pending.size() + RECORD_HEADER_SIZE + size) > CAPTURE_MAX_PENDING_BYTES)
+			{
+				m_Dropped++;
+			}
+			else
+			{
+				WriteRecord(m_Pending, record);
+				m_Packets++;
+				m_Bytes += size;
+				if(m_Pending.size() >= CAPTURE_BLOCK_BYTES)
+					m_Wait.wakeOne();
+			}
+			break;
+
+		case MODE_RING:
+			AddToRing(record);
+			m_Packets++;
+			m_Bytes += size;
+			break;
+	}
+
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::AddToRing(const sRecord &record)
+{
+	if(m_Ring.empty() || m_Ring.back().data.size()>=CAPTURE_RING_BLOCK_BYTES)
+	{
+		m_Ring.push_back( sBlock() );
+		m_Ring.back().data.reserve(CAPTURE_RING_BLOCK_BYTES + RECORD_HEADER_SIZE);
+	}
+
+	sBlock &block = m_Ring.back();
+	WriteRecord(block.data, record);
+	block.lastNS = record.timeNS;
+
+	// drop blocks that fell entirely out of the window
+	qint64 cutoffNS = (record.timeNS - m_RingNS);
+	while(m_Ring.size()>1 && m_Ring.front().lastNS<cutoffNS)
+		m_Ring.pop_front();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::GetStats(quint64 &packets, quint64 &bytes, quint64 &dropped)
+{
+	m_Mutex.lock();
+	packets = m_Packets;
+	bytes = m_Bytes;
+	dropped = m_Dropped;
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PacketCapture::sPeer PacketCapture::MakePeer(EnumTransport transport, const QHostAddress &ip, quint16 port)
+{
+	sPeer peer;
+	peer.ip = ip.toIPv4Address();
+	peer.port = port;
+	peer.transport = transport;
+	return peer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::WriteFileHeader(QByteArray &buf, qint64 startWallMS, qint64 startNS)
+{
+	uchar header[FILE_HEADER_SIZE];
+	memcpy(header, "OSCC", 4);
+	qToLittleEndian<quint16>(VERSION, header+4);
+	qToLittleEndian<quint16>(FILE_HEADER_SIZE, header+6);
+	qToLittleEndian<qint64>(startWallMS, header+8);
+	qToLittleEndian<qint64>(startNS, header+16);
+	buf.append(reinterpret_cast<const char*>(header), FILE_HEADER_SIZE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PacketCapture::ReadFileHeader(const char *buf, size_t size, qint64 &startWallMS, qint64 &startNS)
+{
+	if(buf==0 || size<FILE_HEADER_SIZE || memcmp(buf,"OSCC",4)!=0)
+		return false;
+
+	const uchar *header = reinterpret_cast<const uchar*>(buf);
+	if(qFromLittleEndian<quint16>(header+4) != VERSION)
+		return false;
+	if(qFromLittleEndian<quint16>(header+6) != FILE_HEADER_SIZE)
+		return false;
+
+	startWallMS = qFromLittleEndian<qint64>(header+8);
+	startNS = qFromLittleEndian<qint64>(header+16);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::WriteRecord(QByteArray &buf, const sRecord &record)
+{
+	uchar header[RECORD_HEADER_SIZE];
+	qToLittleEndian<qint64>(record.timeNS, header);
+	qToLittleEndian<quint32>(record.peer.ip, header+8);
+	qToLittleEndian<quint16>(record.peer.port, header+12);
+	header[14] = static_cast<uchar>(record.direction);
+	header[15] = static_cast<uchar>(record.peer.transport);
+	qToLittleEndian<quint32>(static_cast<quint32>(record.size), header+16);
+	buf.append(reinterpret_cast<const char*>(header), RECORD_HEADER_SIZE);
+	buf.append(record.data, static_cast<int>(record.size));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PacketCapture::ReadRecord(const char *buf, size_t size, sRecord &record)
+{
+	if(buf==0 || size<RECORD_HEADER_SIZE)
+		return false;
+
+	const uchar *header = reinterpret_cast<const uchar*>(buf);
+	record.timeNS = qFromLittleEndian<qint64>(header);
+	record.peer.ip = qFromLittleEndian<quint32>(header+8);
+	record.peer.port = qFromLittleEndian<quint16>(header+12);
+	record.direction = ((header[14]==DIRECTION_OUT) ? DIRECTION_OUT : DIRECTION_IN);
+	record.peer.transport = ((header[15]==TRANSPORT_TCP) ? TRANSPORT_TCP : TRANSPORT_UDP);
+	record.size = qFromLittleEndian<quint32>(header+16);
+	if(record.size > (size-RECORD_HEADER_SIZE))
+		return false;
+
+	record.data = (buf + RECORD_HEADER_SIZE);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketCapture::run()
+{
+	TRACE_THREAD_NAME("packet capture");
+
+	QByteArray block;
+
+	for(;;)
+	{
+		m_Mutex.lock();
+		if(m_Run && m_Pending.size()<CAPTURE_BLOCK_BYTES)
+			m_Wait.wait(&m_Mutex, CAPTURE_FLUSH_MS);
+		block.swap(m_Pending);
+		m_Pending.reserve(CAPTURE_BLOCK_BYTES);
+		bool run = m_Run;
+		m_Mutex.unlock();
+
+		if( !block.isEmpty() )
+		{
+			m_File.write(block);
+			m_File.flush();
+			block.clear();
+		}
+
+		if( !run )
+			break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,139 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef PACKET_CAPTURE_H
+#define PACKET_CAPTURE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <deque>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// records raw osc packets from the network threads, either streamed to a file
+// or kept in memory for the last few seconds and saved on demand
+//
+// file format, little endian:
+//   header:	char[4] "OSCC", u16 version, u16 header size, i64 start wall clock ms, i64 start time ns
+//   records:	i64 time ns, u32 ipv4, u16 port, u8 direction, u8 transport, u32 size, data[size]
+// times are Utils::GetTimeNS, the header pairs them with wall clock time
+class PacketCapture
+	: private QThread
+{
+public:
+	enum EnumConstants
+	{
+		VERSION				= 1,
+		FILE_HEADER_SIZE	= 24,
+		RECORD_HEADER_SIZE	= 20
+	};
+
+	enum EnumMode
+	{
+		MODE_OFF,
+		MODE_FILE,
+		MODE_RING
+	};
+
+	enum EnumDirection
+	{
+		DIRECTION_IN,
+		DIRECTION_OUT
+	};
+
+	enum EnumTransport
+	{
+		TRANSPORT_UDP,
+		TRANSPORT_TCP
+	};
+
+	struct sPeer
+	{
+		sPeer()
+			: ip(0)
+			, port(0)
+			, transport(TRANSPORT_UDP)
+		{}
+		quint32			ip;
+		quint16			port;
+		EnumTransport	transport;
+	};
+
+	struct sRecord
+	{
+		qint64			timeNS;
+		sPeer			peer;
+		EnumDirection	direction;
+		const char		*data;
+		size_t			size;
+	};
+
+	PacketCapture();
+	virtual ~PacketCapture();
+
+	virtual bool StartFile(const QString &path);
+	virtual void StartRing(int seconds);
+	virtual void Stop();
+	virtual EnumMode GetMode() const;
+	virtual const QString& GetPath() const {return m_Path;}
+	virtual bool SaveRing(const QString &path);
+	virtual void Add(EnumDirection direction, const sPeer &peer, const char *data, size_t size);
+	virtual void GetStats(quint64 &packets, quint64 &bytes, quint64 &dropped);
+
+	static sPeer MakePeer(EnumTransport transport, const QHostAddress &ip, quint16 port);
+	static void WriteFileHeader(QByteArray &buf, qint64 startWallMS, qint64 startNS);
+	static bool ReadFileHeader(const char *buf, size_t size, qint64 &startWallMS, qint64 &startNS);
+	static void WriteRecord(QByteArray &buf, const sRecord &record);
+	static bool ReadRecord(const char *buf, size_t size, sRecord &record);
+
+protected:
+	struct sBlock
+	{
+		QByteArray	data;
+		qint64		lastNS;
+	};
+
+	typedef std::deque<sBlock> BLOCKS;
+
+	QAtomicInt		m_Mode;
+	bool			m_Run;
+	QString			m_Path;
+	QFile			m_File;
+	QByteArray		m_Pending;
+	BLOCKS			m_Ring;
+	qint64			m_RingNS;
+	qint64			m_RingStartWallMS;
+	qint64			m_RingStartNS;
+	quint64			m_Packets;
+	quint64			m_Bytes;
+	quint64			m_Dropped;
+	QMutex			m_Mutex;
+	QWaitCondition	m_Wait;
+
+	virtual void AddToRing(const sRecord &record);
+	virtual void run();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,234 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PacketReplay.h"
+#include "Utils.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+PacketReplay::PacketReplay(Client &client)
+	: m_pClient(&client)
+	, m_Data(0)
+	, m_Size(0)
+	, m_Position(0)
+	, m_Direction(PacketCapture::DIRECTION_IN)
+	, m_Speed(1.0)
+	, m_FirstNS(0)
+	, m_StartNS(0)
+	, m_EndNS(0)
+{
+	m_Parser.SetRoot(new OSCHandler(*this));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PacketReplay::~PacketReplay()
+{
+	Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PacketReplay::Start(const QString &path, PacketCapture::EnumDirection direction, double speed)
+{
+	Stop();
+
+	m_Direction = direction;
+	m_Speed = ((speed>0) ? speed : 0);
+
+	if( !Load(path) )
+	{
+		Unload();
+		return false;
+	}
+
+	m_StartNS = m_EndNS = Utils::GetTimeNS();
+	m_Timer.start(0, Qt::PreciseTimer, this);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketReplay::Stop()
+{
+	m_Timer.stop();
+	Unload();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 PacketReplay::GetElapsedNS() const
+{
+	return ((IsRunning() ? Utils::GetTimeNS() : m_EndNS) - m_StartNS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PacketReplay::Load(const QString &path)
+{
+	m_File.setFileName(path);
+	if( !m_File.open(QIODevice::ReadOnly) )
+		return false;
+
+	qint64 fileSize = m_File.size();
+	uchar *mapped = ((fileSize>0) ? m_File.map(0,fileSize) : 0);
+	if( mapped )
+	{
+		m_Data = reinterpret_cast<const char*>(mapped);
+	}
+	else
+	{
+		m_Buffer = m_File.readAll();
+		m_Data = m_Buffer.constData();
+	}
+	m_Size = static_cast<size_t>(fileSize);
+
+	qint64 startWallMS = 0;
+	qint64 startNS = 0;
+	if( !PacketCapture::ReadFileHeader(m_Data,m_Size,startWallMS,startNS) )
+		return false;
+
+	// index records in the requested direction, a truncated final record ends the capture
+	PacketCapture::sRecord record;
+	size_t offset = PacketCapture::FILE_HEADER_SIZE;
+	while( PacketCapture::ReadRecord(m_Data+offset,m_Size-offset,record) )
+	{
+		if(record.direction == m_Direction)
+		{
+			if( m_Offsets.empty() )
+				m_FirstNS = record.timeNS;
+			m_Offsets.push_back(offset);
+		}
+
+		offset += (PacketCapture::RECORD_HEADER_SIZE + record.size);
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketReplay::Unload()
+{
+	m_Offsets.clear();
+	m_Position = 0;
+	m_Data = 0;
+	m_Size = 0;
+	m_Buffer.clear();
+
+	// closing unmaps
+	if( m_File.isOpen() )
+		m_File.close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 PacketReplay::GetDueNS(const PacketCapture::sRecord &record) const
+{
+	if(m_Speed <= 0)
+		return m_StartNS;
+
+	return (m_StartNS + static_cast<qint64>((record.timeNS - m_FirstNS)/m_Speed));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketReplay::Dispatch(const PacketCapture::sRecord &record, qint64 dueNS)
+{
+	if(record.size == 0)
+		return;
+
+	if(m_Direction == PacketCapture::DIRECTION_IN)
+	{
+		// parsed in place, so work on a copy of the mapped data
+		m_Scratch.resize( static_cast<int>(record.size) );
+		memcpy(m_Scratch.data(), record.data, record.size);
+		m_Parser.ProcessPacket(*this, m_Scratch.data(), record.size);
+	}
+	else
+	{
+		char *data = new char[record.size];
+		memcpy(data, record.data, record.size);
+		m_pClient->PacketReplayClient_Send(data, record.size, dueNS);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketReplay::timerEvent(QTimerEvent *event)
+{
+	if(event->timerId() != m_Timer.timerId())
+	{
+		QObject::timerEvent(event);
+		return;
+	}
+
+	qint64 nowNS = Utils::GetTimeNS();
+	qint64 batchEndNS = (nowNS + BATCH_MS*1000000);
+	qint64 lookaheadNS = ((m_Direction==PacketCapture::DIRECTION_OUT) ? (LOOKAHEAD_MS*1000000) : 0);
+	qint64 nextDueNS = 0;
+
+	PacketCapture::sRecord record;
+	while(m_Position < m_Offsets.size())
+	{
+		size_t offset = m_Offsets[m_Position];
+		PacketCapture::ReadRecord(m_Data+offset, m_Size-offset, record);
+
+		qint64 dueNS = GetDueNS(record);
+		if(dueNS > nowNS+lookaheadNS)
+		{
+			nextDueNS = dueNS;
+			break;
+		}
+
+		Dispatch(record, dueNS);
+		m_Position++;
+
+		// as fast as possible still yields to the gui between batches
+		if(m_Speed<=0 && (m_Position&0xff)==0)
+		{
+			nowNS = Utils::GetTimeNS();
+			if(nowNS >= batchEndNS)
+				return;
+		}
+	}
+
+	if(m_Position >= m_Offsets.size())
+	{
+		m_Timer.stop();
+		m_EndNS = Utils::GetTimeNS();
+		m_pClient->PacketReplayClient_Finished();
+		return;
+	}
+
+	// sleep until the next packet is due
+	qint64 waitMS = ((nextDueNS - lookaheadNS - Utils::GetTimeNS()) / 1000000);
+	m_Timer.start(static_cast<int>(qBound(static_cast<qint64>(0),waitMS,static_cast<qint64>(1000))), Qt::PreciseTimer, this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PacketReplay::OSCHandlerClient_Recv(OSCParserClient& /*client*/, char *buf, size_t size)
+{
+	if(buf!=0 && size!=0)
+		m_pClient->PacketReplayClient_Recv(buf, size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
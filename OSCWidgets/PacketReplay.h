@@ -0,0 +1,101 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef PACKET_REPLAY_H
+#define PACKET_REPLAY_H
+
+#ifndef NETWORK_THREADS_H
+#include "NetworkThreads.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// plays back one direction of a PacketCapture file, inbound packets are split
+// into messages and handed to the client as if just received, outbound packets
+// are handed over with a due time for the network thread to send
+//
+// speed scales the original inter-packet timing, 0 plays as fast as possible
+// in batches of roughly BATCH_MS so the gui keeps running
+class PacketReplay
+	: public QObject
+	, private OSCParserClient
+	, private OSCHandler::Client
+{
+public:
+	enum EnumConstants
+	{
+		BATCH_MS		= 8,
+		LOOKAHEAD_MS	= 20	// outbound packets are handed over this early, the network thread sends them on time
+	};
+
+	class Client
+	{
+	public:
+		virtual void PacketReplayClient_Recv(char *data, size_t size) = 0;
+		virtual bool PacketReplayClient_Send(char *data, size_t size, qint64 dueNS) = 0;	// takes ownership of data
+		virtual void PacketReplayClient_Finished() = 0;
+	};
+
+	PacketReplay(Client &client);
+	virtual ~PacketReplay();
+
+	virtual bool Start(const QString &path, PacketCapture::EnumDirection direction, double speed);
+	virtual void Stop();
+	virtual bool IsRunning() const {return m_Timer.isActive();}
+	virtual PacketCapture::EnumDirection GetDirection() const {return m_Direction;}
+	virtual size_t GetPosition() const {return m_Position;}
+	virtual size_t GetCount() const {return m_Offsets.size();}
+	virtual qint64 GetElapsedNS() const;
+
+protected:
+	typedef std::vector<size_t> OFFSETS;
+
+	Client							*m_pClient;
+	QFile							m_File;
+	const char						*m_Data;
+	size_t							m_Size;
+	QByteArray						m_Buffer;	// when the file can not be mapped
+	QByteArray						m_Scratch;
+	OFFSETS							m_Offsets;
+	size_t							m_Position;
+	PacketCapture::EnumDirection	m_Direction;
+	double							m_Speed;
+	qint64							m_FirstNS;
+	qint64							m_StartNS;
+	qint64							m_EndNS;
+	OSCParser						m_Parser;
+	QBasicTimer						m_Timer;
+
+	virtual bool Load(const QString &path);
+	virtual void Unload();
+	virtual qint64 GetDueNS(const PacketCapture::sRecord &record) const;
+	virtual void Dispatch(const PacketCapture::sRecord &record, qint64 dueNS);
+	virtual void timerEvent(QTimerEvent *event);
+
+private:
+	virtual void OSCParserClient_Log(const std::string&) {}
+	virtual void OSCParserClient_Send(const char*, size_t) {}
+	virtual void OSCHandlerClient_Recv(OSCParserClient &client, char *buf, size_t size);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,151 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "PixmapLoader.h"
+#include "Utils.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+PixmapLoader::PixmapLoader(Client &client, int numThreads)
+	: m_Client(client)
+	, m_Run(true)
+	, m_Posted(false)
+{
+	for(int i=0; i<numThreads; i++)
+	{
+		Worker *worker = new Worker(*this);
+		m_Workers.push_back(worker);
+		worker->start(QThread::LowPriority);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+PixmapLoader::~PixmapLoader()
+{
+	m_Mutex.lock();
+	m_Run = false;
+	m_Jobs.clear();
+	m_JobReady.wakeAll();
+	m_Mutex.unlock();
+
+	for(WORKERS::const_iterator i=m_Workers.begin(); i!=m_Workers.end(); i++)
+	{
+		(*i)->wait();
+		delete *i;
+	}
+	m_Workers.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapLoader::Load(const sJob &job)
+{
+	if( m_Workers.empty() )
+	{
+		// no pool, finish it here
+		sJob done(job);
+		Run(done);
+		m_Client.PixmapLoaderClient_Loaded(done);
+		return;
+	}
+
+	m_Mutex.lock();
+	m_Jobs.push_back(job);
+	m_JobReady.wakeOne();
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapLoader::Run(sJob &job)
+{
+	if( job.decode )
+	{
+		QImageReader reader(job.path);
+		job.source = reader.read();
+	}
+
+	QImage::Format format = (job.source.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+
+	for(SCALED_LIST::iterator i=job.scaled.begin(); i!=job.scaled.end(); i++)
+	{
+		QSize size = PixmapCache::GetScaledSize(job.source.size(), i->size, static_cast<PixmapCache::EnumScaleMode>(i->mode));
+		if( size.isEmpty() )
+			i->image = QImage();
+		else
+			i->image = job.source.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(format);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapLoader::Process()
+{
+	m_Mutex.lock();
+
+	while( m_Run )
+	{
+		if( m_Jobs.empty() )
+		{
+			m_JobReady.wait( &m_Mutex );
+			continue;
+		}
+
+		sJob job( m_Jobs.front() );
+		m_Jobs.pop_front();
+		m_Mutex.unlock();
+
+		Run(job);
+
+		m_Mutex.lock();
+		m_Results.push_back(job);
+		if( !m_Posted )
+		{
+			// one wake up for however many results pile up before the gui gets to them
+			m_Posted = true;
+			QCoreApplication::postEvent(this, new QEvent(QEvent::User));
+		}
+	}
+
+	m_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapLoader::customEvent(QEvent *event)
+{
+	if(event->type() != QEvent::User)
+	{
+		QObject::customEvent(event);
+		return;
+	}
+
+	JOB_Q results;
+	m_Mutex.lock();
+	results.swap(m_Results);
+	m_Posted = false;
+	m_Mutex.unlock();
+
+	for(JOB_Q::iterator i=results.begin(); i!=results.end(); i++)
+		m_Client.PixmapLoaderClient_Loaded(*i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,113 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef PIXMAP_LOADER_H
+#define PIXMAP_LOADER_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+#include <vector>
+#include <deque>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// decodes and pre-scales images as QImages on a small pool of worker threads,
+// finished jobs are handed back on the gui thread to become pixmaps there
+class PixmapLoader
+	: public QObject
+{
+public:
+	struct sScaled
+	{
+		sScaled()
+			: mode(0)
+		{}
+
+		QSize	size;	// requested bounds
+		int		mode;	// PixmapCache::EnumScaleMode
+		QImage	image;
+	};
+
+	typedef std::vector<sScaled> SCALED_LIST;
+
+	struct sJob
+	{
+		sJob()
+			: decode(false)
+		{}
+
+		QString		path;
+		bool		decode;	// decode source from path, otherwise scale the given source
+		QImage		source;
+		SCALED_LIST	scaled;
+	};
+
+	typedef std::deque<sJob> JOB_Q;
+
+	class Client
+	{
+	public:
+		virtual void PixmapLoaderClient_Loaded(sJob &job) = 0;
+	};
+
+	PixmapLoader(Client &client, int numThreads);
+	virtual ~PixmapLoader();
+
+	virtual void Load(const sJob &job);
+	virtual size_t GetNumThreads() const {return m_Workers.size();}
+
+	static void Run(sJob &job);
+
+protected:
+	class Worker
+		: public QThread
+	{
+	public:
+		Worker(PixmapLoader &loader)
+			: m_Loader(loader)
+		{}
+
+	protected:
+		PixmapLoader	&m_Loader;
+
+		virtual void run() {m_Loader.Process();}
+	};
+
+	typedef std::vector<Worker*> WORKERS;
+
+	Client			&m_Client;
+	WORKERS			m_Workers;
+	bool			m_Run;
+	bool			m_Posted;
+	JOB_Q			m_Jobs;
+	JOB_Q			m_Results;
+	QMutex			m_Mutex;
+	QWaitCondition	m_JobReady;
+
+	virtual void Process();
+	virtual void customEvent(QEvent *event);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
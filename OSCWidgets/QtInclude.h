@@ -54,9 +54,16 @@
 #include <QtCore/QSettings>
 #include <QtCore/QFile>
 #include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 #include <QtCore/QTextStream>
 #include <QtCore/QUrl>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QBasicTimer>
+#include <QtCore/QSet>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QtEndian>
+#include <QtCore/QCommandLineParser>
 
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QWidget>
@@ -79,19 +86,26 @@
 #include <QtWidgets/QComboBox>
 #include <QtWidgets/QDesktopWidget>
 #include <QtWidgets/QTreeWidget>
+#include <QtWidgets/QHeaderView>
 #include <QtWidgets/QGroupBox>
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QSystemTrayIcon>
 #include <QtWidgets/QMenuBar>
+#include <QtWidgets/QActionGroup>
+#include <QtWidgets/QToolTip>
 
 #include <QtGui/QDesktopServices>
 #include <QtGui/QCloseEvent>
 #include <QtGui/QPainter>
+#include <QtGui/QStaticText>
 #include <QtGui/QImageReader>
 #include <QtGui/QFontDatabase>
 #include <QtGui/QMatrix4x4>
 
 #include <QtNetwork/QNetworkInterface>
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#include <QtNetwork/QUdpSocket>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -86,6 +86,48 @@ AdvancedPanel::AdvancedPanel(QWidget *parent)
 	layout->addWidget(new QLabel(tr("Flicker Refresh Rate (ms)"),this), row, 0);
 	layout->addWidget(m_FlickerRefreshRate, row, 1);
 
+	++row;
+	m_SineSendRate = new QLineEdit(this);
+	m_SineSendRate->setToolTip( tr("Minimum time between network sends, for grids with a blank Send Rate\n\n0 = Send every refresh") );
+	layout->addWidget(new QLabel(tr("Sine Wave Send Rate (ms)"),this), row, 0);
+	layout->addWidget(m_SineSendRate, row, 1);
+
+	++row;
+	m_PedalSendRate = new QLineEdit(this);
+	m_PedalSendRate->setToolTip( tr("Minimum time between network sends, for grids with a blank Send Rate\n\n0 = Send every refresh") );
+	layout->addWidget(new QLabel(tr("Pedal Send Rate (ms)"),this), row, 0);
+	layout->addWidget(m_PedalSendRate, row, 1);
+
+	++row;
+	m_FlickerSendRate = new QLineEdit(this);
+	m_FlickerSendRate->setToolTip( tr("Minimum time between network sends, for grids with a blank Send Rate\n\n0 = Send every refresh") );
+	layout->addWidget(new QLabel(tr("Flicker Send Rate (ms)"),this), row, 0);
+	layout->addWidget(m_FlickerSendRate, row, 1);
+
+	++row;
+	m_SendEpsilon = new QLineEdit(this);
+	m_SendEpsilon->setToolTip( tr("Sine wave, pedal and flicker values are only sent\nonce they change by more than this amount\n\n0 = Send any change") );
+	layout->addWidget(new QLabel(tr("Send Epsilon"),this), row, 0);
+	layout->addWidget(m_SendEpsilon, row, 1);
+
+	++row;
+	m_FlickerSeed = new QLineEdit(this);
+	m_FlickerSeed->setToolTip( tr("Saved with show file\n\n0 = Random every run") );
+	layout->addWidget(new QLabel(tr("Flicker Seed"),this), row, 0);
+	layout->addWidget(m_FlickerSeed, row, 1);
+
+	++row;
+	m_CellGridThreshold = new QLineEdit(this);
+	m_CellGridThreshold->setToolTip( tr("Button and label grids with at least this many\ncells are drawn by a single widget\n\n0 = Never") );
+	layout->addWidget(new QLabel(tr("Lightweight Grid Cells"),this), row, 0);
+	layout->addWidget(m_CellGridThreshold, row, 1);
+
+	++row;
+	m_ImageCacheMB = new QLineEdit(this);
+	m_ImageCacheMB->setToolTip( tr("Decoded and scaled images not currently on screen\nare released once the cache grows past this size\n\n0 = Unlimited") );
+	layout->addWidget(new QLabel(tr("Image Cache (MB)"),this), row, 0);
+	layout->addWidget(m_ImageCacheMB, row, 1);
+
 	++row;
 	QPushButton *button = new QPushButton(tr("Restore Defaults"), this);
 	QPalette pal( button->palette() );
@@ -113,6 +155,13 @@ void AdvancedPanel::Load()
 	m_SineRefreshRate->setText( QString::number(Toy::GetSineRefreshRateMS()) );
 	m_PedalRefreshRate->setText( QString::number(Toy::GetPedalRefreshRateMS()) );
 	m_FlickerRefreshRate->setText( QString::number(Toy::GetFlickerRefreshRateMS()) );
+	m_SineSendRate->setText( QString::number(Toy::GetSineSendRateMS()) );
+	m_PedalSendRate->setText( QString::number(Toy::GetPedalSendRateMS()) );
+	m_FlickerSendRate->setText( QString::number(Toy::GetFlickerSendRateMS()) );
+	m_SendEpsilon->setText( QString::number(Toy::GetSendEpsilon()) );
+	m_FlickerSeed->setText( QString::number(Toy::GetFlickerSeed()) );
+	m_CellGridThreshold->setText( QString::number(Toy::GetCellGridThreshold()) );
+	m_ImageCacheMB->setText( QString::number(Toy::GetImageCacheMB()) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -127,14 +176,24 @@ void AdvancedPanel::Save()
 	Toy::SetSineRefreshRateMS( m_SineRefreshRate->text().toUInt() );
 	Toy::SetPedalRefreshRateMS( m_PedalRefreshRate->text().toUInt() );
 	Toy::SetFlickerRefreshRateMS( m_FlickerRefreshRate->text().toUInt() );
+	Toy::SetSineSendRateMS( m_SineSendRate->text().toUInt() );
+	Toy::SetPedalSendRateMS( m_PedalSendRate->text().toUInt() );
+	Toy::SetFlickerSendRateMS( m_FlickerSendRate->text().toUInt() );
+	Toy::SetSendEpsilon( m_SendEpsilon->text().toFloat() );
+	Toy::SetFlickerSeed( m_FlickerSeed->text().toUInt() );
+	Toy::SetCellGridThreshold( m_CellGridThreshold->text().toUInt() );
+	Toy::SetImageCacheMB( m_ImageCacheMB->text().toUInt() );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void AdvancedPanel::onApplyClicked(bool /*checked*/)
 {
+	bool seedChanged = (m_FlickerSeed->text().toUInt() != Toy::GetFlickerSeed());
 	Save();
 	emit changed();
+	if( seedChanged )
+		emit showChanged();
 	close();
 }
 
@@ -33,7 +33,12 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #define SETTING_LOG_DEPTH					"LogDepth"
-#define SETTING_FILE_DEPTH					"FileDepth"
+#define SETTING_FILE_SIZE_KB				"FileSizeKB"
+#define SETTING_FILE_COUNT					"FileCount"
+#define SETTING_CAPTURE_RING_SECONDS		"CaptureRingSeconds"
+#define SETTING_REPLAY_SPEED				"ReplaySpeed"
+#define SETTING_SHOW_METRICS				"ShowMetrics"
+#define SETTING_LATENCY_PROBES				"LatencyProbes"
 #define SETTING_LAST_FILE					"LastFile"
 #define SETTING_ENCODER_DEGREES_PER_TICK	"EncoderDegreesPerTick"
 #define SETTING_FEEDBACK_DELAY				"FeedbackDelay"
@@ -41,6 +46,12 @@
 #define SETTING_METRO_REFRESH_RATE			"MetroRefreshRate"
 #define SETTING_SINE_REFRESH_RATE			"SineWaveRefreshRate"
 #define SETTING_PEDAL_REFRESH_RATE			"PedalRefreshRate"
+#define SETTING_SINE_SEND_RATE				"SineWaveSendRate"
+#define SETTING_PEDAL_SEND_RATE				"PedalSendRate"
+#define SETTING_FLICKER_SEND_RATE			"FlickerSendRate"
+#define SETTING_SEND_EPSILON				"SendEpsilon"
+#define SETTING_CELL_GRID_THRESHOLD			"CellGridThreshold"
+#define SETTING_IMAGE_CACHE_MB				"ImageCacheMB"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -77,6 +88,7 @@ public:
 
 signals:
 	void changed();
+	void showChanged();
 
 private slots:
 	void onApplyClicked(bool checked);
@@ -90,6 +102,13 @@ protected:
 	QLineEdit	*m_SineRefreshRate;
 	QLineEdit	*m_PedalRefreshRate;
 	QLineEdit	*m_FlickerRefreshRate;
+	QLineEdit	*m_SineSendRate;
+	QLineEdit	*m_PedalSendRate;
+	QLineEdit	*m_FlickerSendRate;
+	QLineEdit	*m_SendEpsilon;
+	QLineEdit	*m_FlickerSeed;
+	QLineEdit	*m_CellGridThreshold;
+	QLineEdit	*m_ImageCacheMB;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
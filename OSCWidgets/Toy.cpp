@@ -33,6 +33,7 @@
 #include "ToyActivity.h"
 #include "ToyLabel.h"
 #include "ToyWindow.h"
+#include "Metrics.h"
 
 #ifdef WIN32
 	#include <Windows.h>
@@ -53,6 +54,13 @@ unsigned int Toy::sm_MetroRefreshRateMS = 0;
 unsigned int Toy::sm_SineRefreshRateMS = 0;
 unsigned int Toy::sm_PedalRefreshRateMS = 0;
 unsigned int Toy::sm_FlickerRefreshRateMS = 0;
+unsigned int Toy::sm_SineSendRateMS = 0;
+unsigned int Toy::sm_PedalSendRateMS = 0;
+unsigned int Toy::sm_FlickerSendRateMS = 0;
+float Toy::sm_SendEpsilon = 0;
+unsigned int Toy::sm_FlickerSeed = 0;
+unsigned int Toy::sm_CellGridThreshold = 0;
+unsigned int Toy::sm_ImageCacheMB = 0;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -145,6 +153,36 @@ void Toy::GetDefaultPathName(EnumToyType type, QString &name)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+Toy::EnumToyType Toy::GetTypeOf(const QObject *obj)
+{
+	// nearest enclosing toy, so a grid inside a window reports the grid
+	for(; obj; obj=obj->parent())
+	{
+		const Toy *toy = qobject_cast<const Toy*>(obj);
+		if( toy )
+			return toy->GetType();
+	}
+
+	return TOY_INVALID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+int Toy::GetLatencySource(const QObject *obj)
+{
+	// -1 unless latency probes are on and obj belongs to a toy
+	if( METRICS.GetLatencyProbes() )
+	{
+		EnumToyType type = GetTypeOf(obj);
+		if(type < TOY_COUNT)
+			return static_cast<int>(type);
+	}
+
+	return -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Toy::SetDefaultWindowIcon(QWidget &w)
 {
 	// NOTE: looks cleaner without window icons on Mac
@@ -330,6 +368,12 @@ void Toy::RestoreDefaultSettings()
 	sm_SineRefreshRateMS = 10;
 	sm_PedalRefreshRateMS = 10;
 	sm_FlickerRefreshRateMS = 10;
+	sm_SineSendRateMS = 0;
+	sm_PedalSendRateMS = 0;
+	sm_FlickerSendRateMS = 0;
+	sm_SendEpsilon = 0;
+	sm_CellGridThreshold = 400;
+	sm_ImageCacheMB = 256;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -34,6 +34,10 @@
 #include "ToyMath.h"
 #endif
 
+#ifndef TOY_WIDGET_H
+#include "ToyWidget.h"
+#endif
+
 #include <vector>
 
 class EosLog;
@@ -71,6 +75,8 @@ public:
 	{
 	public:
 		virtual bool ToyClient_Send(bool local, char *data, size_t size) = 0;
+		virtual bool ToyClient_SendAt(char *data, size_t size, qint64 dueNS, const void *owner) = 0;
+		virtual void ToyClient_CancelSends(const void *owner) = 0;
 		virtual void ToyClient_ResourceRelativePathToAbsolute(QString &path) = 0;
 	};
 	
@@ -105,12 +111,16 @@ public:
 	virtual void GetDefaultGridSize(QSize &gridSize) const = 0;
 	virtual void ClearLabels() = 0;
 	virtual void StartTimer() {}
+	virtual void UpdateCellMode() {}
+	virtual void AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const {usage.toys++;}
 	virtual void Connected() {}
 	virtual void Disconnected() {}
 	
 	static Toy* Create(EnumToyType type, Client *pClient, QWidget *parent, Qt::WindowFlags flags);
 	static void GetName(EnumToyType type, QString &name);
 	static void GetDefaultPathName(EnumToyType type, QString &path);
+	static EnumToyType GetTypeOf(const QObject *obj);
+	static int GetLatencySource(const QObject *obj);
 	static void SnapToScreen(QWidget &w, int threshold);
 	static void ClipToScreen(QWidget &w);
 	static void SetDefaultWindowIcon(QWidget &w);
@@ -131,6 +141,20 @@ public:
 	static void SetPedalRefreshRateMS(unsigned int n) {sm_PedalRefreshRateMS = qBound(static_cast<unsigned int>(1),n,static_cast<unsigned int>(250));}
 	static unsigned int GetFlickerRefreshRateMS() {return sm_FlickerRefreshRateMS;}
 	static void SetFlickerRefreshRateMS(unsigned int n) {sm_FlickerRefreshRateMS = qBound(static_cast<unsigned int>(1),n,static_cast<unsigned int>(60000));}
+	static unsigned int GetSineSendRateMS() {return sm_SineSendRateMS;}
+	static void SetSineSendRateMS(unsigned int n) {sm_SineSendRateMS = qMin(n,static_cast<unsigned int>(60000));}	// 0 = every refresh
+	static unsigned int GetPedalSendRateMS() {return sm_PedalSendRateMS;}
+	static void SetPedalSendRateMS(unsigned int n) {sm_PedalSendRateMS = qMin(n,static_cast<unsigned int>(60000));}	// 0 = every refresh
+	static unsigned int GetFlickerSendRateMS() {return sm_FlickerSendRateMS;}
+	static void SetFlickerSendRateMS(unsigned int n) {sm_FlickerSendRateMS = qMin(n,static_cast<unsigned int>(60000));}	// 0 = every refresh
+	static float GetSendEpsilon() {return sm_SendEpsilon;}
+	static void SetSendEpsilon(float n) {sm_SendEpsilon = qBound(0.0f,n,1000000.0f);}	// 0 = send any change
+	static unsigned int GetFlickerSeed() {return sm_FlickerSeed;}
+	static void SetFlickerSeed(unsigned int n) {sm_FlickerSeed = n;}	// 0 = random, saved with show file
+	static unsigned int GetCellGridThreshold() {return sm_CellGridThreshold;}
+	static void SetCellGridThreshold(unsigned int n) {sm_CellGridThreshold = qMin(n,static_cast<unsigned int>(1000000));}	// 0 = never
+	static unsigned int GetImageCacheMB() {return sm_ImageCacheMB;}
+	static void SetImageCacheMB(unsigned int n) {sm_ImageCacheMB = qMin(n,static_cast<unsigned int>(65536));}	// 0 = unlimited
 	static void RestoreDefaultSettings();
 	
 signals:
@@ -150,6 +174,13 @@ protected:
 	static unsigned int	sm_SineRefreshRateMS;
 	static unsigned int	sm_PedalRefreshRateMS;
 	static unsigned int sm_FlickerRefreshRateMS;
+	static unsigned int	sm_SineSendRateMS;
+	static unsigned int	sm_PedalSendRateMS;
+	static unsigned int	sm_FlickerSendRateMS;
+	static float		sm_SendEpsilon;
+	static unsigned int	sm_FlickerSeed;
+	static unsigned int	sm_CellGridThreshold;
+	static unsigned int	sm_ImageCacheMB;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -21,6 +21,7 @@
 #include "ToyActivity.h"
 #include "Utils.h"
 #include "OSCParser.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -34,10 +35,16 @@ bool FadeActivity::sFadeTiming::operator==(const sFadeTiming &other) const
 FadeActivity::FadeActivity(QWidget *parent)
 	: FadeButton_NoTouch(parent)
 	, m_FadeState(FADE_OFF)
+	, m_ActivityAnimating(false)
 	, m_FadeElapsed(0)
 {
-	m_ActivityTimer = new QTimer(this);
-	connect(m_ActivityTimer, SIGNAL(timeout()), this, SLOT(onUpdate()));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+FadeActivity::~FadeActivity()
+{
+	ANIM.Stop(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -47,7 +54,7 @@ void FadeActivity::SetText(const QString &text)
 	if(this->text() != text)
 	{
 		setText(text);
-		update();
+		Invalidate();
 	}
 }
 
@@ -61,7 +68,7 @@ void FadeActivity::SetFadeTiming(const sFadeTiming &fadeTiming)
 
 		if(	m_FadeState==FADE_ON &&
 			m_FadeTiming.hold!=static_cast<unsigned int>(FADE_HOLD_INFINITE) &&
-			!m_ActivityTimer->isActive() )
+			!m_ActivityAnimating )
 		{
 			StartActivityTimer();
 		}
@@ -80,11 +87,11 @@ void FadeActivity::SetOn(bool b)
 				m_FadeElapsed = 0;
 				m_FadeState = FADE_IN;
 				StartActivityTimer();
-				onUpdate();
+				UpdateActivity();
 				break;
 
 			case FADE_IN:
-				onUpdate();
+				UpdateActivity();
 				break;
 
 			case FADE_ON:
@@ -94,7 +101,7 @@ void FadeActivity::SetOn(bool b)
 			case FADE_OUT:
 				m_FadeElapsed = static_cast<unsigned int>( qRound((1.0f-GetFadePercent())*m_FadeTiming.in) );
 				m_FadeState = FADE_IN;
-				onUpdate();
+				UpdateActivity();
 				break;
 		}
 	}
@@ -105,18 +112,18 @@ void FadeActivity::SetOn(bool b)
 			case FADE_IN:
 				m_FadeElapsed = static_cast<unsigned int>( qRound((1.0f-GetFadePercent())*m_FadeTiming.out) );
 				m_FadeState = FADE_OUT;
-				onUpdate();
+				UpdateActivity();
 				break;
 
 			case FADE_ON:
 				m_FadeElapsed = 0;
 				m_FadeState = FADE_OUT;
 				StartActivityTimer();
-				onUpdate();
+				UpdateActivity();
 				break;
 
 			case FADE_OUT:
-				onUpdate();
+				UpdateActivity();
 				break;
 		}
 	}
@@ -126,8 +133,9 @@ void FadeActivity::SetOn(bool b)
 
 void FadeActivity::StartActivityTimer()
 {
-	m_ActivityEosTimer.Start();
-	m_ActivityTimer->start(20);
+	m_ActivityTimer.Start();
+	m_ActivityAnimating = true;
+	ANIM.Start(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -172,9 +180,9 @@ float FadeActivity::GetFadePercent() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void FadeActivity::onUpdate()
+void FadeActivity::UpdateActivity()
 {
-	m_FadeElapsed += m_ActivityEosTimer.Restart();
+	m_FadeElapsed += m_ActivityTimer.Restart();
 
 	switch( m_FadeState )
 	{
@@ -192,7 +200,7 @@ void FadeActivity::onUpdate()
 			{
 				if(m_FadeTiming.hold == static_cast<unsigned int>(FADE_HOLD_INFINITE))
 				{
-					m_ActivityTimer->stop();
+					m_ActivityAnimating = false;
 				}
 				else if(GetFadePercent() >= 1.0f)
 				{
@@ -207,23 +215,41 @@ void FadeActivity::onUpdate()
 				if(GetFadePercent() >= 1.0f)
 				{
 					m_FadeState = FADE_OFF;
-					m_ActivityTimer->stop();
+					m_ActivityAnimating = false;
 				}
 			}
 			break;
 
 		default:
-			m_ActivityTimer->stop();
+			m_ActivityAnimating = false;
 			break;
 	}
 
-	update();
+	Invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool FadeActivity::AnimationClient_Tick()
+{
+	bool animating = FadeButton_NoTouch::AnimationClient_Tick();
+
+	if( m_ActivityAnimating )
+	{
+		UpdateActivity();
+		if( m_ActivityAnimating )
+			animating = true;
+	}
+
+	return animating;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void FadeActivity::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeActivity::paintEvent");
+
 	QRectF r( rect() );
 	r.adjust(1, 1, -1, -1);
 	
@@ -235,9 +261,7 @@ void FadeActivity::paintEvent(QPaintEvent* /*event*/)
 	const QPixmap &pixmap = m_Images[m_ImageIndex].pixmap;
 	if( pixmap.isNull() )
 	{
-		painter.setPen(Qt::NoPen);
-		painter.setBrush( palette().color(QPalette::Button) );
-		painter.drawRoundedRect(r, ROUNDED, ROUNDED);
+		RenderBackgroundLayer(painter, r, QPen(Qt::NoPen), palette().color(QPalette::Button));
 	}
 	else
 	{
@@ -257,35 +281,7 @@ void FadeActivity::paintEvent(QPaintEvent* /*event*/)
 	
 	QColor textColor( palette().color(QPalette::ButtonText) );
 
-	if( !text().isEmpty() )
-	{
-		if( m_Label.isEmpty() )
-		{
-			// just text centered
-			painter.setPen(textColor);
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap, text());
-		}
-		else
-		{
-			// both text and label text
-			QRectF textRect;
-			painter.setPen(textColor);
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontPrint, text(), &textRect);
-
-			QRectF labelRect;
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontPrint, m_Label, &labelRect);
-
-			qreal h = (r.height() * 0.5 * (textRect.height()/labelRect.height()));
-			painter.drawText(QRectF(r.x(),r.y(),r.width(),h), Qt::AlignCenter|Qt::TextWordWrap, text());
-			painter.drawText(QRectF(r.x(),r.y()+h,r.width(),r.height()-h), Qt::AlignCenter|Qt::TextWordWrap, m_Label);
-		}
-	}
-	else if( !m_Label.isEmpty() )
-	{
-		// just label text centered
-		painter.setPen(textColor);
-		painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap, m_Label);
-	}
+	RenderText(painter, r, textColor);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -60,14 +60,12 @@ public:
 	};
 
 	FadeActivity(QWidget *parent);
+	virtual ~FadeActivity();
 
 	virtual void SetText(const QString &text);
 	virtual void SetFadeTiming(const sFadeTiming &fadeTiming);
 	virtual void SetOn(bool b);
 
-private slots:
-	void onUpdate();
-
 protected:
 	enum EnumFadeState
 	{
@@ -77,8 +75,8 @@ protected:
 		FADE_OUT
 	};
 
-	QTimer			*m_ActivityTimer;
-	EosTimer		m_ActivityEosTimer;
+	bool			m_ActivityAnimating;
+	ClockTimer		m_ActivityTimer;
 	sFadeTiming		m_FadeTiming;
 	EnumFadeState	m_FadeState;
 	unsigned int	m_FadeElapsed;
@@ -86,6 +84,8 @@ protected:
 	virtual float GetFadeOpacity() const;
 	virtual float GetFadePercent() const;
 	virtual void StartActivityTimer();
+	virtual void UpdateActivity();
+	virtual bool AnimationClient_Tick();
 	virtual void paintEvent(QPaintEvent *event);
 };
 
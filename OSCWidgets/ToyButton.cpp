@@ -25,18 +25,23 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ToyButtonWidget::ToyButtonWidget(QWidget *parent)
-	: ToyWidget(parent)
+ToyButtonWidget::ToyButtonWidget(QWidget *parent, CellClient *pCellClient/* =0 */)
+	: ToyWidget(parent, pCellClient)
 	, m_Toggle(false)
+	, m_CellDown(false)
 {
 	m_HelpText = tr("Min = Button Up\nMax = Button Down\n\nLeave Min or Max blank to send single edge\n\nLeave both blank to send without arguments\n\nToggle:\nSpecify Min2 and/or Max2 for toggle behavior\n\nOSC Trigger:\nNo Arguments = Click\nArgument(1) = Press\nArgument(0) = Release");
 	m_Min2 = m_Max2 = QString();
 
-	m_Widget = new FadeButton(this);
-	connect(m_Widget, SIGNAL(pressed()), this, SLOT(onPressed()));
-	connect(m_Widget, SIGNAL(released()), this, SLOT(onReleased()));
+	QPalette pal( palette() );
+	if( !IsCell() )
+	{
+		m_Widget = new FadeButton(this);
+		connect(m_Widget, SIGNAL(pressed()), this, SLOT(onPressed()));
+		connect(m_Widget, SIGNAL(released()), this, SLOT(onReleased()));
+		pal = m_Widget->palette();
+	}
 	
-	QPalette pal( m_Widget->palette() );
 	m_Color = pal.color(QPalette::Button);
 	m_TextColor = pal.color(QPalette::ButtonText);
 	m_Color2 = m_TextColor;
@@ -50,7 +55,10 @@ ToyButtonWidget::ToyButtonWidget(QWidget *parent)
 void ToyButtonWidget::SetText(const QString &text)
 {
 	ToyWidget::SetText(text);
-	static_cast<FadeButton*>(m_Widget)->setText(m_Text);
+	if( m_Widget )
+		static_cast<FadeButton*>(m_Widget)->setText(m_Text);
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -58,7 +66,10 @@ void ToyButtonWidget::SetText(const QString &text)
 void ToyButtonWidget::SetImagePath(const QString &imagePath)
 {
 	ToyWidget::SetImagePath(imagePath);
-	static_cast<FadeButton*>(m_Widget)->SetImagePath(0, m_ImagePath);
+	if( m_Widget )
+		static_cast<FadeButton*>(m_Widget)->SetImagePath(0, m_ImagePath);
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -66,7 +77,10 @@ void ToyButtonWidget::SetImagePath(const QString &imagePath)
 void ToyButtonWidget::SetImagePath2(const QString &imagePath2)
 {
 	ToyWidget::SetImagePath2(imagePath2);
-	static_cast<FadeButton*>(m_Widget)->SetImagePath(1, m_ImagePath2);
+	if( m_Widget )
+		static_cast<FadeButton*>(m_Widget)->SetImagePath(1, m_ImagePath2);
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -105,7 +119,15 @@ void ToyButtonWidget::SetTextColor2(const QColor &textColor2)
 
 void ToyButtonWidget::SetLabel(const QString &label)
 {
-	static_cast<FadeButton*>(m_Widget)->SetLabel(label);
+	if( m_Widget )
+	{
+		static_cast<FadeButton*>(m_Widget)->SetLabel(label);
+	}
+	else if(m_CellLabel != label)
+	{
+		m_CellLabel = label;
+		CellChanged();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -123,6 +145,12 @@ void ToyButtonWidget::SetToggle(bool b)
 
 void ToyButtonWidget::UpdateToggleState()
 {
+	if( !m_Widget )
+	{
+		CellChanged();
+		return;
+	}
+
 	FadeButton *button = static_cast<FadeButton*>(m_Widget);
 	
 	bool toggled = (HasToggle() && m_Toggle);
@@ -139,8 +167,6 @@ void ToyButtonWidget::UpdateToggleState()
 
 void ToyButtonWidget::Recv(const QString &path, const OSCArgument *args, size_t count)
 {
-	FadeButton *button = static_cast<FadeButton*>(m_Widget);
-
 	bool isFeedback = (path == m_FeedbackPath);
 	bool isTrigger = (!isFeedback && path==m_TriggerPath);
 	if(isFeedback || isTrigger)
@@ -153,14 +179,14 @@ void ToyButtonWidget::Recv(const QString &path, const OSCArgument *args, size_t
 			if( gotAction )
 			{
 				if( press )
-					button->Press();
+					Press(/*user*/true);
 				else
-					button->Release();
+					Release(/*user*/true);
 			}
 			else
 			{
-				button->Press();
-				button->Release();
+				Press(/*user*/true);
+				Release(/*user*/true);
 			}
 		}
 		else if( HasToggle() )
@@ -173,14 +199,14 @@ void ToyButtonWidget::Recv(const QString &path, const OSCArgument *args, size_t
 		else if( gotAction )
 		{
 			if( press )
-				button->Press(/*user*/false);
+				Press(/*user*/false);
 			else
-				button->Release(/*user*/false);
+				Release(/*user*/false);
 		}
 		else
 		{
-			button->Press(/*user*/false);
-			button->Release(/*user*/false);
+			Press(/*user*/false);
+			Release(/*user*/false);
 		}
     }
     else
@@ -237,6 +263,68 @@ bool ToyButtonWidget::GetActionFromOSCArguments(const OSCArgument *args, size_t
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyButtonWidget::Press(bool user)
+{
+	if( m_Widget )
+	{
+		static_cast<FadeButton*>(m_Widget)->Press(user);
+	}
+	else if( !m_CellDown )
+	{
+		m_CellDown = true;
+		CellChanged();
+		if( user )
+			onPressed();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyButtonWidget::Release(bool user)
+{
+	if( m_Widget )
+	{
+		static_cast<FadeButton*>(m_Widget)->Release(user);
+	}
+	else if( m_CellDown )
+	{
+		m_CellDown = false;
+		CellChanged();
+		if( user )
+			onReleased();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyButtonWidget::GetCellState(sCellState &state) const
+{
+	bool toggled = (HasToggle() && m_Toggle);
+	state.text = m_Text;
+	state.label = m_CellLabel;
+	state.imagePath = (toggled ? m_ImagePath2 : m_ImagePath);
+	state.color = (toggled ? m_Color2 : m_Color);
+	state.borderColor = QColor();
+	state.textColor = (toggled ? m_TextColor2 : m_TextColor);
+	state.down = m_CellDown;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyButtonWidget::CellPressed()
+{
+	Press(/*user*/true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyButtonWidget::CellReleased()
+{
+	Release(/*user*/true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyButtonWidget::onPressed()
 {
 	emit pressed(this);
@@ -263,7 +351,7 @@ ToyButtonGrid::ToyButtonGrid(Client *pClient, QWidget *parent, Qt::WindowFlags f
 
 ToyWidget* ToyButtonGrid::CreateWidget()
 {
-	ToyButtonWidget *w = new ToyButtonWidget(this);
+	ToyButtonWidget *w = new ToyButtonWidget(this, GetCellClient());
 	connect(w, SIGNAL(pressed(ToyButtonWidget*)), this, SLOT(onPressed(ToyButtonWidget*)));
 	connect(w, SIGNAL(released(ToyButtonWidget*)), this, SLOT(onReleased(ToyButtonWidget*)));
 	return w;
@@ -38,7 +38,7 @@ class ToyButtonWidget
 	Q_OBJECT
 	
 public:
-	ToyButtonWidget(QWidget *parent);
+	ToyButtonWidget(QWidget *parent, CellClient *pCellClient=0);
 	
 	virtual void SetText(const QString &text);
 	virtual void SetImagePath(const QString &imagePath);
@@ -61,6 +61,9 @@ public:
 	virtual bool HasMin2OrMax2() const {return (!m_Min2.isEmpty() || !m_Max2.isEmpty());}
 	virtual bool HasToggle() const {return (HasMinOrMax() && HasMin2OrMax2());}
 	virtual bool GetActionFromOSCArguments(const OSCArgument *args, size_t count, bool &toggle, bool &press) const;
+	virtual void GetCellState(sCellState &state) const;
+	virtual void CellPressed();
+	virtual void CellReleased();
 	
 signals:
 	void pressed(ToyButtonWidget*);
@@ -72,8 +75,12 @@ private slots:
 
 protected:
 	bool	m_Toggle;
+	QString	m_CellLabel;
+	bool	m_CellDown;
 	
 	virtual void UpdateToggleState();
+	virtual void Press(bool user);
+	virtual void Release(bool user);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -87,6 +94,7 @@ public:
 	ToyButtonGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags);
 	
 	virtual void GetDefaultGridSize(QSize &gridSize) const {gridSize = QSize(5,1);}
+	virtual bool HasCellMode() const {return true;}
 	
 private slots:
 	void onPressed(ToyButtonWidget*);
@@ -0,0 +1,447 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "ToyCellView.h"
+#include "FadeButton.h"
+#include "Utils.h"
+#include "Trace.h"
+#include "Toy.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+ToyCellView::ToyCellView(QWidget *parent)
+	: QWidget(parent)
+	, m_Mode(ToyWidget::MODE_DEFAULT)
+	, m_PressedIndex(0)
+	, m_LayoutWidth(0)
+{
+	Utils::RegisterTouchWidget(*this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ToyCellView::~ToyCellView()
+{
+	ANIM.Stop(this);
+	PMC.RemoveClient(this);
+	ReleasePixmaps();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::SetWidgets(const WIDGET_LIST &widgets, const QSize &gridSize)
+{
+	ANIM.Stop(this);
+	m_Clicks.clear();
+	m_Indices.clear();
+	m_GridSize = gridSize;
+	ReleasePixmaps();
+	
+	m_Cells.resize( widgets.size() );
+	for(size_t i=0; i<m_Cells.size(); i++)
+	{
+		sCell &cell = m_Cells[i];
+		cell = sCell();
+		cell.widget = widgets[i];
+		m_Indices[cell.widget] = i;
+		UpdateCell(i);
+	}
+	
+	m_PressedIndex = m_Cells.size();
+	m_CellSize = QSize();
+	UpdateCellSize();
+	update();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::SetMode(ToyWidget::EnumMode mode)
+{
+	if(m_Mode != mode)
+	{
+		m_Mode = mode;
+		m_PressedIndex = m_Cells.size();
+		update();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t ToyCellView::CellIndexAt(const QPoint &pos) const
+{
+	if(m_CellSize.isEmpty() || pos.x()<0 || pos.y()<0)
+		return m_Cells.size();
+
+	int col = (pos.x() / m_CellSize.width());
+	int row = (pos.y() / m_CellSize.height());
+	if(col>=m_GridSize.width() || row>=m_GridSize.height())
+		return m_Cells.size();
+
+	size_t index = static_cast<size_t>(row*m_GridSize.width() + col);
+	return ((index<m_Cells.size()) ? index : m_Cells.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QRect ToyCellView::GetCellRect(size_t index) const
+{
+	if(m_GridSize.width() <= 0)
+		return QRect();
+
+	int col = static_cast<int>(index % m_GridSize.width());
+	int row = static_cast<int>(index / m_GridSize.width());
+	return QRect(col*m_CellSize.width(), row*m_CellSize.height(), m_CellSize.width(), m_CellSize.height());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::CellClient_Changed(ToyWidget *widget)
+{
+	CELL_INDICES::const_iterator i = m_Indices.find(widget);
+	if(i != m_Indices.end())
+	{
+		UpdateCell(i->second);
+		m_PaintProbe.Invalidated();
+		update( GetCellRect(i->second) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::UpdateCell(size_t index)
+{
+	sCell &cell = m_Cells[index];
+	bool wasDown = cell.state.down;
+	cell.widget->GetCellState(cell.state);
+	cell.visible = cell.widget->GetVisible();
+	cell.selected = cell.widget->GetSelected();
+	
+	if( cell.state.down )
+	{
+		cell.click = 1;
+	}
+	else if( wasDown )
+	{
+		// fade out from the release, same as FadeButton
+		cell.click = 1;
+		cell.clickTimestamp.Start();
+		if(std::find(m_Clicks.begin(),m_Clicks.end(),index) == m_Clicks.end())
+			m_Clicks.push_back(index);
+		ANIM.Start(this);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::UpdateCellSize()
+{
+	QSize cellSize;
+	if(m_GridSize.width()>0 && m_GridSize.height()>0)
+		cellSize = QSize(width()/m_GridSize.width(), height()/m_GridSize.height());
+	
+	if(m_CellSize != cellSize)
+	{
+		m_CellSize = cellSize;
+
+		// match FadeButton::AutoSizeFont for a button filling the cell
+		QFont fnt( font() );
+		int d = qMin(m_CellSize.width()-MARGIN2, m_CellSize.height()-MARGIN2);
+		fnt.setPixelSize( qMax(14,qRound(d*0.2)) );
+		setFont(fnt);
+
+		m_LayoutWidth = (m_CellSize.width() - MARGIN2 - 2);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::ReleasePixmaps()
+{
+	for(CELLS::iterator i=m_Cells.begin(); i!=m_Cells.end(); i++)
+	{
+		PMC.DestroyScaled(i->pixmapPath, i->pixmapSize, PixmapCache::SCALE_TO_FILL);
+		i->pixmapPath.clear();
+		i->pixmapSize = QSize();
+		i->pixmap = QPixmap();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::RenderCell(QPainter &painter, sCell &cell, const QRect &cellRect)
+{
+	QSize buttonSize(cellRect.width()-MARGIN2, cellRect.height()-MARGIN2);
+	QRectF r( cellRect.adjusted(MARGIN,MARGIN,-MARGIN,-MARGIN) );
+	r.adjust(1, 1, -1, -1);
+	
+	QColor color( cell.state.color );
+	if(cell.click > 0)
+	{
+		qreal t = (cell.click * BUTTON_BRIGHTESS);
+		color.setRedF( qMin(color.redF()+t,1.0) );
+		color.setGreenF( qMin(color.greenF()+t,1.0) );
+		color.setBlueF( qMin(color.blueF()+t,1.0) );
+	}
+	
+	if(cell.state.borderColor.isValid() && cell.state.borderColor.alpha()>0)
+		painter.setPen( QPen(cell.state.borderColor,2) );
+	else
+		painter.setPen(Qt::NoPen);
+	painter.setBrush(color);
+	painter.drawRoundedRect(r, ROUNDED, ROUNDED);
+	
+	if(cell.pixmapPath!=cell.state.imagePath || cell.pixmapSize!=buttonSize)
+	{
+		PMC.DestroyScaled(cell.pixmapPath, cell.pixmapSize, PixmapCache::SCALE_TO_FILL);
+		cell.pixmapPath = cell.state.imagePath;
+		cell.pixmapSize = buttonSize;
+		PMC.CreateScaled(cell.pixmapPath, cell.pixmapSize, PixmapCache::SCALE_TO_FILL, cell.pixmap, this);
+	}
+	
+	if( !cell.pixmap.isNull() )
+	{
+		painter.setOpacity(1.0-(cell.click*0.5));
+		painter.drawPixmap(	r.x() + qRound((r.width()-cell.pixmap.width())*0.5),
+							r.y() + qRound((r.height()-cell.pixmap.height())*0.5),
+							cell.pixmap );
+		painter.setOpacity(1.0);
+	}
+	
+	if(!cell.state.text.isEmpty() || !cell.state.label.isEmpty())
+	{
+		if(cell.text.textWidth()!=m_LayoutWidth || cell.text.text()!=cell.state.text)
+			FadeButton::PrepareStaticText(cell.text, cell.state.text, font(), m_LayoutWidth);
+		if(cell.label.textWidth()!=m_LayoutWidth || cell.label.text()!=cell.state.label)
+			FadeButton::PrepareStaticText(cell.label, cell.state.label, font(), m_LayoutWidth);
+		
+		painter.setPen(cell.state.textColor);
+		FadeButton::DrawStaticTextAndLabel(painter, r, cell.text, cell.label);
+	}
+	
+	if( cell.selected )
+	{
+		QColor selColor(0, 60, 200, 200);
+		painter.fillRect(QRect(cellRect.x(),cellRect.y(),cellRect.width(),MARGIN), selColor);
+		painter.fillRect(QRect(cellRect.x(),cellRect.y()+MARGIN,MARGIN,cellRect.height()-MARGIN2), selColor);
+		painter.fillRect(QRect(cellRect.right()+1-MARGIN,cellRect.y()+MARGIN,MARGIN,cellRect.height()-MARGIN2), selColor);
+		painter.fillRect(QRect(cellRect.x(),cellRect.bottom()+1-MARGIN,cellRect.width(),MARGIN), selColor);
+		selColor.setAlpha( qRound(selColor.alpha()*0.4) );
+		painter.fillRect(cellRect, selColor);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyCellView::AnimationClient_Tick()
+{
+	size_t count = 0;
+	for(size_t i=0; i<m_Clicks.size(); i++)
+	{
+		size_t index = m_Clicks[i];
+		if(index >= m_Cells.size())
+			continue;
+
+		sCell &cell = m_Cells[index];
+		if( cell.state.down )
+			continue;	// pressed again, fade restarts on release
+
+		float t = (1.0f - cell.clickTimestamp.GetElapsed()/static_cast<float>(BUTTON_CLICK_MS));
+		if(t <= 0)
+			t = 0;
+		else
+			m_Clicks[count++] = index;
+
+		if(cell.click != t)
+		{
+			cell.click = t;
+			update( GetCellRect(index) );
+		}
+	}
+
+	m_Clicks.resize(count);
+	return !m_Clicks.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::PixmapCacheClient_Loaded(const QString &path)
+{
+	for(size_t i=0; i<m_Cells.size(); i++)
+	{
+		sCell &cell = m_Cells[i];
+		if(cell.pixmapPath == path)
+		{
+			PMC.GetScaled(cell.pixmapPath, cell.pixmapSize, PixmapCache::SCALE_TO_FILL, cell.pixmap);
+			update( GetCellRect(i) );
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::resizeEvent(QResizeEvent *event)
+{
+	UpdateCellSize();
+	QWidget::resizeEvent(event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::paintEvent(QPaintEvent *event)
+{
+	TRACE_ZONE("ToyCellView::paintEvent");
+
+	if(m_CellSize.isEmpty() || m_Cells.empty())
+		return;
+
+	QPainter painter(this);
+	painter.setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
+
+	// only visit the cells overlapping the dirty rect
+	const QRect &dirty = event->rect();
+	int firstCol = qMax(0, dirty.left()/m_CellSize.width());
+	int lastCol = qMin(m_GridSize.width()-1, dirty.right()/m_CellSize.width());
+	int firstRow = qMax(0, dirty.top()/m_CellSize.height());
+	int lastRow = qMin(m_GridSize.height()-1, dirty.bottom()/m_CellSize.height());
+	
+	for(int row=firstRow; row<=lastRow; row++)
+	{
+		for(int col=firstCol; col<=lastCol; col++)
+		{
+			size_t index = static_cast<size_t>(row*m_GridSize.width() + col);
+			if(index >= m_Cells.size())
+				break;
+
+			sCell &cell = m_Cells[index];
+			if(cell.visible || m_Mode==ToyWidget::MODE_EDIT)
+				RenderCell(painter, cell, GetCellRect(index));
+		}
+	}
+
+	m_PaintProbe.Painted();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::mousePressEvent(QMouseEvent *event)
+{
+	Metrics::InputScope inputScope( Toy::GetLatencySource(this) );
+
+	if(event->button() == Qt::LeftButton)
+	{
+		m_PressedIndex = CellIndexAt( event->pos() );
+		if(m_PressedIndex<m_Cells.size() && m_Mode==ToyWidget::MODE_DEFAULT)
+		{
+			if( m_Cells[m_PressedIndex].visible )
+				m_Cells[m_PressedIndex].widget->CellPressed();
+		}
+		event->accept();
+	}
+	else
+		QWidget::mousePressEvent(event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyCellView::mouseReleaseEvent(QMouseEvent *event)
+{
+	Metrics::InputScope inputScope( Toy::GetLatencySource(this) );
+
+	if(event->button() == Qt::LeftButton)
+	{
+		size_t index = m_PressedIndex;
+		m_PressedIndex = m_Cells.size();
+		if(index < m_Cells.size())
+		{
+			ToyWidget *widget = m_Cells[index].widget;
+			if(m_Mode == ToyWidget::MODE_EDIT)
+			{
+				if(CellIndexAt(event->pos()) == index)
+					widget->CellEditClicked();
+			}
+			else if( m_Cells[index].visible )
+				widget->CellReleased();
+		}
+		event->accept();
+	}
+	else
+		QWidget::mouseReleaseEvent(event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyCellView::event(QEvent *event)
+{
+	if(event->type() == QEvent::ToolTip)
+	{
+		QHelpEvent *helpEvent = static_cast<QHelpEvent*>(event);
+		size_t index = CellIndexAt( helpEvent->pos() );
+		QString tip;
+		if(index < m_Cells.size())
+			tip = m_Cells[index].widget->toolTip();
+		if( tip.isEmpty() )
+		{
+			QToolTip::hideText();
+			event->ignore();
+		}
+		else
+			QToolTip::showText(helpEvent->globalPos(), tip, this, GetCellRect(index));
+		return true;
+	}
+
+	switch( event->type() )
+	{
+		case QEvent::TouchBegin:
+			{
+				QTouchEvent *touchEvent = static_cast<QTouchEvent*>(event);
+				if( !touchEvent->touchPoints().empty() )
+				{
+					const QTouchEvent::TouchPoint &touchPoint = touchEvent->touchPoints().front();
+					QMouseEvent me(QEvent::MouseButtonPress, touchPoint.pos().toPoint(), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+					mousePressEvent(&me);
+				}
+
+				event->accept();
+			}
+			return true;
+
+		case QEvent::TouchUpdate:
+			event->accept();
+			return true;
+
+		case QEvent::TouchEnd:
+			{
+				QTouchEvent *touchEvent = static_cast<QTouchEvent*>(event);
+				if( !touchEvent->touchPoints().empty() )
+				{
+					const QTouchEvent::TouchPoint &touchPoint = touchEvent->touchPoints().front();
+					QMouseEvent me(QEvent::MouseButtonRelease, touchPoint.pos().toPoint(), Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+					mouseReleaseEvent(&me);
+				}
+
+				event->accept();
+			}
+			return true;
+	}
+
+	return QWidget::event(event);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,124 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef TOY_CELL_VIEW_H
+#define TOY_CELL_VIEW_H
+
+#ifndef TOY_WIDGET_H
+#include "ToyWidget.h"
+#endif
+
+#ifndef ANIMATION_DRIVER_H
+#include "AnimationDriver.h"
+#endif
+
+#ifndef CLOCK_H
+#include "Clock.h"
+#endif
+
+#ifndef UTILS_H
+#include "Utils.h"
+#endif
+
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// draws and hit-tests every cell of a large grid from one widget, the cells
+// themselves stay ToyWidgets for settings, save/load and osc, but own no
+// child widgets and are never shown
+class ToyCellView
+	: public QWidget
+	, public ToyWidget::CellClient
+	, private AnimationDriver::Client
+	, private PixmapCache::Client
+{
+public:
+	typedef std::vector<ToyWidget*> WIDGET_LIST;
+
+	ToyCellView(QWidget *parent);
+	virtual ~ToyCellView();
+
+	virtual void SetWidgets(const WIDGET_LIST &widgets, const QSize &gridSize);
+	virtual void SetMode(ToyWidget::EnumMode mode);
+	virtual size_t CellIndexAt(const QPoint &pos) const;
+	virtual QRect GetCellRect(size_t index) const;
+	virtual void CellClient_Changed(ToyWidget *widget);
+
+protected:
+	struct sCell
+	{
+		sCell()
+			: widget(0)
+			, visible(true)
+			, selected(false)
+			, click(0)
+		{}
+
+		ToyWidget				*widget;
+		ToyWidget::sCellState	state;
+		bool					visible;
+		bool					selected;
+		float					click;
+		ClockTimer				clickTimestamp;
+		QStaticText				text;
+		QStaticText				label;
+		QString					pixmapPath;
+		QSize					pixmapSize;
+		QPixmap					pixmap;
+	};
+
+	typedef std::vector<sCell> CELLS;
+	typedef std::map<const ToyWidget*,size_t> CELL_INDICES;
+	typedef std::vector<size_t> CELL_INDEX_LIST;
+
+	ToyWidget::EnumMode	m_Mode;
+	QSize				m_GridSize;
+	QSize				m_CellSize;
+	CELLS				m_Cells;
+	CELL_INDICES		m_Indices;
+	CELL_INDEX_LIST		m_Clicks;
+	size_t				m_PressedIndex;
+	qreal				m_LayoutWidth;
+	Metrics::PaintProbe	m_PaintProbe;
+
+	virtual void UpdateCell(size_t index);
+	virtual void UpdateCellSize();
+	virtual void ReleasePixmaps();
+	virtual void RenderCell(QPainter &painter, sCell &cell, const QRect &cellRect);
+	virtual bool AnimationClient_Tick();
+	virtual void PixmapCacheClient_Loaded(const QString &path);
+	virtual void resizeEvent(QResizeEvent *event);
+	virtual void paintEvent(QPaintEvent *event);
+	virtual void mousePressEvent(QMouseEvent *event);
+	virtual void mouseReleaseEvent(QMouseEvent *event);
+	virtual bool event(QEvent *event);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -21,6 +21,7 @@
 #include "ToyEncoder.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 #define ENCODER_SPAN	45
 
@@ -42,7 +43,7 @@ void FadeEncoder::SetText(const QString &text)
 	{
 		setText(text);
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -54,7 +55,7 @@ void FadeEncoder::SetLabel(const QString &label)
 	{
 		m_Label = label;
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -198,6 +199,8 @@ void FadeEncoder::mouseReleaseEvent(QMouseEvent *event)
 
 void FadeEncoder::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeEncoder::paintEvent");
+
 	m_Canvas.fill(0);
 
 	QPainter painter;
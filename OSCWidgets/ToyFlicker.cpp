@@ -21,6 +21,7 @@
 #include "ToyFlicker.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -35,6 +36,7 @@ FadeFlicker::FadeFlicker(QWidget *parent)
 	, m_MsPerBeat(0)
 	, m_Elapsed(0)
 	, m_Paused(true)
+	, m_Seed(0)
 {
 	connect(this, SIGNAL(clicked(bool)), this, SLOT(onClicked(bool)));
 	UpdateMsPerBeat();
@@ -48,7 +50,7 @@ void FadeFlicker::SetText(const QString &text)
 	{
 		setText(text);
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -60,7 +62,7 @@ void FadeFlicker::SetLabel(const QString &label)
 	{
 		m_Label = label;
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -129,7 +131,29 @@ void FadeFlicker::SetPaused(bool b)
 	{
 		m_Paused = b;
 		m_Elapsed = 0;
-		update();
+
+		// seeded flickers restart their sequence on play, so runs can be replayed exactly
+		if(!m_Paused && m_Seed!=0)
+		{
+			m_Random.Seed(m_Seed);
+			UpdateMsPerBeat();
+		}
+
+		emit activityChanged();
+
+		Invalidate();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeFlicker::SetSeed(uint64_t seed)
+{
+	if(m_Seed != seed)
+	{
+		m_Seed = seed;
+		m_Random.Seed((m_Seed==0) ? ToyRandom::GetEntropy() : m_Seed);
+		UpdateMsPerBeat();
 	}
 }
 
@@ -144,11 +168,11 @@ void FadeFlicker::Update(unsigned int ms)
 		while(m_MsPerBeat!=0 && m_Elapsed>=m_MsPerBeat)
 		{
 			m_Elapsed -= m_MsPerBeat;
-			m_Value = (rand() / static_cast<float>(RAND_MAX));
+			m_Value = m_Random.NextFloat();
 			emit valueChanged(m_Value);
 			if( HasTimeScale() )
 				UpdateMsPerBeat();
-			update();
+			Invalidate();
 		}
 	}
 }
@@ -184,7 +208,7 @@ void FadeFlicker::UpdateMsPerBeat()
 
 	if( HasTimeScale() )
 	{
-		float t = (rand() / static_cast<float>(RAND_MAX));
+		float t = m_Random.NextFloat();
 		timeScale = (m_MinTimeScale*t + m_MaxTimeScale*(1.0f-t));
 	}
 	
@@ -204,6 +228,8 @@ void FadeFlicker::resizeEvent(QResizeEvent *event)
 
 void FadeFlicker::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeFlicker::paintEvent");
+
 	QPainter painter(this);
 
 	painter.setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
@@ -296,6 +322,7 @@ void FadeFlicker::onClicked(bool /*checked*/)
 
 ToyFlickerWidget::ToyFlickerWidget(QWidget *parent)
 	: ToyWidget(parent)
+	, m_SeedIndex(0)
 {
 	m_HelpText = tr("Flicker between Min and Max\n\nRandomize Timing:\nMin2=Min Timing Scale\nMax2=Max Timing Scale\n\nOSC Trigger:\nNo Arguments = Play\nArgument(0) = Pause\nArgument(1) = Play");
 
@@ -311,6 +338,45 @@ ToyFlickerWidget::ToyFlickerWidget(QWidget *parent)
 	QPalette pal( m_Widget->palette() );
 	m_Color = pal.color(QPalette::Button);
 	m_TextColor = pal.color(QPalette::ButtonText);
+
+	UpdateSeed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyFlickerWidget::SetPath(const QString &path)
+{
+	ToyWidget::SetPath(path);
+	UpdateSeed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyFlickerWidget::SetSeedIndex(size_t index)
+{
+	m_SeedIndex = index;
+	UpdateSeed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyFlickerWidget::UpdateSeed()
+{
+	uint64_t seed = 0;
+
+	unsigned int showSeed = Toy::GetFlickerSeed();
+	if(showSeed != 0)
+	{
+		// derive from grid position and path, so each flicker has its own stable sequence
+		QByteArray path( m_Path.toUtf8() );
+		seed = ToyRandom::MixSeed(showSeed);
+		seed = ToyRandom::MixSeed(seed ^ static_cast<uint64_t>(m_SeedIndex));
+		seed = ToyRandom::MixSeed(seed ^ ToyRandom::HashBytes(path.constData(),static_cast<size_t>(path.size())));
+		if(seed == 0)
+			seed = 1;
+	}
+
+	static_cast<FadeFlicker*>(m_Widget)->SetSeed(seed);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -474,15 +540,29 @@ ToyWidget* ToyFlickerGrid::CreateWidget()
 {
 	ToyFlickerWidget *w = new ToyFlickerWidget(this);
 	connect(w, SIGNAL(valueChanged(ToyFlickerWidget*,float)), this, SLOT(onValueChanged(ToyFlickerWidget*,float)));
+	connect(&w->GetFlicker(), SIGNAL(activityChanged()), this, SLOT(onActivityChanged()));
 	return w;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyFlickerGrid::ApplyDefaultSettings(ToyWidget *widget, size_t index)
+{
+	ToyGrid::ApplyDefaultSettings(widget, index);
+	static_cast<ToyFlickerWidget*>(widget)->SetSeedIndex(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyFlickerGrid::StartTimer()
 {
-	m_ElapsedTimer.Start();
-	m_Timer->start( Toy::GetFlickerRefreshRateMS() );
+	// show seed may have changed
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+		static_cast<ToyFlickerWidget*>(*i)->UpdateSeed();
+
+	m_Timer->setInterval( Toy::GetFlickerRefreshRateMS() );
+	m_TickMetrics.Reset();
+	UpdateTimer();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -490,6 +570,42 @@ void ToyFlickerGrid::StartTimer()
 void ToyFlickerGrid::StopTimer()
 {
 	m_Timer->stop();
+	m_TickMetrics.Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyFlickerGrid::UpdateTimer()
+{
+	if( IsAnimating() )
+	{
+		if( !m_Timer->isActive() )
+		{
+			m_ElapsedTimer.Start();
+			m_TickMetrics.Reset();
+			m_Timer->start( Toy::GetFlickerRefreshRateMS() );
+		}
+	}
+	else
+		StopTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyFlickerGrid::IsAnimating() const
+{
+	// hidden flickers only need the timer if they send
+	bool visible = isVisible();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		ToyFlickerWidget *flicker = static_cast<ToyFlickerWidget*>(*i);
+		if( flicker->GetOutputFilter().HasPending() )
+			return true;
+		if(!flicker->GetFlicker().GetPaused() && (visible || !flicker->GetPath().isEmpty()))
+			return true;
+	}
+
+	return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -559,7 +675,7 @@ void ToyFlickerGrid::AutoSize(const QSize &widgetSize)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ToyFlickerGrid::onValueChanged(ToyFlickerWidget *flicker, float value)
+void ToyFlickerGrid::SendValue(ToyFlickerWidget *flicker, float value)
 {
 	if(	m_pClient &&
 		flicker &&
@@ -581,9 +697,6 @@ void ToyFlickerGrid::onValueChanged(ToyFlickerWidget *flicker, float value)
 		}
 		else
 		{
-			float minValue = flicker->GetMin().toFloat();
-			float maxValue = flicker->GetMax().toFloat();
-			value = (minValue + (maxValue-minValue)*value);
 			packetWriter.AddFloat32(value);
 		}
 
@@ -596,11 +709,58 @@ void ToyFlickerGrid::onValueChanged(ToyFlickerWidget *flicker, float value)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyFlickerGrid::onValueChanged(ToyFlickerWidget *flicker, float value)
+{
+	if( flicker )
+	{
+		// only a full range puts the value on the wire, so only then is it filtered,
+		// otherwise every beat is sent
+		if(!flicker->GetMin().isEmpty() && !flicker->GetMax().isEmpty())
+		{
+			float minValue = flicker->GetMin().toFloat();
+			float maxValue = flicker->GetMax().toFloat();
+			value = (minValue + (maxValue-minValue)*value);
+
+			OutputFilter &outputFilter = flicker->GetOutputFilter();
+			outputFilter.SetValue(value, Toy::GetSendEpsilon(), /*force*/false);
+
+			if( outputFilter.TakeValue(CLOCK.GetTimeNS(),GetSendRateMS(),value) )
+				SendValue(flicker, value);
+		}
+		else
+			SendValue(flicker, value);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyFlickerGrid::onTimeout()
+{
+	TRACE_ZONE("ToyFlickerGrid::onTimeout");
+
+	m_TickMetrics.Tick(Metrics::HISTOGRAM_GENERATOR_JITTER_US, m_Timer->interval());
+	Step();
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyFlickerGrid::Step()
 {
 	unsigned int ms = m_ElapsedTimer.Restart();
 	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
 		static_cast<ToyFlickerWidget*>(*i)->Update(ms);
+
+	// flush values held back by the send rate
+	qint64 nowNS = CLOCK.GetTimeNS();
+	unsigned int sendRateMS = GetSendRateMS();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		ToyFlickerWidget *flicker = static_cast<ToyFlickerWidget*>(*i);
+		float value;
+		if( flicker->GetOutputFilter().TakeValue(nowNS,sendRateMS,value) )
+			SendValue(flicker, value);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -26,6 +26,14 @@
 #include "ToyButton.h"
 #endif
 
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+#ifndef OUTPUT_FILTER_H
+#include "OutputFilter.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 class FadeFlicker
@@ -45,11 +53,14 @@ public:
 	virtual void SetBPM(float bpm);
 	virtual bool GetPaused() const {return m_Paused;}
 	virtual void SetPaused(bool b);
+	virtual uint64_t GetSeed() const {return m_Seed;}
+	virtual void SetSeed(uint64_t seed);
 	
 	static unsigned int GetMsPerBeat(float bpm, float timeScale);
 
 signals:
 	void valueChanged(float value);
+	void activityChanged();
 
 private slots:
 	void onClicked(bool checked);
@@ -65,6 +76,8 @@ protected:
 	unsigned int	m_Elapsed;
 	QRect			m_FlickerRect;
 	bool			m_Paused;
+	uint64_t		m_Seed;		// 0 = unseeded, sequence differs every run
+	ToyRandom		m_Random;
 
 	virtual void UpdateFlickerRect();
 	virtual void AutoSizeFont();
@@ -94,10 +107,14 @@ public:
 	virtual void SetMax2(const QString &n);
 	virtual void SetBPM(const QString &bpm);
 	virtual bool HasBPM() const {return true;}
+	virtual void SetPath(const QString &path);
 	virtual void SetLabel(const QString &label);
 	virtual void Recv(const QString &path, const OSCArgument *args, size_t count);
 	virtual void Update(unsigned int ms);
+	virtual void SetSeedIndex(size_t index);
+	virtual void UpdateSeed();
 	virtual FadeFlicker& GetFlicker() {return *static_cast<FadeFlicker*>(m_Widget);}
+	virtual OutputFilter& GetOutputFilter() {return m_OutputFilter;}
 	
 signals:
 	void valueChanged(ToyFlickerWidget*, float value);
@@ -106,6 +123,9 @@ private slots:
 	void onValueChanged(float value);
 
 protected:
+	OutputFilter	m_OutputFilter;
+	size_t			m_SeedIndex;	// position in the grid, keeps flickers with the same path apart
+
 	virtual void UpdateTimeScaleRange();
 };
 
@@ -119,8 +139,11 @@ class ToyFlickerGrid
 public:
 	ToyFlickerGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags);	
 
+	virtual bool HasSendRate() const {return true;}
 	virtual void StartTimer();
 	virtual void StopTimer();
+	virtual void UpdateTimer();
+	virtual void Step();
 	
 private slots:
 	void onValueChanged(ToyFlickerWidget*, float value);
@@ -130,14 +153,19 @@ private slots:
 	
 protected:
 	QTimer		*m_Timer;
-	EosTimer	m_ElapsedTimer;
+	Metrics::TickTimer	m_TickMetrics;
+	ClockTimer	m_ElapsedTimer;
 	FadeButton	*m_Play;
 	FadeButton	*m_Pause;
 
 	virtual ToyWidget* CreateWidget();
+	virtual unsigned int GetDefaultSendRateMS() const {return Toy::GetFlickerSendRateMS();}
+	virtual void ApplyDefaultSettings(ToyWidget *widget, size_t index);
 	virtual QSize GetDefaultWidgetSize() const {return QSize(80,120);}
 	virtual void UpdateLayout();
 	virtual void AutoSize(const QSize &widgetSize);
+	virtual bool IsAnimating() const;
+	virtual void SendValue(ToyFlickerWidget *flicker, float value);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -19,7 +19,9 @@
 // THE SOFTWARE.
 
 #include "ToyGrid.h"
+#include "ToyCellView.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -145,6 +147,7 @@ ToyGrid::ToyGrid(EnumToyType type, Client *pClient, QWidget *parent, Qt::WindowF
 	, m_IgnoreEdits(0)
 	, m_pContextMenu(0)
 	, m_Loading(false)
+	, m_CellView(0)
 	, m_EditPanel(0)
 {
 	QString name;
@@ -186,6 +189,9 @@ void ToyGrid::UpdateMode()
 {
 	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
 		(*i)->SetMode(m_Mode);
+
+	if( m_CellView )
+		m_CellView->SetMode(m_Mode);
 	
 	switch( m_Mode )
 	{
@@ -240,29 +246,27 @@ void ToyGrid::SetGridSize(const QSize &gridSize)
 			m_List.back()->deleteLater();
 			m_List.pop_back();
 		}
+
+		SetCellMode( ShouldUseCellMode(numWidgets) );
 		
 		// add new
 		while(m_List.size() < numWidgets)
 		{
-			ToyWidget *widget = CreateWidget();
-			if( widget )
-			{
-				m_List.push_back(widget);
-				ApplyDefaultSettings(widget, m_List.size());
-				widget->SetMode(m_Mode);
-				
-				if( !m_Loading )
-					widget->show();
-				
-				connect(widget, SIGNAL(edit(ToyWidget*)), this, SLOT(onWidgetEdited(ToyWidget*)));
-			}
-			else
+			if( !AddWidget() )
 				break;
 		}
 
+		if( m_CellView )
+			m_CellView->SetWidgets(m_List, m_GridSize);
+
+		m_PropertyPool.Prune();
+
 		setMinimumSize(m_GridSize.width()*24, m_GridSize.height()*24);
 		
 		m_EditWidgetIndex = m_List.size();
+
+		// new widgets may send while hidden, removed ones may have been the last that did
+		UpdateTimer();
 		
 		if( !m_Loading )
 		{
@@ -277,6 +281,102 @@ void ToyGrid::SetGridSize(const QSize &gridSize)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+ToyWidget::CellClient* ToyGrid::GetCellClient() const
+{
+	return m_CellView;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyGrid::AddWidget()
+{
+	ToyWidget *widget = CreateWidget();
+	if( !widget )
+		return false;
+
+	m_List.push_back(widget);
+	ApplyDefaultSettings(widget, m_List.size());
+	widget->ShareProperties(m_PropertyPool);
+	widget->SetMode(m_Mode);
+	
+	if(!m_Loading && !m_CellView)
+		widget->show();
+	
+	connect(widget, SIGNAL(edit(ToyWidget*)), this, SLOT(onWidgetEdited(ToyWidget*)));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyGrid::ShouldUseCellMode(size_t numWidgets) const
+{
+	// large grids are drawn by a single view
+	size_t threshold = static_cast<size_t>( Toy::GetCellGridThreshold() );
+	return (HasCellMode() && threshold!=0 && numWidgets>=threshold);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyGrid::UpdateCellMode()
+{
+	bool b = ShouldUseCellMode( m_List.size() );
+	if(b != GetCellMode())
+	{
+		SetCellMode(b);
+		if( m_CellView )
+			m_CellView->SetWidgets(m_List, m_GridSize);
+		m_EditWidgetIndex = m_List.size();
+		UpdateLayout();
+		emit recvWidgetsChanged();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyGrid::SetCellMode(bool b)
+{
+	if(b == GetCellMode())
+		return;
+
+	// round trip the existing widgets through their save format
+	EosLog log;
+	QString path;
+	QStringList lines;
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+		(*i)->Save(log, path, lines);
+
+	size_t numWidgets = m_List.size();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		(*i)->hide();
+		(*i)->deleteLater();
+	}
+	m_List.clear();
+
+	if( b )
+	{
+		m_CellView = new ToyCellView(this);
+		m_CellView->SetMode(m_Mode);
+		m_CellView->show();
+	}
+	else
+	{
+		delete m_CellView;
+		m_CellView = 0;
+	}
+
+	int index = 0;
+	while(m_List.size() < numWidgets)
+	{
+		if( !AddWidget() )
+			break;
+		m_List.back()->Load(log, path, lines, index);
+		m_List.back()->ShareProperties(m_PropertyPool);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyGrid::AutoSize(const QSize &widgetSize)
 {
 	resize(	contentsMargins().left() + m_GridSize.width()*widgetSize.width() + contentsMargins().right(),
@@ -396,7 +496,11 @@ void ToyGrid::UpdateLayout()
 
 void ToyGrid::UpdateLayoutForRect(const QRect &r)
 {
-	if( !m_GridSize.isEmpty() )
+	if( m_CellView )
+	{
+		m_CellView->setGeometry( r.adjusted(contentsMargins().left(),contentsMargins().top(),-contentsMargins().right(),-contentsMargins().bottom()) );
+	}
+	else if( !m_GridSize.isEmpty() )
 	{
 		int w = (r.width() - contentsMargins().left() - contentsMargins().right())/m_GridSize.width();
 		int h = (r.height() - contentsMargins().top() - contentsMargins().bottom())/m_GridSize.height();
@@ -532,6 +636,8 @@ void ToyGrid::EditWidget(ToyWidget *widget, bool toggle)
 			m_EditPanel->SetBPM( QString() );
 			m_EditPanel->SetBPMEnabled(false);
 		}
+		m_EditPanel->SetSendRate( QString() );
+		m_EditPanel->SetSendRateEnabled(false);
 		if( widget->HasVisible() )
 		{
 			m_EditPanel->SetHidden( !widget->GetVisible() );
@@ -585,6 +691,8 @@ void ToyGrid::EditWidget(ToyWidget *widget, bool toggle)
 		m_EditPanel->SetMinMax2Enabled(false);
 		m_EditPanel->SetBPM( QString() );
 		m_EditPanel->SetBPMEnabled(false);
+		m_EditPanel->SetSendRate(m_SendRate);
+		m_EditPanel->SetSendRateEnabled( HasSendRate() );
 		m_EditPanel->SetColor(m_Color);
 		if( HasColor2() )
 		{
@@ -625,6 +733,12 @@ const ToyWidget* ToyGrid::ToyWidgetAt(const QPoint &pos) const
 
 size_t ToyGrid::ToyWidgetIndexAt(const QPoint &pos) const
 {
+	if( m_CellView )
+	{
+		size_t index = m_CellView->CellIndexAt( m_CellView->mapFromParent(pos) );
+		return ((index<m_List.size()) ? index : m_List.size());
+	}
+
 	for(size_t i=0; i<m_List.size(); i++)
 	{
 		if( m_List[i]->geometry().contains(pos) )
@@ -652,6 +766,16 @@ void ToyGrid::AddRecvWidgets(RECV_WIDGETS &recvWidgets) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+unsigned int ToyGrid::GetSendRateMS() const
+{
+	if( m_SendRate.isEmpty() )
+		return GetDefaultSendRateMS();
+
+	return qMin(m_SendRate.toUInt(), static_cast<unsigned int>(60000));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool ToyGrid::Save(EosLog &log, const QString &path, QStringList &lines)
 {
 	QRect r(frameGeometry().topLeft(), size());
@@ -674,6 +798,7 @@ bool ToyGrid::Save(EosLog &log, const QString &path, QStringList &lines)
 	line.append( QString(", %1").arg(Utils::QuotedString(imagePath)) );
 	line.append( QString(", %1").arg(m_Color.rgba(),0,16) );
 	line.append( QString(", %1").arg(static_cast<int>(m_SendOnConnect ? 1 : 0)) );
+	line.append( QString(", %1").arg(Utils::QuotedString(m_SendRate)) );
 
 	lines << line;
 
@@ -687,6 +812,8 @@ bool ToyGrid::Save(EosLog &log, const QString &path, QStringList &lines)
 
 bool ToyGrid::Load(EosLog &log, const QString &path, QStringList &lines, int &index)
 {
+	TRACE_ZONE("ToyGrid::Load");
+
 	if(index>=0 && index<lines.size())
 	{
 		m_Loading = true;
@@ -717,14 +844,22 @@ bool ToyGrid::Load(EosLog &log, const QString &path, QStringList &lines, int &in
 			
 			if(items.size() > 12)
 				SetSendOnConnect(items[12].toInt() != 0);
+
+			if(items.size() > 13)
+				SetSendRate( items[13] );
 			
 			int numToyWidgets = (gridSize.width() * gridSize.height());
 			for(int i=0; i<numToyWidgets && index<lines.size(); i++)
 			{
 				size_t widgetIndex = static_cast<size_t>(i);
 				if(widgetIndex < m_List.size())
+				{
 					m_List[widgetIndex]->Load(log, path, lines, index);
+					m_List[widgetIndex]->ShareProperties(m_PropertyPool);
+				}
 			}
+
+			m_PropertyPool.Prune();
 			
 			if(parentWidget() == 0)
 			{
@@ -762,6 +897,7 @@ bool ToyGrid::Load(EosLog &log, const QString &path, QStringList &lines, int &in
 		m_Loading = false;
 		
 		UpdateLayout();
+		UpdateTimer();
 		
 		emit recvWidgetsChanged();
 	}
@@ -771,6 +907,16 @@ bool ToyGrid::Load(EosLog &log, const QString &path, QStringList &lines, int &in
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyGrid::AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const
+{
+	Toy::AddMemoryUsage(usage);
+
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+		(*i)->AddMemoryUsage(usage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyGrid::ClearLabels()
 {
 	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
@@ -975,6 +1121,30 @@ void ToyGrid::closeEvent(QCloseEvent *event)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyGrid::showEvent(QShowEvent *event)
+{
+	Toy::showEvent(event);
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyGrid::hideEvent(QHideEvent *event)
+{
+	Toy::hideEvent(event);
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyGrid::onActivityChanged()
+{
+	// timers run only while something animates, see UpdateTimer
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyGrid::onEdit()
 {
 	m_EditWidgetIndex = m_List.size();
@@ -1154,6 +1324,12 @@ void ToyGrid::onWidgetEdited(ToyWidget *widget)
 
 		m_EditPanel->GetImagePath(str);
 		SetImagePath(str);
+
+		if( HasSendRate() )
+		{
+			m_EditPanel->GetSendRate(str);
+			SetSendRate(str);
+		}
 		
 		QColor color;
 		m_EditPanel->GetColor(color);
@@ -1172,6 +1348,9 @@ void ToyGrid::onWidgetEdited(ToyWidget *widget)
 		}
 	}
 
+	// a new path or visibility can start or stop the timer of a hidden grid
+	UpdateTimer();
+
 	emit changed();
  }
 
@@ -40,6 +40,10 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class ToyCellView;
+
+////////////////////////////////////////////////////////////////////////////////
+
 #define QUICK_GRID_BUTTON_SIZE	24
 #define QUICK_GRID_WIDTH		10
 #define QUICK_GRID_HEIGHT		10
@@ -114,7 +118,10 @@ public:
 	virtual ToyWidget::EnumMode GetMode() const {return m_Mode;}
 	virtual void SetMode(ToyWidget::EnumMode mode);
 	virtual const QSize& GetGridSize() const {return m_GridSize;}
+	virtual const WIDGET_LIST& GetWidgets() const {return m_List;}
 	virtual void SetGridSize(const QSize &gridSize);
+	virtual bool HasCellMode() const {return false;}
+	virtual bool GetCellMode() const {return (m_CellView != 0);}
 	virtual const QString& GetText() const {return m_Text;}
 	virtual void SetText(const QString &text);
 	virtual const QString& GetImagePath() const {return m_ImagePath;}
@@ -129,6 +136,10 @@ public:
 	virtual void SetTextColor(const QColor &textColor);
 	virtual bool GetSendOnConnect() const {return m_SendOnConnect;}
 	virtual void SetSendOnConnect(bool b) {m_SendOnConnect = b;}
+	virtual bool HasSendRate() const {return false;}
+	virtual const QString& GetSendRate() const {return m_SendRate;}
+	virtual void SetSendRate(const QString &sendRate) {m_SendRate = sendRate;}
+	virtual unsigned int GetSendRateMS() const;
 	virtual const ToyWidget* ToyWidgetAt(const QPoint &pos) const;
 	virtual size_t ToyWidgetIndexAt(const QPoint &pos) const;
 	virtual void AddRecvWidgets(RECV_WIDGETS &recvWidgets) const;
@@ -138,6 +149,10 @@ public:
 	virtual void ClearLabels();
 	virtual Toy* AddToy(EnumToyType type, const QSize &gridSize, const QPoint &pos);
 	virtual void GetDefaultGridSize(QSize &gridSize) const;
+	virtual void UpdateTimer() {}
+	virtual void Step() {}	// generators catch up to CLOCK and send what is due
+	virtual void UpdateCellMode();
+	virtual void AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const;
 	
 	static bool ConfirmGridResize(QWidget *parent, bool tab, const QSize &beforeSize, const QSize &afterSize);
 	
@@ -157,6 +172,7 @@ private slots:
 	void onTabResized(size_t Id, const QSize &size);
 	void onToyAdded(size_t toyType, const QSize &gridSize);
 	void onClearLabels();
+	void onActivityChanged();
 
 private:
 	virtual void EditPanelClient_Deleted(EditPanel *editPanel);
@@ -173,12 +189,20 @@ protected:
 	QString				m_ImagePath;
 	QColor				m_Color;
 	bool				m_SendOnConnect;
+	QString				m_SendRate;		// blank = application default, see GetDefaultSendRateMS
 	size_t				m_EditWidgetIndex;
 	QMenu				*m_pContextMenu;
 	bool				m_Loading;
+	ToyCellView			*m_CellView;
+	PropertyPool		m_PropertyPool;
 	
 	virtual ToyWidget* CreateWidget() {return 0;}
+	virtual ToyWidget::CellClient* GetCellClient() const;
+	virtual bool AddWidget();
+	virtual void SetCellMode(bool b);
+	virtual bool ShouldUseCellMode(size_t numWidgets) const;
 	virtual QSize GetDefaultWidgetSize() const {return QSize(80,80);}
+	virtual unsigned int GetDefaultSendRateMS() const {return 0;}
 	virtual void UpdateMode();
 	virtual void UpdateLayout();
 	virtual void UpdateLayoutForRect(const QRect &r);
@@ -194,6 +218,8 @@ protected:
 	virtual void resizeEvent(QResizeEvent *event);
 	virtual void contextMenuEvent(QContextMenuEvent *event);
 	virtual void closeEvent(QCloseEvent *event);
+	virtual void showEvent(QShowEvent *event);
+	virtual void hideEvent(QHideEvent *event);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
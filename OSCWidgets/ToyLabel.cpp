@@ -22,6 +22,7 @@
 #include "Utils.h"
 #include "OSCParser.h"
 #include "FadeButton.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -34,6 +35,8 @@ FadeLabel::FadeLabel(QWidget *parent)
 
 void FadeLabel::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeLabel::paintEvent");
+
 	QRectF r( rect() );
 	r.adjust(1, 1, -1, -1);
 	
@@ -41,12 +44,8 @@ void FadeLabel::paintEvent(QPaintEvent* /*event*/)
 	painter.setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
 	
 	QColor penColor( palette().color(QPalette::Button) );
-	if(penColor.alpha() > 0)
-		painter.setPen( QPen(penColor,2) );
-	else
-		painter.setPen(Qt::NoPen);
-	painter.setBrush( palette().color(QPalette::Window) );
-	RenderBackground(painter, r);
+	QPen pen( (penColor.alpha() > 0) ? QPen(penColor,2) : QPen(Qt::NoPen) );
+	RenderBackgroundLayer(painter, r, pen, palette().color(QPalette::Window));
 	
 	sImage &img = m_Images[m_ImageIndex];
 	if( !img.pixmap.isNull() )
@@ -60,54 +59,34 @@ void FadeLabel::paintEvent(QPaintEvent* /*event*/)
 	if( !isEnabled() )
 		textColor = textColor.darker(150);
 	
-	if( !text().isEmpty() )
-	{
-		if( m_Label.isEmpty() )
-		{
-			// just text centered
-			painter.setPen(textColor);
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap, text());
-		}
-		else
-		{
-			// both text and label text
-			QRectF textRect;
-			painter.setPen(textColor);
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontPrint, text(), &textRect);
-			
-			QRectF labelRect;
-			painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontPrint, m_Label, &labelRect);
-			
-			qreal h = (r.height() * 0.5 * (textRect.height()/labelRect.height()));
-			painter.drawText(QRectF(r.x(),r.y(),r.width(),h), Qt::AlignCenter|Qt::TextWordWrap, text());
-			painter.drawText(QRectF(r.x(),r.y()+h,r.width(),r.height()-h), Qt::AlignCenter|Qt::TextWordWrap, m_Label);
-		}
-	}
-	else if( !m_Label.isEmpty() )
-	{
-		// just label text centered
-		painter.setPen(textColor);
-		painter.drawText(r, Qt::AlignCenter|Qt::TextWordWrap, m_Label);
-	}
+	RenderText(painter, r, textColor);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ToyLabelWidget::ToyLabelWidget(Toy::Client *pClient, QWidget *parent)
-	: ToyWidget(parent)
+ToyLabelWidget::ToyLabelWidget(Toy::Client *pClient, QWidget *parent, CellClient *pCellClient/* =0 */)
+	: ToyWidget(parent, pCellClient)
 	, m_pClient(pClient)
+	, m_CellImageIndex(IMAGE_PATH_INDEX_DEFAULT)
 {
 	m_HelpText = tr("OSC Trigger:\nImage Path");
 	
 	m_Color = QColor(60, 60, 60);
 	m_Color2 = QColor(40, 40, 40, 0);
 	
-	m_Widget = new FadeLabel(this);
-	QPalette pal( m_Widget->palette() );
-	m_TextColor = pal.color(QPalette::ButtonText);
-	pal.setColor(QPalette::Window, m_Color);
-	pal.setColor(QPalette::Button, m_Color2);
-	m_Widget->setPalette(pal);
+	if( IsCell() )
+	{
+		m_TextColor = palette().color(QPalette::ButtonText);
+	}
+	else
+	{
+		m_Widget = new FadeLabel(this);
+		QPalette pal( m_Widget->palette() );
+		m_TextColor = pal.color(QPalette::ButtonText);
+		pal.setColor(QPalette::Window, m_Color);
+		pal.setColor(QPalette::Button, m_Color2);
+		m_Widget->setPalette(pal);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -115,7 +94,10 @@ ToyLabelWidget::ToyLabelWidget(Toy::Client *pClient, QWidget *parent)
 void ToyLabelWidget::SetText(const QString &text)
 {
 	ToyWidget::SetText(text);
-	static_cast<FadeLabel*>(m_Widget)->setText(m_Text);
+	if( m_Widget )
+		static_cast<FadeLabel*>(m_Widget)->setText(m_Text);
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -123,7 +105,10 @@ void ToyLabelWidget::SetText(const QString &text)
 void ToyLabelWidget::SetImagePath(const QString &imagePath)
 {
 	ToyWidget::SetImagePath(imagePath);
-	static_cast<FadeLabel*>(m_Widget)->SetImagePath(0, m_ImagePath);
+	if( m_Widget )
+		static_cast<FadeLabel*>(m_Widget)->SetImagePath(0, m_ImagePath);
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -132,9 +117,14 @@ void ToyLabelWidget::SetColor(const QColor &color)
 {
 	ToyWidget::SetColor(color);
 	
-	QPalette pal( m_Widget->palette() );
-	pal.setColor(QPalette::Window, m_Color);
-	m_Widget->setPalette(pal);
+	if( m_Widget )
+	{
+		QPalette pal( m_Widget->palette() );
+		pal.setColor(QPalette::Window, m_Color);
+		m_Widget->setPalette(pal);
+	}
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -143,9 +133,14 @@ void ToyLabelWidget::SetColor2(const QColor &color2)
 {
 	ToyWidget::SetColor2(color2);
 	
-	QPalette pal( m_Widget->palette() );
-	pal.setColor(QPalette::Button, m_Color2);
-	m_Widget->setPalette(pal);
+	if( m_Widget )
+	{
+		QPalette pal( m_Widget->palette() );
+		pal.setColor(QPalette::Button, m_Color2);
+		m_Widget->setPalette(pal);
+	}
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -154,16 +149,29 @@ void ToyLabelWidget::SetTextColor(const QColor &textColor)
 {
 	ToyWidget::SetTextColor(textColor);
 
-	QPalette pal( m_Widget->palette() );
-	pal.setColor(QPalette::ButtonText, m_TextColor);
-	m_Widget->setPalette(pal);
+	if( m_Widget )
+	{
+		QPalette pal( m_Widget->palette() );
+		pal.setColor(QPalette::ButtonText, m_TextColor);
+		m_Widget->setPalette(pal);
+	}
+	else
+		CellChanged();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void ToyLabelWidget::SetLabel(const QString &label)
 {
-	static_cast<FadeLabel*>(m_Widget)->SetLabel(label);
+	if( m_Widget )
+	{
+		static_cast<FadeLabel*>(m_Widget)->SetLabel(label);
+	}
+	else if(m_CellLabel != label)
+	{
+		m_CellLabel = label;
+		CellChanged();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -171,7 +179,15 @@ void ToyLabelWidget::SetLabel(const QString &label)
 void ToyLabelWidget::ClearLabel()
 {
 	ToyWidget::ClearLabel();
-	static_cast<FadeLabel*>(m_Widget)->SetImageIndex(IMAGE_PATH_INDEX_DEFAULT);
+	if( m_Widget )
+	{
+		static_cast<FadeLabel*>(m_Widget)->SetImageIndex(IMAGE_PATH_INDEX_DEFAULT);
+	}
+	else if(m_CellImageIndex != IMAGE_PATH_INDEX_DEFAULT)
+	{
+		m_CellImageIndex = IMAGE_PATH_INDEX_DEFAULT;
+		CellChanged();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -188,11 +204,21 @@ void ToyLabelWidget::Recv(const QString &path, const OSCArgument *args, size_t c
 	
 	if(path == m_TriggerPath)
 	{
-		FadeLabel *label = static_cast<FadeLabel*>(m_Widget);
 		if( m_pClient )
 			m_pClient->ToyClient_ResourceRelativePathToAbsolute(str);
-		label->SetImagePath(IMAGE_PATH_INDEX_FROM_TRIGGER, str);
-		label->SetImageIndex(IMAGE_PATH_INDEX_FROM_TRIGGER);
+
+		if( m_Widget )
+		{
+			FadeLabel *label = static_cast<FadeLabel*>(m_Widget);
+			label->SetImagePath(IMAGE_PATH_INDEX_FROM_TRIGGER, str);
+			label->SetImageIndex(IMAGE_PATH_INDEX_FROM_TRIGGER);
+		}
+		else
+		{
+			m_CellTriggerImagePath = str;
+			m_CellImageIndex = IMAGE_PATH_INDEX_FROM_TRIGGER;
+			CellChanged();
+		}
 	}
 	else
 		SetLabel(str);
@@ -200,6 +226,18 @@ void ToyLabelWidget::Recv(const QString &path, const OSCArgument *args, size_t c
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyLabelWidget::GetCellState(sCellState &state) const
+{
+	state.text = m_Text;
+	state.label = m_CellLabel;
+	state.imagePath = ((m_CellImageIndex==IMAGE_PATH_INDEX_FROM_TRIGGER) ? m_CellTriggerImagePath : m_ImagePath);
+	state.color = m_Color;
+	state.borderColor = m_Color2;
+	state.textColor = m_TextColor;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 ToyLabelGrid::ToyLabelGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags)
 	: ToyGrid(TOY_LABEL_GRID, pClient, parent, flags)
 {
@@ -209,7 +247,7 @@ ToyLabelGrid::ToyLabelGrid(Client *pClient, QWidget *parent, Qt::WindowFlags fla
 
 ToyWidget* ToyLabelGrid::CreateWidget()
 {
-	return (new ToyLabelWidget(m_pClient,this));
+	return (new ToyLabelWidget(m_pClient,this,GetCellClient()));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
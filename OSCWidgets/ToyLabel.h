@@ -48,7 +48,7 @@ class ToyLabelWidget
 	: public ToyWidget
 {
 public:
-	ToyLabelWidget(Toy::Client *pClient, QWidget *parent);
+	ToyLabelWidget(Toy::Client *pClient, QWidget *parent, CellClient *pCellClient=0);
 	
 	virtual void SetText(const QString &text);
 	virtual void SetImagePath(const QString &imagePath);
@@ -63,6 +63,7 @@ public:
 	virtual bool HasMinMax() const {return false;}
 	virtual bool HasFeedbackPath() const {return false;}
 	virtual bool HasTriggerPath() const {return true;}
+	virtual void GetCellState(sCellState &state) const;
 	
 protected:
 	enum EnumConstants
@@ -72,6 +73,9 @@ protected:
 	};
 	
 	Toy::Client	*m_pClient;
+	QString		m_CellLabel;
+	QString		m_CellTriggerImagePath;
+	size_t		m_CellImageIndex;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -81,6 +85,8 @@ class ToyLabelGrid
 {	
 public:
 	ToyLabelGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags);
+
+	virtual bool HasCellMode() const {return true;}
 	
 protected:
 	virtual ToyWidget* CreateWidget();
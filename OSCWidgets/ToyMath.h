@@ -24,6 +24,9 @@
 
 #define _USE_MATH_DEFINES 1
 #include <math.h>
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -32,4 +35,64 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// small seedable PCG32 generator, cheap enough to keep one per widget
+class ToyRandom
+{
+public:
+	ToyRandom() {Seed( GetEntropy() );}
+	ToyRandom(uint64_t seed) {Seed(seed);}
+
+	void Seed(uint64_t seed)
+	{
+		m_State = 0;
+		m_Inc = ((MixSeed(seed) << 1) | 1);
+		Next();
+		m_State += seed;
+		Next();
+	}
+
+	uint32_t Next()
+	{
+		uint64_t oldState = m_State;
+		m_State = (oldState*6364136223846793005ULL + m_Inc);
+		uint32_t xorShifted = static_cast<uint32_t>( ((oldState >> 18) ^ oldState) >> 27 );
+		uint32_t rot = static_cast<uint32_t>(oldState >> 59);
+		return ((xorShifted >> rot) | (xorShifted << ((32 - rot) & 31)));
+	}
+
+	// [0,1]
+	float NextFloat() {return ((Next() >> 8) * (1.0f/16777215.0f));}
+
+	// splitmix64 finalizer, spreads nearby seeds apart
+	static uint64_t MixSeed(uint64_t x)
+	{
+		x += 0x9e3779b97f4a7c15ULL;
+		x = ((x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL);
+		x = ((x ^ (x >> 27)) * 0x94d049bb133111ebULL);
+		return (x ^ (x >> 31));
+	}
+
+	// FNV-1a, stable across builds and platforms unlike qHash
+	static uint64_t HashBytes(const char *data, size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		for(size_t i=0; i<size; i++)
+			hash = ((hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL);
+		return hash;
+	}
+
+	// unique per call, for generators that should not repeat between runs
+	static uint64_t GetEntropy()
+	{
+		static std::atomic<uint64_t> counter(0);
+		return MixSeed( (static_cast<uint64_t>(time(0)) << 20) ^ (++counter) ^ static_cast<uint64_t>(clock()) );
+	}
+
+private:
+	uint64_t	m_State;
+	uint64_t	m_Inc;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 #endif
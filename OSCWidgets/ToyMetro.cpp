@@ -21,6 +21,7 @@
 #include "ToyMetro.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 #define METRO_ARM_PEN	4
 
@@ -34,6 +35,9 @@ FadeMetro::FadeMetro(QWidget *parent)
 	, m_BPM(60)
 	, m_ArmLength(0)
 	, m_Paused(true)
+	, m_AnchorNS(0)
+	, m_AnchorPos(0)
+	, m_ScheduledBoundary(0)
 {
 	connect(this, SIGNAL(clicked(bool)), this, SLOT(onClicked(bool)));
 	UpdateSpeed();
@@ -43,12 +47,70 @@ FadeMetro::FadeMetro(QWidget *parent)
 
 void FadeMetro::ReCenter()
 {
-	m_Pos = 0;
+	Anchor(0);
 
 	if( !m_Paused )
 		emit tick(TICK_POS_CENTER);
 
-	update();
+	Invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeMetro::Reschedule()
+{
+	// drop ticks queued ahead, the next update queues them again from now
+	m_ScheduledBoundary = GetBoundaryForPhase( GetPhaseAt(CLOCK.GetTimeNS()) );
+	emit rescheduled();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeMetro::SetPos(float pos)
+{
+	Anchor(pos);
+	Invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeMetro::Anchor(float pos)
+{
+	// phase is computed from the anchor on every update, so there is no per-frame drift
+	m_Pos = pos;
+	m_AnchorNS = CLOCK.GetTimeNS();
+	m_AnchorPos = pos;
+	m_ScheduledBoundary = GetBoundaryForPhase(pos);
+	emit rescheduled();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+double FadeMetro::GetPhaseAt(qint64 ns) const
+{
+	if( m_Paused )
+		return m_AnchorPos;
+
+	return (m_AnchorPos + (ns-m_AnchorNS)*0.000001*m_Speed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 FadeMetro::GetBoundaryForPhase(double phase) const
+{
+	// boundaries are numbered 4 per cycle, one per segment start
+	double cycle = floor(phase / TWO_PI);
+	float pos = static_cast<float>(phase - cycle*TWO_PI);
+	return (static_cast<qint64>(cycle)*4 + GetSegmentForPos(pos));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+double FadeMetro::GetPhaseForBoundary(qint64 boundary) const
+{
+	qint64 cycle = (boundary >> 2);
+	int segment = static_cast<int>(boundary & 3);
+	return (cycle*TWO_PI + segment*(TWO_PI/3.99999));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -59,7 +121,7 @@ void FadeMetro::SetText(const QString &text)
 	{
 		setText(text);
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -71,7 +133,7 @@ void FadeMetro::SetLabel(const QString &label)
 	{
 		m_Label = label;
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -118,6 +180,8 @@ void FadeMetro::SetBPM(float bpm)
 {
 	if(m_BPM != bpm)
 	{
+		if( !m_Paused )
+			Anchor( fmod(GetPhaseAt(CLOCK.GetTimeNS()),TWO_PI) );
 		m_BPM = bpm;
 		UpdateSpeed();
 	}
@@ -129,12 +193,15 @@ void FadeMetro::SetPaused(bool b)
 {
 	if(m_Paused != b)
 	{
+		float pos = static_cast<float>( fmod(GetPhaseAt(CLOCK.GetTimeNS()),TWO_PI) );
 		m_Paused = b;
+		Anchor(pos);
 
 		if(!m_Paused && GetTickPos()==TICK_POS_CENTER)
 			emit tick(TICK_POS_CENTER);
 
-		update();
+		Invalidate();
+		emit activityChanged();
 	}
 }
 
@@ -182,25 +249,54 @@ FadeMetro::EnumTickPos FadeMetro::GetTickPosForSegment(int segment) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void FadeMetro::Update(unsigned int ms)
+void FadeMetro::Update(qint64 nowNS, bool emitTicks)
 {
-	if(!m_Paused && ms!=0)
+	if( !m_Paused )
 	{
 		float prevPos = m_Pos;
-		m_Pos = fmod(m_Pos + ms*m_Speed, static_cast<float>(TWO_PI));
+		double phase = GetPhaseAt(nowNS);
+		m_Pos = static_cast<float>( fmod(phase,TWO_PI) );
 
-		int prevSegment = GetSegmentForPos(prevPos);
-		int segment = GetSegmentForPos(m_Pos);
+		if( emitTicks )
+		{
+			int prevSegment = GetSegmentForPos(prevPos);
+			int segment = GetSegmentForPos(m_Pos);
 
-		if(segment != prevSegment)
-			emit tick( GetTickPosForSegment(segment) );
+			if(segment != prevSegment)
+				emit tick( GetTickPosForSegment(segment) );
 
-		update();
+			// keep the schedule in step so switching to scheduled ticks does not repeat one
+			m_ScheduledBoundary = qMax(m_ScheduledBoundary, GetBoundaryForPhase(phase));
+		}
+
+		Invalidate();
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool FadeMetro::GetNextTick(qint64 nowNS, qint64 beforeNS, qint64 &dueNS, EnumTickPos &tickPos)
+{
+	if(m_Paused || m_Speed<=0)
+		return false;
+
+	// after a stall, only the most recently crossed boundary is still sent
+	m_ScheduledBoundary = qMax(m_ScheduledBoundary, GetBoundaryForPhase(GetPhaseAt(nowNS))-1);
+
+	qint64 boundary = (m_ScheduledBoundary + 1);
+	double phase = GetPhaseForBoundary(boundary);
+	qint64 due = (m_AnchorNS + static_cast<qint64>((phase-m_AnchorPos)/m_Speed*1000000.0));
+	if(due > beforeNS)
+		return false;
+
+	m_ScheduledBoundary = boundary;
+	dueNS = due;
+	tickPos = GetTickPosForSegment( static_cast<int>(boundary & 3) );
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void FadeMetro::resizeEvent(QResizeEvent *event)
 {
 	FadeButton::resizeEvent(event);
@@ -212,6 +308,8 @@ void FadeMetro::resizeEvent(QResizeEvent *event)
 
 void FadeMetro::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeMetro::paintEvent");
+
 	QPainter painter(this);
 
 	painter.setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
@@ -331,6 +429,7 @@ ToyMetroWidget::ToyMetroWidget(QWidget *parent)
 
 	m_Widget = new FadeMetro(this);
 	connect(m_Widget, SIGNAL(tick(int)), this, SLOT(onTick(int)));
+	connect(m_Widget, SIGNAL(rescheduled()), this, SLOT(onRescheduled()));
 
 	m_BPM = QString::number( static_cast<FadeMetro*>(m_Widget)->GetBPM() );
 	
@@ -377,6 +476,39 @@ void ToyMetroWidget::SetTextColor(const QColor &textColor)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyMetroWidget::SetPath(const QString &path)
+{
+	if(m_Path != path)
+	{
+		ToyWidget::SetPath(path);
+		static_cast<FadeMetro*>(m_Widget)->Reschedule();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyMetroWidget::SetMin(const QString &n)
+{
+	if(m_Min != n)
+	{
+		ToyWidget::SetMin(n);
+		static_cast<FadeMetro*>(m_Widget)->Reschedule();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyMetroWidget::SetMax(const QString &n)
+{
+	if(m_Max != n)
+	{
+		ToyWidget::SetMax(n);
+		static_cast<FadeMetro*>(m_Widget)->Reschedule();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyMetroWidget::SetBPM(const QString &bpm)
 {
 	ToyWidget::SetBPM(bpm);
@@ -422,16 +554,16 @@ void ToyMetroWidget::Recv(const QString &path, const OSCArgument *args, size_t c
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ToyMetroWidget::Update(unsigned int ms)
+void ToyMetroWidget::onTick(int pos)
 {
-	static_cast<FadeMetro*>(m_Widget)->Update(ms);
+	emit tick(this, pos);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ToyMetroWidget::onTick(int pos)
+void ToyMetroWidget::onRescheduled()
 {
-	emit tick(this, pos);
+	emit rescheduled(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -464,10 +596,28 @@ ToyMetroGrid::ToyMetroGrid(Client *pClient, QWidget *parent, Qt::WindowFlags fla
 
 ////////////////////////////////////////////////////////////////////////////////
 
+ToyMetroGrid::~ToyMetroGrid()
+{
+	// metronomes are deleted after this, so cancel their queued ticks now and
+	// stop them reporting back to a grid that is gone
+	QList<ToyMetroWidget*> metros = findChildren<ToyMetroWidget*>();
+	for(QList<ToyMetroWidget*>::const_iterator i=metros.begin(); i!=metros.end(); i++)
+	{
+		disconnect(*i, 0, this, 0);
+		if( m_pClient )
+			m_pClient->ToyClient_CancelSends( static_cast<QObject*>(*i) );
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 ToyWidget* ToyMetroGrid::CreateWidget()
 {
 	ToyMetroWidget *w = new ToyMetroWidget(this);
 	connect(w, SIGNAL(tick(ToyMetroWidget*,int)), this, SLOT(onTick(ToyMetroWidget*,int)));
+	connect(w, SIGNAL(rescheduled(ToyMetroWidget*)), this, SLOT(onRescheduled(ToyMetroWidget*)));
+	connect(w, SIGNAL(destroyed(QObject*)), this, SLOT(onMetroDestroyed(QObject*)));
+	connect(&w->GetMetro(), SIGNAL(activityChanged()), this, SLOT(onActivityChanged()));
 	return w;
 }
 
@@ -475,8 +625,9 @@ ToyWidget* ToyMetroGrid::CreateWidget()
 
 void ToyMetroGrid::StartTimer()
 {
-	m_ElapsedTimer.Start();
-	m_Timer->start( Toy::GetMetroRefreshRateMS() );
+	m_Timer->setInterval( Toy::GetMetroRefreshRateMS() );
+	m_TickMetrics.Reset();
+	UpdateTimer();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -484,6 +635,39 @@ void ToyMetroGrid::StartTimer()
 void ToyMetroGrid::StopTimer()
 {
 	m_Timer->stop();
+	m_TickMetrics.Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyMetroGrid::UpdateTimer()
+{
+	if( IsAnimating() )
+	{
+		if( !m_Timer->isActive() )
+		{
+			m_TickMetrics.Reset();
+			m_Timer->start( Toy::GetMetroRefreshRateMS() );
+		}
+	}
+	else
+		StopTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyMetroGrid::IsAnimating() const
+{
+	// hidden metronomes only need the timer if they send
+	bool visible = isVisible();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		ToyMetroWidget *metro = static_cast<ToyMetroWidget*>(*i);
+		if(!metro->GetMetro().GetPaused() && (visible || !metro->GetPath().isEmpty()))
+			return true;
+	}
+
+	return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -569,72 +753,91 @@ void ToyMetroGrid::AutoSize(const QSize &widgetSize)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ToyMetroGrid::onTick(ToyMetroWidget *metro, int pos)
+bool ToyMetroGrid::IsScheduled(ToyMetroWidget *metro) const
 {
-	if(	m_pClient &&
-		metro &&
-		!metro->GetPath().isEmpty() )
-	{
-		QString value;
-		bool forceStrArg = false;
+	// ticks bound for the network are queued ahead with their exact due time,
+	// local ticks are still emitted from the timer
+	return (m_pClient &&
+			!metro->GetPath().isEmpty() &&
+			!Utils::IsLocalOSCPath(metro->GetPath()) );
+}
 
-		if( metro->GetMin().isEmpty() )
-		{
-			if(pos == FadeMetro::TICK_POS_CENTER)
-			{
-				if( !metro->GetMax().isEmpty() )
-					value = metro->GetMax();
-			}
-			else
-				return;
-		}
-		else if( metro->GetMax().isEmpty() )
-		{
-			if(pos == FadeMetro::TICK_POS_CENTER)
-				value = metro->GetMin();
-			else
-				return;
-		}
-		else if(metro->GetMin() == metro->GetMax())
+////////////////////////////////////////////////////////////////////////////////
+
+char* ToyMetroGrid::CreateTickPacket(ToyMetroWidget *metro, int pos, bool &local, size_t &size) const
+{
+	QString value;
+	bool forceStrArg = false;
+
+	if( metro->GetMin().isEmpty() )
+	{
+		if(pos == FadeMetro::TICK_POS_CENTER)
 		{
-			if(pos == FadeMetro::TICK_POS_CENTER)
-			{
+			if( !metro->GetMax().isEmpty() )
 				value = metro->GetMax();
-
-				if(!OSCArgument::IsFloatString(metro->GetMin().toUtf8().constData()) || !OSCArgument::IsFloatString(metro->GetMax().toUtf8().constData()))
-					forceStrArg = true;	// if either is non-numeric, send both as strings
-			}
-			else
-				return;
 		}
-		else if(pos==FadeMetro::TICK_POS_LEFT || pos==FadeMetro::TICK_POS_RIGHT)
+		else
+			return 0;
+	}
+	else if( metro->GetMax().isEmpty() )
+	{
+		if(pos == FadeMetro::TICK_POS_CENTER)
+			value = metro->GetMin();
+		else
+			return 0;
+	}
+	else if(metro->GetMin() == metro->GetMax())
+	{
+		if(pos == FadeMetro::TICK_POS_CENTER)
 		{
-			value = ((pos==FadeMetro::TICK_POS_LEFT)
-				? metro->GetMin()
-				: metro->GetMax() );
+			value = metro->GetMax();
 
 			if(!OSCArgument::IsFloatString(metro->GetMin().toUtf8().constData()) || !OSCArgument::IsFloatString(metro->GetMax().toUtf8().constData()))
-					forceStrArg = true;	// if either is non-numeric, send both as strings
+				forceStrArg = true;	// if either is non-numeric, send both as strings
 		}
 		else
-			return;
-		
-		QString path( metro->GetPath() );
-		bool local = Utils::MakeLocalOSCPath(false, path);
-
-		OSCPacketWriter packetWriter( path.toUtf8().constData() );
-		
-		if( !value.isEmpty() )
-		{
-			QByteArray ba( value.toUtf8() );
-			if(!forceStrArg && OSCArgument::IsFloatString(ba.constData()))
-				packetWriter.AddFloat32( value.toFloat() );
-			else
-				packetWriter.AddString( ba.constData() );
-		}
+			return 0;
+	}
+	else if(pos==FadeMetro::TICK_POS_LEFT || pos==FadeMetro::TICK_POS_RIGHT)
+	{
+		value = ((pos==FadeMetro::TICK_POS_LEFT)
+			? metro->GetMin()
+			: metro->GetMax() );
 
-		size_t size;
-		char *packet = packetWriter.Create(size);
+		if(!OSCArgument::IsFloatString(metro->GetMin().toUtf8().constData()) || !OSCArgument::IsFloatString(metro->GetMax().toUtf8().constData()))
+				forceStrArg = true;	// if either is non-numeric, send both as strings
+	}
+	else
+		return 0;
+	
+	QString path( metro->GetPath() );
+	local = Utils::MakeLocalOSCPath(false, path);
+
+	OSCPacketWriter packetWriter( path.toUtf8().constData() );
+	
+	if( !value.isEmpty() )
+	{
+		QByteArray ba( value.toUtf8() );
+		if(!forceStrArg && OSCArgument::IsFloatString(ba.constData()))
+			packetWriter.AddFloat32( value.toFloat() );
+		else
+			packetWriter.AddString( ba.constData() );
+	}
+
+	return packetWriter.Create(size);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyMetroGrid::onTick(ToyMetroWidget *metro, int pos)
+{
+	if(	m_pClient &&
+		metro &&
+		!metro->GetPath().isEmpty() )
+	{
+		bool local = false;
+		size_t size = 0;
+		char *packet = CreateTickPacket(metro, pos, local, size);
 		if( packet )
 			m_pClient->ToyClient_Send(local, packet, size);
 	}
@@ -642,11 +845,61 @@ void ToyMetroGrid::onTick(ToyMetroWidget *metro, int pos)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyMetroGrid::onRescheduled(ToyMetroWidget *metro)
+{
+	if( m_pClient )
+		m_pClient->ToyClient_CancelSends( static_cast<QObject*>(metro) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyMetroGrid::onMetroDestroyed(QObject *metro)
+{
+	// removed from the grid, its queued ticks must not outlive it
+	if( m_pClient )
+		m_pClient->ToyClient_CancelSends(metro);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyMetroGrid::onTimeout()
 {
-	unsigned int ms = m_ElapsedTimer.Restart();
+	TRACE_ZONE("ToyMetroGrid::onTimeout");
+
+	m_TickMetrics.Tick(Metrics::HISTOGRAM_GENERATOR_JITTER_US, m_Timer->interval());
+	Step();
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyMetroGrid::Step()
+{
+	qint64 nowNS = CLOCK.GetTimeNS();
+
+	// queue two timer periods ahead, so a late timeout never makes a tick late
+	qint64 beforeNS = (nowNS + 2*static_cast<qint64>(Toy::GetMetroRefreshRateMS())*1000000);
+
 	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
-		static_cast<ToyMetroWidget*>(*i)->Update(ms);
+	{
+		ToyMetroWidget *metro = static_cast<ToyMetroWidget*>(*i);
+		bool scheduled = IsScheduled(metro);
+		metro->GetMetro().Update(nowNS, !scheduled);
+
+		if( scheduled )
+		{
+			qint64 dueNS = 0;
+			FadeMetro::EnumTickPos tickPos = FadeMetro::TICK_POS_CENTER;
+			while( metro->GetMetro().GetNextTick(nowNS,beforeNS,dueNS,tickPos) )
+			{
+				bool local = false;
+				size_t size = 0;
+				char *packet = CreateTickPacket(metro, tickPos, local, size);
+				if( packet )
+					m_pClient->ToyClient_SendAt(packet, size, dueNS, static_cast<QObject*>(metro));
+			}
+		}
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -26,6 +26,10 @@
 #include "ToyButton.h"
 #endif
 
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 class FadeMetro
@@ -44,11 +48,13 @@ public:
 	FadeMetro(QWidget *parent);
 
 	virtual void ReCenter();
+	virtual void Reschedule();
 	virtual float GetPos() const {return m_Pos;}
-	virtual void SetPos(float pos) {m_Pos=pos; update();}
+	virtual void SetPos(float pos);
 	virtual void SetText(const QString &text);
 	virtual void SetLabel(const QString &label);
-	virtual void Update(unsigned int ms);
+	virtual void Update(qint64 nowNS, bool emitTicks);
+	virtual bool GetNextTick(qint64 nowNS, qint64 beforeNS, qint64 &dueNS, EnumTickPos &tickPos);
 	virtual float GetBPM() const {return m_BPM;}
 	virtual void SetBPM(float bpm);
 	virtual bool GetPaused() const {return m_Paused;}
@@ -56,6 +62,8 @@ public:
 
 signals:
 	void tick(int pos);
+	void rescheduled();
+	void activityChanged();
 
 private slots:
 	void onClicked(bool checked);
@@ -69,7 +77,14 @@ protected:
 	QRect	m_MetroRect;
 	float	m_ArmLength;
 	bool	m_Paused;
-
+	qint64	m_AnchorNS;
+	double	m_AnchorPos;
+	qint64	m_ScheduledBoundary;
+
+	virtual void Anchor(float pos);
+	virtual double GetPhaseAt(qint64 ns) const;
+	virtual qint64 GetBoundaryForPhase(double phase) const;
+	virtual double GetPhaseForBoundary(qint64 boundary) const;
 	virtual int GetSegment() const;
 	virtual int GetSegmentForPos(float pos) const;
 	virtual EnumTickPos GetTickPos() const;
@@ -96,19 +111,23 @@ public:
 	virtual void SetImagePath(const QString &imagePath);
 	virtual void SetColor(const QColor &color);
 	virtual void SetTextColor(const QColor &textColor);
+	virtual void SetPath(const QString &path);
+	virtual void SetMin(const QString &n);
+	virtual void SetMax(const QString &n);
 	virtual bool HasTriggerPath() const {return true;}
 	virtual void SetBPM(const QString &bpm);
 	virtual bool HasBPM() const {return true;}
 	virtual void SetLabel(const QString &label);
 	virtual void Recv(const QString &path, const OSCArgument *args, size_t count);
-	virtual void Update(unsigned int ms);
 	virtual FadeMetro& GetMetro() {return *static_cast<FadeMetro*>(m_Widget);}
 	
 signals:
 	void tick(ToyMetroWidget*, int pos);
+	void rescheduled(ToyMetroWidget*);
 
 private slots:
 	void onTick(int pos);
+	void onRescheduled();
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -120,12 +139,18 @@ class ToyMetroGrid
 	
 public:
 	ToyMetroGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags);	
+	virtual ~ToyMetroGrid();
 
 	virtual void StartTimer();
 	virtual void StopTimer();
+	virtual void UpdateTimer();
+	virtual void Step();
+	virtual char* CreateTickPacket(ToyMetroWidget *metro, int pos, bool &local, size_t &size) const;
 	
 private slots:
 	void onTick(ToyMetroWidget*, int pos);
+	void onRescheduled(ToyMetroWidget*);
+	void onMetroDestroyed(QObject*);
 	void onTimeout();
 	void onPlayClicked(bool checked);
 	void onPauseClicked(bool checked);
@@ -134,7 +159,7 @@ private slots:
 	
 protected:
 	QTimer		*m_Timer;
-	EosTimer	m_ElapsedTimer;
+	Metrics::TickTimer	m_TickMetrics;
 	FadeButton	*m_Play;
 	FadeButton	*m_Pause;
 	FadeButton	*m_ReCenter;
@@ -144,6 +169,8 @@ protected:
 	virtual QSize GetDefaultWidgetSize() const {return QSize(80,120);}
 	virtual void UpdateLayout();
 	virtual void AutoSize(const QSize &widgetSize);
+	virtual bool IsAnimating() const;
+	virtual bool IsScheduled(ToyMetroWidget *metro) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
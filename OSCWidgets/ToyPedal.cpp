@@ -21,6 +21,7 @@
 #include "ToyPedal.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 #define PEDAL_TIMEFRAME	5000
 
@@ -67,6 +68,7 @@ void FadePedal::SetState(EnumState state)
 		
 		m_State = state;
 		Update(0);
+		emit activityChanged();
 	}
 }
 
@@ -86,6 +88,17 @@ void FadePedal::Release()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+bool FadePedal::IsAnimating(bool visible) const
+{
+	if(m_State==STATE_UP || m_State==STATE_DOWN)
+		return true;
+
+	// the trace keeps scrolling until the last tick ages out
+	return (visible && !m_Ticks.empty() && m_Ticks.back().elapsed<PEDAL_TIMEFRAME);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void FadePedal::Update(unsigned int ms)
 {
 	switch( m_State )
@@ -145,7 +158,7 @@ void FadePedal::Update(unsigned int ms)
 				m_Ticks.erase( m_Ticks.begin() );
 		}
 		
-		update();
+		Invalidate();
 	}
 }
 
@@ -176,6 +189,8 @@ void FadePedal::resizeEvent(QResizeEvent *event)
 
 void FadePedal::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadePedal::paintEvent");
+
 	float lastValue = (m_Ticks.empty() ? 0 : m_Ticks.back().value);
 	float angle = (35 * lastValue);
 
@@ -504,6 +519,7 @@ ToyWidget* ToyPedalGrid::CreateWidget()
 {
 	ToyPedalWidget *w = new ToyPedalWidget(this);
 	connect(w, SIGNAL(tick(ToyPedalWidget*,float)), this, SLOT(onTick(ToyPedalWidget*,float)));
+	connect(&w->GetPedal(), SIGNAL(activityChanged()), this, SLOT(onActivityChanged()));
 	return w;
 }
 
@@ -511,8 +527,9 @@ ToyWidget* ToyPedalGrid::CreateWidget()
 
 void ToyPedalGrid::StartTimer()
 {
-	m_ElapsedTimer.Start();
-	m_Timer->start( Toy::GetPedalRefreshRateMS() );
+	m_Timer->setInterval( Toy::GetPedalRefreshRateMS() );
+	m_TickMetrics.Reset();
+	UpdateTimer();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -520,6 +537,41 @@ void ToyPedalGrid::StartTimer()
 void ToyPedalGrid::StopTimer()
 {
 	m_Timer->stop();
+	m_TickMetrics.Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyPedalGrid::UpdateTimer()
+{
+	if( IsAnimating() )
+	{
+		if( !m_Timer->isActive() )
+		{
+			m_ElapsedTimer.Start();
+			m_TickMetrics.Reset();
+			m_Timer->start( Toy::GetPedalRefreshRateMS() );
+		}
+	}
+	else
+		StopTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToyPedalGrid::IsAnimating() const
+{
+	bool visible = isVisible();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		ToyPedalWidget *pedal = static_cast<ToyPedalWidget*>(*i);
+		if( pedal->GetOutputFilter().HasPending() )
+			return true;
+		if( pedal->GetPedal().IsAnimating(visible) )
+			return true;
+	}
+
+	return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -554,7 +606,7 @@ void ToyPedalGrid::AutoSize(const QSize &widgetSize)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ToyPedalGrid::onTick(ToyPedalWidget *pedal, float value)
+void ToyPedalGrid::SendValue(ToyPedalWidget *pedal, float value)
 {
 	if(	m_pClient &&
 		pedal &&
@@ -565,12 +617,7 @@ void ToyPedalGrid::onTick(ToyPedalWidget *pedal, float value)
 
 		OSCPacketWriter packetWriter( path.toUtf8().constData() );
 		if(!pedal->GetMin().isEmpty() || !pedal->GetMax().isEmpty())
-		{
-			float minValue = pedal->GetMin().toFloat();
-			float maxValue = pedal->GetMax().toFloat();
-			value = (minValue + (maxValue-minValue)*value);
 			packetWriter.AddFloat32(value);
-		}
 
 		size_t size;
 		char *packet = packetWriter.Create(size);
@@ -581,11 +628,56 @@ void ToyPedalGrid::onTick(ToyPedalWidget *pedal, float value)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyPedalGrid::onTick(ToyPedalWidget *pedal, float value)
+{
+	if( pedal )
+	{
+		float output = value;
+		if(!pedal->GetMin().isEmpty() || !pedal->GetMax().isEmpty())
+		{
+			float minValue = pedal->GetMin().toFloat();
+			float maxValue = pedal->GetMax().toFloat();
+			output = (minValue + (maxValue-minValue)*value);
+		}
+
+		// end points are always sent, even when rate limited or within epsilon
+		OutputFilter &outputFilter = pedal->GetOutputFilter();
+		outputFilter.SetValue(output, Toy::GetSendEpsilon(), /*force*/(value<=0 || value>=1));
+
+		if( outputFilter.TakeValue(CLOCK.GetTimeNS(),GetSendRateMS(),output) )
+			SendValue(pedal, output);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyPedalGrid::onTimeout()
+{
+	TRACE_ZONE("ToyPedalGrid::onTimeout");
+
+	m_TickMetrics.Tick(Metrics::HISTOGRAM_GENERATOR_JITTER_US, m_Timer->interval());
+	Step();
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyPedalGrid::Step()
 {
 	unsigned int ms = m_ElapsedTimer.Restart();
 	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
 		static_cast<ToyPedalWidget*>(*i)->Update(ms);
+
+	// flush values held back by the send rate
+	qint64 nowNS = CLOCK.GetTimeNS();
+	unsigned int sendRateMS = GetSendRateMS();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		ToyPedalWidget *pedal = static_cast<ToyPedalWidget*>(*i);
+		float value;
+		if( pedal->GetOutputFilter().TakeValue(nowNS,sendRateMS,value) )
+			SendValue(pedal, value);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -26,6 +26,14 @@
 #include "ToyButton.h"
 #endif
 
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+#ifndef OUTPUT_FILTER_H
+#include "OutputFilter.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 class FadePedal
@@ -44,9 +52,11 @@ public:
 	virtual void SetDownDuration(unsigned int ms) {m_DownDuration = ms;}
 	virtual void Press();
 	virtual void Release();
+	virtual bool IsAnimating(bool visible) const;
 
 signals:
 	void tick(float value);
+	void activityChanged();
 
 private slots:
 	void onPressed();
@@ -121,12 +131,16 @@ public:
 	virtual void Recv(const QString &path, const OSCArgument *args, size_t count);
 	virtual void Update(unsigned int ms);
 	virtual FadePedal& GetPedal() {return *static_cast<FadePedal*>(m_Widget);}
+	virtual OutputFilter& GetOutputFilter() {return m_OutputFilter;}
 	
 signals:
 	void tick(ToyPedalWidget*, float value);
 
 private slots:
 	void onTick(float value);
+
+protected:
+	OutputFilter	m_OutputFilter;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -139,9 +153,12 @@ class ToyPedalGrid
 public:
 	ToyPedalGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags);
 
+	virtual bool HasSendRate() const {return true;}
 	virtual void GetDefaultGridSize(QSize &gridSize) const {gridSize = QSize(5,1);}
 	virtual void StartTimer();
 	virtual void StopTimer();
+	virtual void UpdateTimer();
+	virtual void Step();
 	
 private slots:
 	void onTick(ToyPedalWidget*, float value);
@@ -151,12 +168,16 @@ private slots:
 	
 protected:
 	QTimer		*m_Timer;
-	EosTimer	m_ElapsedTimer;
+	Metrics::TickTimer	m_TickMetrics;
+	ClockTimer	m_ElapsedTimer;
 	FadeButton	*m_Press;
 
 	virtual ToyWidget* CreateWidget();
+	virtual unsigned int GetDefaultSendRateMS() const {return Toy::GetPedalSendRateMS();}
 	virtual void UpdateLayout();
 	virtual void AutoSize(const QSize &widgetSize);
+	virtual bool IsAnimating() const;
+	virtual void SendValue(ToyPedalWidget *pedal, float value);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -21,6 +21,7 @@
 #include "ToySine.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -28,9 +29,9 @@ FadeSine::FadeSine(QWidget *parent)
 	: FadeButton(parent)
 	, m_TextMargin(0)
 	, m_LabelMargin(0)
-	, m_Pos(0)
 	, m_BPM(60.0f)
-	, m_Paused(true)
+	, m_Bank(0)
+	, m_Slot(0)
 {
 	connect(this, SIGNAL(clicked(bool)), this, SLOT(onClicked(bool)));
 	UpdateSpeed();
@@ -40,8 +41,19 @@ FadeSine::FadeSine(QWidget *parent)
 
 void FadeSine::ReCenter()
 {
-	m_Pos = 0;
-	update();
+	SetPos(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeSine::SetPos(float pos)
+{
+	if( m_Bank )
+		m_Bank->SetPhase(m_Slot, pos);
+	else
+		m_Local.phase = pos;
+
+	Invalidate();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -52,7 +64,7 @@ void FadeSine::SetText(const QString &text)
 	{
 		setText(text);
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -64,7 +76,7 @@ void FadeSine::SetLabel(const QString &label)
 	{
 		m_Label = label;
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -108,31 +120,62 @@ void FadeSine::SetBPM(float bpm)
 
 void FadeSine::SetPaused(bool b)
 {
-	if(m_Paused != b)
+	if(GetPaused() != b)
 	{
-		m_Paused = b;
-		update();
+		if( m_Bank )
+			m_Bank->SetPaused(m_Slot, b);
+		else
+			m_Local.paused = b;
+
+		Invalidate();
+		emit activityChanged();
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void FadeSine::UpdateSpeed()
+void FadeSine::SetRange(bool hasRange, float min, float max)
 {
-	float beatsPerMillisecond = (m_BPM / 60000);
-	m_Speed = (beatsPerMillisecond * M_PI);
+	if( m_Bank )
+	{
+		m_Bank->SetRange(m_Slot, hasRange, min, max);
+	}
+	else
+	{
+		m_Local.hasRange = hasRange;
+		m_Local.min = min;
+		m_Local.max = max;
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void FadeSine::Update(unsigned int ms)
+void FadeSine::SetBank(GeneratorBank *bank, size_t slot)
 {
-	if(!m_Paused && ms!=0)
-	{
-		m_Pos = fmod(m_Pos + ms*m_Speed, static_cast<float>(TWO_PI));
-		emit tick( sinf(m_Pos) );
-		update();
-	}
+	if(m_Bank==bank && m_Slot==slot)
+		return;
+
+	// carry generator state across, so rebinding is seamless
+	if( m_Bank )
+		m_Bank->GetSlot(m_Slot, m_Local);
+
+	m_Bank = bank;
+	m_Slot = slot;
+
+	if( m_Bank )
+		m_Bank->SetSlot(m_Slot, m_Local);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void FadeSine::UpdateSpeed()
+{
+	float beatsPerMillisecond = (m_BPM / 60000);
+	float speed = static_cast<float>(beatsPerMillisecond * M_PI);
+	if( m_Bank )
+		m_Bank->SetSpeed(m_Slot, speed);
+	else
+		m_Local.speed = speed;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -147,6 +190,8 @@ void FadeSine::resizeEvent(QResizeEvent *event)
 
 void FadeSine::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeSine::paintEvent");
+
 	QPainter painter(this);
 
 	painter.setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
@@ -187,11 +232,12 @@ void FadeSine::paintEvent(QPaintEvent* /*event*/)
 	float sineY = (r.y() + 0.5f*(r.height()-sineHeight));
 	float sineWidth = (r.right() + HALF_BORDER - sineX);
 	
+	float pos = GetPos();
 	for(int i=0; i<NUM_POINTS; i++)
 	{
 		float percent = (1.0f - i*toPercent);
 		float t = (TWO_PI*percent);
-		float y = ((sinf(m_Pos+t)+1.0f) * 0.5f);
+		float y = ((sinf(pos+t)+1.0f) * 0.5f);
 		m_Points[i].setX(sineX + percent*sineWidth);
 		m_Points[i].setY(sineY + sineHeight*(1.0f-y));
 	}
@@ -201,26 +247,22 @@ void FadeSine::paintEvent(QPaintEvent* /*event*/)
 	painter.drawPolyline(m_Points, NUM_POINTS);
 	painter.drawRoundedRect(r, ROUNDED, ROUNDED);
 
-	if( !text().isEmpty() )
+	if(!text().isEmpty() || !m_Label.isEmpty())
 	{
 		int hoverRaise = qRound(m_Hover * BUTTON_RAISE);
 
+		UpdateTextLayout( width() );
 		painter.setFont( font() );
 		painter.setPen( palette().color(QPalette::ButtonText) );
-		painter.drawText(QRect(0,0,width(),r.y()-hoverRaise), Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontClip, text());
+
+		if( !text().isEmpty() )
+			DrawStaticText(painter, QRectF(0,0,width(),r.y()-hoverRaise), m_TextLayout.text);
 
 		if( !m_Label.isEmpty() )
-			painter.drawText(QRect(0,r.bottom(),width(),height()-r.bottom()+hoverRaise), Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontClip, m_Label);
-	}
-	else if( !m_Label.isEmpty() )
-	{
-		int hoverRaise = qRound(m_Hover * BUTTON_RAISE);
-		painter.setFont( font() );
-		painter.setPen( palette().color(QPalette::ButtonText) );
-		painter.drawText(QRect(0,r.bottom(),width(),height()-r.bottom()+hoverRaise), Qt::AlignCenter|Qt::TextWordWrap|Qt::TextDontClip, m_Label);
+			DrawStaticText(painter, QRectF(0,r.bottom(),width(),height()-r.bottom()+hoverRaise), m_TextLayout.label);
 	}
 
-	if( m_Paused )
+	if( GetPaused() )
 	{
 		painter.setOpacity(0.8);
 		color = color.lighter(250);
@@ -246,7 +288,7 @@ void FadeSine::paintEvent(QPaintEvent* /*event*/)
 
 void FadeSine::onClicked(bool /*checked*/)
 {
-	if( m_Paused )
+	if( GetPaused() )
 	{
 		ReCenter();
 		SetPaused(false);
@@ -265,9 +307,9 @@ ToySineWidget::ToySineWidget(QWidget *parent)
 	m_HelpText = tr("Min=Peak\nMax=Valley\n\nOSC Trigger:\nNo Arguments = Play\nArgument(0) = Pause\nArgument(1) = Play");
 
 	m_Widget = new FadeSine(this);
-	connect(m_Widget, SIGNAL(tick(float)), this, SLOT(onTick(float)));
 
 	m_BPM = QString::number( static_cast<FadeSine*>(m_Widget)->GetBPM() );
+	UpdateRange();
 	
 	QPalette pal( m_Widget->palette() );
 	m_Color = pal.color(QPalette::Button);
@@ -321,6 +363,31 @@ void ToySineWidget::SetBPM(const QString &bpm)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToySineWidget::SetMin(const QString &n)
+{
+	ToyWidget::SetMin(n);
+	UpdateRange();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToySineWidget::SetMax(const QString &n)
+{
+	ToyWidget::SetMax(n);
+	UpdateRange();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToySineWidget::UpdateRange()
+{
+	// parsed once here rather than on every tick
+	bool hasRange = (!m_Min.isEmpty() || !m_Max.isEmpty());
+	static_cast<FadeSine*>(m_Widget)->SetRange(hasRange, m_Min.toFloat(), m_Max.toFloat());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToySineWidget::SetLabel(const QString &label)
 {
 	static_cast<FadeSine*>(m_Widget)->SetLabel(label);
@@ -355,19 +422,6 @@ void ToySineWidget::Recv(const QString &path, const OSCArgument *args, size_t co
 	}
 }
 
-////////////////////////////////////////////////////////////////////////////////
-
-void ToySineWidget::Update(unsigned int ms)
-{
-	static_cast<FadeSine*>(m_Widget)->Update(ms);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
-void ToySineWidget::onTick(float value)
-{
-	emit tick(this, value);
-}
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -399,19 +453,51 @@ ToySineGrid::ToySineGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags
 
 ////////////////////////////////////////////////////////////////////////////////
 
+ToySineGrid::~ToySineGrid()
+{
+	// widgets outlive m_Bank during base class destruction
+	BindBank(0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 ToyWidget* ToySineGrid::CreateWidget()
 {
 	ToySineWidget *w = new ToySineWidget(this);
-	connect(w, SIGNAL(tick(ToySineWidget*,float)), this, SLOT(onTick(ToySineWidget*,float)));
+	connect(&w->GetSine(), SIGNAL(activityChanged()), this, SLOT(onActivityChanged()));
 	return w;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToySineGrid::SetGridSize(const QSize &gridSize)
+{
+	// unbind widgets that may be removed, they are deleted later
+	BindBank(0);
+	ToyGrid::SetGridSize(gridSize);
+	BindBank( m_List.size() );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToySineGrid::BindBank(size_t count)
+{
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+		static_cast<ToySineWidget*>(*i)->GetSine().SetBank(0, 0);
+
+	m_Bank.Resize(count);
+
+	for(size_t i=0; i<count && i<m_List.size(); i++)
+		static_cast<ToySineWidget*>(m_List[i])->GetSine().SetBank(&m_Bank, i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToySineGrid::StartTimer()
 {
-	m_ElapsedTimer.Start();
-	m_Timer->start( Toy::GetSineRefreshRateMS() );
+	m_Timer->setInterval( Toy::GetSineRefreshRateMS() );
+	m_TickMetrics.Reset();
+	UpdateTimer();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -419,6 +505,42 @@ void ToySineGrid::StartTimer()
 void ToySineGrid::StopTimer()
 {
 	m_Timer->stop();
+	m_TickMetrics.Reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToySineGrid::UpdateTimer()
+{
+	if( IsAnimating() )
+	{
+		if( !m_Timer->isActive() )
+		{
+			m_ElapsedTimer.Start();
+			m_TickMetrics.Reset();
+			m_Timer->start( Toy::GetSineRefreshRateMS() );
+		}
+	}
+	else
+		StopTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool ToySineGrid::IsAnimating() const
+{
+	// hidden sines only need the timer if they send
+	bool visible = isVisible();
+	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		ToySineWidget *sine = static_cast<ToySineWidget*>(*i);
+		if( sine->GetOutputFilter().HasPending() )
+			return true;
+		if(!sine->GetSine().GetPaused() && (visible || !sine->GetPath().isEmpty()))
+			return true;
+	}
+
+	return false;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -504,7 +626,7 @@ void ToySineGrid::AutoSize(const QSize &widgetSize)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void ToySineGrid::onTick(ToySineWidget *sine, float value)
+void ToySineGrid::SendValue(ToySineWidget *sine, size_t index, float value)
 {
 	if(	m_pClient &&
 		sine &&
@@ -515,13 +637,8 @@ void ToySineGrid::onTick(ToySineWidget *sine, float value)
 
 		OSCPacketWriter packetWriter( path.toUtf8().constData() );
 		
-		if(!sine->GetMin().isEmpty() || !sine->GetMax().isEmpty())
-		{
-			float minValue = sine->GetMin().toFloat();
-			float maxValue = sine->GetMax().toFloat();
-			value = (minValue + (maxValue-minValue)*value);
+		if( m_Bank.HasRange(index) )
 			packetWriter.AddFloat32(value);
-		}
 
 		size_t size;
 		char *packet = packetWriter.Create(size);
@@ -533,10 +650,46 @@ void ToySineGrid::onTick(ToySineWidget *sine, float value)
 ////////////////////////////////////////////////////////////////////////////////
 
 void ToySineGrid::onTimeout()
+{
+	TRACE_ZONE("ToySineGrid::onTimeout");
+
+	m_TickMetrics.Tick(Metrics::HISTOGRAM_GENERATOR_JITTER_US, m_Timer->interval());
+	Step();
+	UpdateTimer();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToySineGrid::Step()
 {
 	unsigned int ms = m_ElapsedTimer.Restart();
-	for(WIDGET_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
-		static_cast<ToySineWidget*>(*i)->Update(ms);
+	if(ms == 0)
+		return;
+
+	// advance every sine in one pass, then repaint the running ones
+	m_Bank.Advance(ms);
+
+	// network output is filtered separately from the display refresh
+	qint64 nowNS = CLOCK.GetTimeNS();
+	unsigned int sendRateMS = GetSendRateMS();
+	float epsilon = Toy::GetSendEpsilon();
+
+	size_t count = qMin(m_Bank.GetCount(), m_List.size());
+	for(size_t i=0; i<count; i++)
+	{
+		ToySineWidget *sine = static_cast<ToySineWidget*>(m_List[i]);
+		OutputFilter &outputFilter = sine->GetOutputFilter();
+
+		if( !m_Bank.GetPaused(i) )
+		{
+			sine->GetSine().Invalidate();
+			outputFilter.SetValue(m_Bank.HasRange(i) ? m_Bank.GetOutput(i) : m_Bank.GetValue(i), epsilon, /*force*/false);
+		}
+
+		float value;
+		if( outputFilter.TakeValue(nowNS,sendRateMS,value) )
+			SendValue(sine, i, value);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
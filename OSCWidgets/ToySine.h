@@ -26,6 +26,18 @@
 #include "ToyButton.h"
 #endif
 
+#ifndef METRICS_H
+#include "Metrics.h"
+#endif
+
+#ifndef GENERATOR_BANK_H
+#include "GeneratorBank.h"
+#endif
+
+#ifndef OUTPUT_FILTER_H
+#include "OutputFilter.h"
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 class FadeSine
@@ -37,18 +49,19 @@ public:
 	FadeSine(QWidget *parent);
 
 	virtual void ReCenter();
-	virtual float GetPos() const {return m_Pos;}
-	virtual void SetPos(float pos) {m_Pos=pos; update();}
+	virtual float GetPos() const {return (m_Bank ? m_Bank->GetPhase(m_Slot) : m_Local.phase);}
+	virtual void SetPos(float pos);
 	virtual void SetText(const QString &text);
 	virtual void SetLabel(const QString &label);
-	virtual void Update(unsigned int ms);
 	virtual float GetBPM() const {return m_BPM;}
 	virtual void SetBPM(float bpm);
-	virtual bool GetPaused() const {return m_Paused;}
+	virtual bool GetPaused() const {return (m_Bank ? m_Bank->GetPaused(m_Slot) : m_Local.paused);}
 	virtual void SetPaused(bool b);
+	virtual void SetRange(bool hasRange, float min, float max);
+	virtual void SetBank(GeneratorBank *bank, size_t slot);
 
 signals:
-	void tick(float value);
+	void activityChanged();
 
 private slots:
 	void onClicked(bool checked);
@@ -59,13 +72,13 @@ protected:
 		NUM_POINTS	= 50
 	};
 	
-	int				m_TextMargin;
-	int				m_LabelMargin;
-	float			m_Pos;
-	float			m_Speed;
-	float			m_BPM;
-	bool			m_Paused;
-	QPointF			m_Points[NUM_POINTS];
+	int						m_TextMargin;
+	int						m_LabelMargin;
+	float					m_BPM;
+	GeneratorBank			*m_Bank;	// owned by grid, holds generator state while bound
+	size_t					m_Slot;
+	GeneratorBank::sSlot	m_Local;	// generator state while unbound
+	QPointF					m_Points[NUM_POINTS];
 
 	virtual void UpdateSpeed();
 	virtual void AutoSizeFont();
@@ -91,16 +104,17 @@ public:
 	virtual bool HasTriggerPath() const {return true;}
 	virtual void SetBPM(const QString &bpm);
 	virtual bool HasBPM() const {return true;}
+	virtual void SetMin(const QString &n);
+	virtual void SetMax(const QString &n);
 	virtual void SetLabel(const QString &label);
 	virtual void Recv(const QString &path, const OSCArgument *args, size_t count);
-	virtual void Update(unsigned int ms);
 	virtual FadeSine& GetSine() {return *static_cast<FadeSine*>(m_Widget);}
-	
-signals:
-	void tick(ToySineWidget*, float value);
+	virtual OutputFilter& GetOutputFilter() {return m_OutputFilter;}
 
-private slots:
-	void onTick(float value);
+protected:
+	OutputFilter	m_OutputFilter;
+
+	virtual void UpdateRange();
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -112,12 +126,16 @@ class ToySineGrid
 	
 public:
 	ToySineGrid(Client *pClient, QWidget *parent, Qt::WindowFlags flags);
+	virtual ~ToySineGrid();
 
+	virtual void SetGridSize(const QSize &gridSize);
+	virtual bool HasSendRate() const {return true;}
 	virtual void StartTimer();
 	virtual void StopTimer();
+	virtual void UpdateTimer();
+	virtual void Step();
 	
 private slots:
-	void onTick(ToySineWidget*, float value);
 	void onTimeout();
 	void onPlayClicked(bool checked);
 	void onPauseClicked(bool checked);
@@ -125,14 +143,20 @@ private slots:
 	void onFanClicked(bool checked);
 	
 protected:
-	QTimer		*m_Timer;
-	EosTimer	m_ElapsedTimer;
-	FadeButton	*m_Play;
-	FadeButton	*m_Pause;
-	FadeButton	*m_ReCenter;
-	FadeButton	*m_Fan;
+	QTimer			*m_Timer;
+	Metrics::TickTimer	m_TickMetrics;
+	ClockTimer		m_ElapsedTimer;
+	GeneratorBank	m_Bank;
+	FadeButton		*m_Play;
+	FadeButton		*m_Pause;
+	FadeButton		*m_ReCenter;
+	FadeButton		*m_Fan;
 
 	virtual ToyWidget* CreateWidget();
+	virtual unsigned int GetDefaultSendRateMS() const {return Toy::GetSineSendRateMS();}
+	virtual bool IsAnimating() const;
+	virtual void BindBank(size_t count);
+	virtual void SendValue(ToySineWidget *sine, size_t index, float value);
 	virtual QSize GetDefaultWidgetSize() const {return QSize(180,120);}
 	virtual void UpdateLayout();
 	virtual void AutoSize(const QSize &widgetSize);
@@ -21,6 +21,7 @@
 #include "ToySlider.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -45,7 +46,7 @@ void FadeSlider::SetText(const QString &text)
 	{
 		setText(text);
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -57,7 +58,7 @@ void FadeSlider::SetLabel(const QString &label)
 	{
 		m_Label = label;
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -77,7 +78,7 @@ void FadeSlider::SetPercentPrivate(float percent, bool user)
 		m_Percent = percent;
 		if( user )
 			emit percentChanged(m_Percent);
-		update();
+		Invalidate();
 	}
 }
 
@@ -91,7 +92,7 @@ void FadeSlider::RecvPercent(float percent)
 		{
 			m_RecvPercent.percent = percent;
 			m_RecvPercent.pending = true;
-			update();
+			Invalidate();
 		}
 	}
 	else
@@ -201,6 +202,8 @@ void FadeSlider::mouseReleaseEvent(QMouseEvent *event)
 
 void FadeSlider::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeSlider::paintEvent");
+
 	m_Canvas.fill(0);
 
 	QRectF r( rect() );
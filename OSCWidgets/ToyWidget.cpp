@@ -25,7 +25,29 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ToyWidget::ToyWidget(QWidget *parent)
+void PropertyPool::Share(QString &str)
+{
+	if( !str.isEmpty() )
+		str = *m_Strings.insert(str);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PropertyPool::Prune()
+{
+	// drop values no widget refers to anymore
+	for(STRINGS::iterator i=m_Strings.begin(); i!=m_Strings.end(); )
+	{
+		if( i->isDetached() )
+			i = m_Strings.erase(i);
+		else
+			++i;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ToyWidget::ToyWidget(QWidget *parent, CellClient *pCellClient/* =0 */)
 	: QWidget(parent)
 	, m_Widget(0)
 	, m_Mode(MODE_DEFAULT)
@@ -34,10 +56,21 @@ ToyWidget::ToyWidget(QWidget *parent)
 	, m_Max("1")
 	, m_Min2("0")
 	, m_Max2("1")
+	, m_EditButton(0)
+	, m_pCellClient(pCellClient)
+	, m_CellSelected(false)
 {
-	m_EditButton = new EditButton(this);
-	m_EditButton->hide();
-	connect(m_EditButton, SIGNAL(clicked(bool)), this, SLOT(onEditButtonClicked(bool)));
+	if( m_pCellClient )
+	{
+		// never shown, the cell view draws it
+		hide();
+	}
+	else
+	{
+		m_EditButton = new EditButton(this);
+		m_EditButton->hide();
+		connect(m_EditButton, SIGNAL(clicked(bool)), this, SLOT(onEditButtonClicked(bool)));
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -55,6 +88,12 @@ void ToyWidget::SetMode(EnumMode mode)
 
 void ToyWidget::UpdateMode()
 {
+	if( !m_EditButton )
+	{
+		UpdateVisible();
+		return;
+	}
+
 	switch( m_Mode )
 	{
 		case MODE_DEFAULT:
@@ -85,7 +124,10 @@ void ToyWidget::SetVisible(bool b)
 
 void ToyWidget::UpdateVisible()
 {
-	setVisible(m_Visible || m_Mode==MODE_EDIT);
+	if( m_pCellClient )
+		CellChanged();
+	else
+		setVisible(m_Visible || m_Mode==MODE_EDIT);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -147,14 +189,22 @@ void ToyWidget::SetPath2(const QString &path)
 
 bool ToyWidget::GetSelected() const
 {
-	return m_EditButton->GetSelected();
+	return (m_EditButton ? m_EditButton->GetSelected() : m_CellSelected);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 void ToyWidget::SetSelected(bool selected)
 {
-	m_EditButton->SetSelected(selected);
+	if( m_EditButton )
+	{
+		m_EditButton->SetSelected(selected);
+	}
+	else if(m_CellSelected != selected)
+	{
+		m_CellSelected = selected;
+		CellChanged();
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -195,7 +245,13 @@ void ToyWidget::UpdateToolTip()
 		tip.append( tr("OSC Trigger: %1").arg(m_TriggerPath) );
 	}
 
-	m_Widget->setToolTip(tip);
+	// one of these per cell, drop the append slack
+	tip.squeeze();
+
+	if( m_Widget )
+		m_Widget->setToolTip(tip);
+	else
+		setToolTip(tip);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -335,11 +391,95 @@ bool ToyWidget::Load(EosLog &log, const QString &path, QStringList &lines, int &
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyWidget::GetCellState(sCellState &state) const
+{
+	state.text = m_Text;
+	state.imagePath = m_ImagePath;
+	state.color = m_Color;
+	state.textColor = m_TextColor;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyWidget::CellEditClicked()
+{
+	emit edit(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyWidget::ShareProperties(PropertyPool &pool)
+{
+	// paths and text are usually unique per cell, so are not pooled
+	pool.Share(m_Path2);
+	pool.Share(m_FeedbackPath);
+	pool.Share(m_ImagePath);
+	pool.Share(m_ImagePath2);
+	pool.Share(m_Min);
+	pool.Share(m_Max);
+	pool.Share(m_Min2);
+	pool.Share(m_Max2);
+	pool.Share(m_BPM);
+	pool.Share(m_HelpText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyWidget::AddMemoryUsage(sMemoryUsage &usage) const
+{
+	usage.widgets++;
+	if( m_pCellClient )
+		usage.cells++;
+	usage.childWidgets += static_cast<size_t>( findChildren<QWidget*>().size() );
+
+	AddTextMemoryUsage(m_Path, usage);
+	AddTextMemoryUsage(m_Path2, usage);
+	AddTextMemoryUsage(m_LabelPath, usage);
+	AddTextMemoryUsage(m_FeedbackPath, usage);
+	AddTextMemoryUsage(m_TriggerPath, usage);
+	AddTextMemoryUsage(m_Text, usage);
+	AddTextMemoryUsage(m_ImagePath, usage);
+	AddTextMemoryUsage(m_ImagePath2, usage);
+	AddTextMemoryUsage(m_Min, usage);
+	AddTextMemoryUsage(m_Max, usage);
+	AddTextMemoryUsage(m_Min2, usage);
+	AddTextMemoryUsage(m_Max2, usage);
+	AddTextMemoryUsage(m_BPM, usage);
+	AddTextMemoryUsage(m_HelpText, usage);
+	AddTextMemoryUsage(m_Widget ? m_Widget->toolTip() : toolTip(), usage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyWidget::AddTextMemoryUsage(const QString &str, sMemoryUsage &usage)
+{
+	if( str.isEmpty() )
+		return;
+
+	// header plus utf-16 payload, counted once per shared buffer
+	size_t bytes = (sizeof(QArrayData) + (static_cast<size_t>(str.capacity())+1)*sizeof(QChar));
+	usage.unsharedTextBytes += bytes;
+	if( usage.texts.insert(str.constData()).second )
+		usage.textBytes += bytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void ToyWidget::CellChanged()
+{
+	if( m_pCellClient )
+		m_pCellClient->CellClient_Changed(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyWidget::resizeEvent(QResizeEvent *event)
 {
 	QWidget::resizeEvent(event);
-	m_Widget->setGeometry(MARGIN, MARGIN, width()-MARGIN2, height()-MARGIN2);
-	m_EditButton->setGeometry(0, 0, width(), height());
+	if( m_Widget )
+		m_Widget->setGeometry(MARGIN, MARGIN, width()-MARGIN2, height()-MARGIN2);
+	if( m_EditButton )
+		m_EditButton->setGeometry(0, 0, width(), height());
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -26,12 +26,34 @@
 #include "QtInclude.h"
 #endif
 
+#include <set>
+
 class EditButton;
 class OSCArgument;
 class EosLog;
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// grid level store for property values that rarely differ between cells,
+// widgets hold implicitly shared copies and an edit to one cell detaches it
+class PropertyPool
+{
+public:
+	typedef QSet<QString> STRINGS;
+
+	virtual ~PropertyPool() {}
+
+	virtual void Share(QString &str);
+	virtual void Prune();
+	virtual void Clear() {m_Strings.clear();}
+	virtual size_t GetCount() const {return static_cast<size_t>(m_Strings.size());}
+
+protected:
+	STRINGS	m_Strings;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class ToyWidget
 	: public QWidget
 {
@@ -43,8 +65,51 @@ public:
 		MODE_DEFAULT,
 		MODE_EDIT
 	};
+
+	// everything a cell view needs to draw a widget without its child widgets
+	struct sCellState
+	{
+		sCellState()
+			: down(false)
+		{}
+
+		QString	text;
+		QString	label;
+		QString	imagePath;
+		QColor	color;
+		QColor	borderColor;
+		QColor	textColor;
+		bool	down;
+	};
+
+	struct sMemoryUsage
+	{
+		sMemoryUsage()
+			: toys(0)
+			, widgets(0)
+			, cells(0)
+			, childWidgets(0)
+			, textBytes(0)
+			, unsharedTextBytes(0)
+		{}
+
+		size_t					toys;
+		size_t					widgets;
+		size_t					cells;
+		size_t					childWidgets;
+		size_t					textBytes;
+		size_t					unsharedTextBytes;
+		std::set<const void*>	texts;
+	};
+
+	// cells are drawn and hit-tested by a shared view instead of their own child widgets
+	class CellClient
+	{
+	public:
+		virtual void CellClient_Changed(ToyWidget *widget) = 0;
+	};
 	
-	ToyWidget(QWidget *parent);
+	ToyWidget(QWidget *parent, CellClient *pCellClient=0);
 	virtual ~ToyWidget() {}
 	
 	virtual QWidget* GetWidget() {return m_Widget;}
@@ -106,6 +171,15 @@ public:
 	virtual void Recv(const QString &path, const OSCArgument *args, size_t count);
 	virtual bool Save(EosLog &log, const QString &path, QStringList &lines);
 	virtual bool Load(EosLog &log, const QString &path, QStringList &lines, int &index);
+	virtual bool IsCell() const {return (m_pCellClient != 0);}
+	virtual void GetCellState(sCellState &state) const;
+	virtual void CellPressed() {}
+	virtual void CellReleased() {}
+	virtual void CellEditClicked();
+	virtual void ShareProperties(PropertyPool &pool);
+	virtual void AddMemoryUsage(sMemoryUsage &usage) const;
+
+	static void AddTextMemoryUsage(const QString &str, sMemoryUsage &usage);
 	
 signals:
 	void edit(ToyWidget*);
@@ -136,7 +210,10 @@ protected:
 	QString		m_BPM;
 	EditButton	*m_EditButton;
 	QString		m_HelpText;
+	CellClient	*m_pCellClient;
+	bool		m_CellSelected;
 	
+	virtual void CellChanged();
 	virtual void resizeEvent(QResizeEvent *event);
 	virtual void UpdateMode();
 	virtual void UpdateToolTip();
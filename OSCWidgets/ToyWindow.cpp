@@ -1,6 +1,7 @@
 #include "ToyWindow.h"
 #include "Toys.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -444,6 +445,8 @@ void EditFrame::mouseReleaseEvent(QMouseEvent* /*event*/)
 
 void EditFrame::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("EditFrame::paintEvent");
+
 	QRect r( rect() );
 	r.adjust(0, 0, -1, -1);
 	
@@ -737,6 +740,14 @@ void ToyWindowTab::AddRecvWidgets(Toy::RECV_WIDGETS &recvWidgets) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyWindowTab::AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const
+{
+	for(FRAME_LIST::const_iterator i=m_Frames.begin(); i!=m_Frames.end(); i++)
+		i->toy->AddMemoryUsage(usage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyWindowTab::ClearSelection()
 {
 	for(FRAME_LIST::const_iterator i=m_Frames.begin(); i!=m_Frames.end(); i++)
@@ -790,6 +801,8 @@ void ToyWindowTab::resizeEvent(QResizeEvent* /*event*/)
 
 void ToyWindowTab::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("ToyWindowTab::paintEvent");
+
 	QPainter painter(this);
 	painter.setRenderHint(QPainter::Antialiasing, false);
 	
@@ -1056,6 +1069,8 @@ TabBar::TabBar(QWidget *parent)
 
 void TabBar::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("TabBar::paintEvent");
+
 	QPainter painter(this);
 	painter.fillRect(QRect(0,0,width(),height()-TAB_SPACING), palette().color(QPalette::ButtonText));
 	painter.fillRect(QRect(0,height()-TAB_SPACING,width(),TAB_SPACING), palette().color(QPalette::Button));
@@ -1435,6 +1450,16 @@ void ToyWindow::AddRecvWidgets(RECV_WIDGETS &recvWidgets) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void ToyWindow::AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const
+{
+	ToyGrid::AddMemoryUsage(usage);
+
+	for(TABS::const_iterator i=m_Tabs.begin(); i!=m_Tabs.end(); i++)
+		i->widget->AddMemoryUsage(usage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void ToyWindowTab::TranslateSelection(const QPoint &delta, bool snap)
 {
 	QPoint clippedDelta(delta);
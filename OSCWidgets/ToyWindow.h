@@ -133,6 +133,7 @@ public:
 	virtual const FRAME_LIST& GetFrames() const {return m_Frames;}
 	virtual void ClearLabels();
 	virtual void AddRecvWidgets(Toy::RECV_WIDGETS &recvWidgets) const;
+	virtual void AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const;
 	virtual void ClearSelection();
 	virtual void SelectAll();
 	virtual void SetToySelected(Toy *toy, bool b);
@@ -251,6 +252,7 @@ public:
 	virtual bool Load(EosLog &log, const QString &path, QStringList &lines, int &index);
 	virtual void ClearLabels();
 	virtual void AddRecvWidgets(RECV_WIDGETS &recvWidgets) const;
+	virtual void AddMemoryUsage(ToyWidget::sMemoryUsage &usage) const;
 	
 	static int GetWidgetZOrder(QWidget &w);
 	
@@ -21,6 +21,7 @@
 #include "ToyXY.h"
 #include "OSCParser.h"
 #include "Utils.h"
+#include "Trace.h"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -45,7 +46,7 @@ void FadeXY::SetText(const QString &text)
 	{
 		setText(text);
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -57,7 +58,7 @@ void FadeXY::SetLabel(const QString &label)
 	{
 		m_Label = label;
 		UpdateMargins();
-		update();
+		Invalidate();
 	}
 }
 
@@ -77,7 +78,7 @@ void FadeXY::SetPosPrivate(const QPointF &pos, bool user)
 		m_Pos = pos;
 		if( user )
 			emit posChanged(m_Pos);
-		update();
+		Invalidate();
 	}
 }
 
@@ -91,7 +92,7 @@ void FadeXY::RecvPos(const QPointF &pos)
 		{
 			m_RecvPos.pos = pos;
 			m_RecvPos.pending = true;
-			update();
+			Invalidate();
 		}
 	}
 	else
@@ -228,6 +229,8 @@ void FadeXY::mouseReleaseEvent(QMouseEvent *event)
 
 void FadeXY::paintEvent(QPaintEvent* /*event*/)
 {
+	TRACE_ZONE("FadeXY::paintEvent");
+
 	m_Canvas.fill(0);
 
 	QRectF r( rect() );
@@ -21,8 +21,10 @@
 #include "Toys.h"
 #include "EosLog.h"
 #include "Utils.h"
+#include "Metrics.h"
 #include "OSCParser.h"
 #include "ToyWidget.h"
+#include "Trace.h"
 
 // TODO: restoring a maximized toy does not unmaximize to previous geometry
 
@@ -185,10 +187,13 @@ void Toys::ClearLabels()
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void Toys::Recv(char *data, size_t len)
+void Toys::Recv(char *data, size_t len, qint64 recvNS/* =0 */)
 {
+	TRACE_ZONE("Toys::Recv");
+
 	if(data && len!=0 && (!m_RecvWidgets.empty() || !m_WildcardRecvWidgets.empty()))
 	{
+		qint64 startNS = Utils::GetTimeNS();
 		QString recvPath;
 		
 		for(size_t i=0; i<len; i++)
@@ -209,11 +214,13 @@ void Toys::Recv(char *data, size_t len)
 			for(Toy::RECV_WIDGETS_RANGE range=m_RecvWidgets.equal_range(recvPath); range.first!=range.second; range.first++)
 			{
 				ToyWidget *w = range.first->second;
+				Metrics::RecvScope recvScope(recvNS, GetProbeSource(w,recvNS));
 				w->Recv(recvPath,args,argCount);
 			}
 
 			if(!m_WildcardRecvWidgets.empty())
 			{
+				qint64 wildcardStartNS = Utils::GetTimeNS();
 				QRegExp rx;
 				rx.setPatternSyntax(QRegExp::Wildcard);
 				rx.setCaseSensitivity(Qt::CaseSensitive);
@@ -243,24 +250,39 @@ void Toys::Recv(char *data, size_t len)
 					if(rx.exactMatch(recvPath))
 					{
 						ToyWidget *w = i->second;
+						Metrics::RecvScope recvScope(recvNS, GetProbeSource(w,recvNS));
 						if(args==0 || argCount==0)
 							w->Recv(recvPath, &pathArg, 1);
 						else
 							w->Recv(recvPath, args, argCount);
 					}
 				}
+
+				METRICS.Record(Metrics::HISTOGRAM_WILDCARD_US, (Utils::GetTimeNS()-wildcardStartNS)/1000);
 			}
 
 			if( args )
 				delete[] args;
 		}
+
+		METRICS.Record(Metrics::HISTOGRAM_DISPATCH_US, (Utils::GetTimeNS()-startNS)/1000);
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+int Toys::GetProbeSource(ToyWidget *w, qint64 recvNS) const
+{
+	// stamped by whatever the receive invalidates, see Metrics::PaintProbe
+	return ((recvNS != 0) ? Toy::GetLatencySource(w) : -1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void Toys::BuildRecvWidgetsTable()
 {
+	TRACE_ZONE("Toys::BuildRecvWidgetsTable");
+
 	m_RecvWidgets.clear();
 	m_WildcardRecvWidgets.clear();
 
@@ -413,7 +435,18 @@ void Toys::DeleteToy(size_t index)
 void Toys::RefreshAdvancedSettings()
 {
 	for(TOY_LIST::iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
 		(*i)->StartTimer();
+		(*i)->UpdateCellMode();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Toys::GetMemoryUsage(ToyWidget::sMemoryUsage &usage) const
+{
+	for(TOY_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
+		(*i)->AddMemoryUsage(usage);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
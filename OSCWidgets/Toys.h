@@ -59,7 +59,7 @@ public:
 	virtual int GetOpacity() const {return m_Opacity;}
 	virtual void SetOpacity(int opacity);
 	virtual void ClearLabels();
-	virtual void Recv(char *data, size_t len);
+	virtual void Recv(char *data, size_t len, qint64 recvNS=0);
 	virtual bool Save(EosLog &log, const QString &path, QStringList &lines);
 	virtual bool Load(EosLog &log, const QString &path, QStringList &lines, int &index);
 	virtual void ActivateToy(size_t index);
@@ -68,6 +68,7 @@ public:
 	virtual bool HasVisibleToys() const;
 	virtual void DeleteToy(size_t index);
 	virtual void RefreshAdvancedSettings();
+	virtual void GetMemoryUsage(ToyWidget::sMemoryUsage &usage) const;
 	virtual void Connected();
 	virtual void Disconnected();
 
@@ -93,6 +94,7 @@ protected:
 	bool				m_Loading;
 	
 	virtual void BuildRecvWidgetsTable();
+	virtual int GetProbeSource(ToyWidget *w, qint64 recvNS) const;
 	virtual Qt::WindowFlags GetWindowFlags() const;
 	virtual void UpdateWindowFlags();
 };
@@ -0,0 +1,159 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "Trace.h"
+
+#ifdef OSCWIDGETS_TRACE
+
+#include "Utils.h"
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define TRACE_SAFETY_EVENTS	64	// skipped at the old end of a full buffer, the owning thread may be overwriting them
+
+QMutex Trace::sm_Mutex;
+Trace::BUFFERS Trace::sm_Buffers;
+
+thread_local Trace::sThreadBuffer *Trace::sm_ThreadBuffer = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+
+Trace::sThreadBuffer::sThreadBuffer()
+	: id(0)
+	, name(0)
+	, count(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+Trace::sThreadBuffer* Trace::GetThreadBuffer()
+{
+	if( !sm_ThreadBuffer )
+	{
+		// buffers outlive their threads so a trace still shows threads that have exited
+		sThreadBuffer *buffer = new sThreadBuffer();
+		sm_Mutex.lock();
+		buffer->id = (sm_Buffers.size() + 1);
+		sm_Buffers.push_back(buffer);
+		sm_Mutex.unlock();
+		sm_ThreadBuffer = buffer;
+	}
+
+	return sm_ThreadBuffer;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Trace::Add(const char *name, qint64 startNS, qint64 durationNS)
+{
+	sThreadBuffer *buffer = GetThreadBuffer();
+	quint64 count = buffer->count.load();
+	sEvent &e = buffer->events[count % BUFFER_EVENTS];
+	e.name = name;
+	e.startNS = startNS;
+	e.durationNS = durationNS;
+	buffer->count.storeRelease(count + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Trace::SetThreadName(const char *name)
+{
+	GetThreadBuffer()->name = name;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool Trace::Save(const QString &path)
+{
+	QFile file(path);
+	if( !file.open(QIODevice::WriteOnly|QIODevice::Truncate) )
+		return false;
+
+	QByteArray json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+
+	sm_Mutex.lock();
+
+	for(BUFFERS::const_iterator i=sm_Buffers.begin(); i!=sm_Buffers.end(); i++)
+	{
+		const sThreadBuffer *buffer = *i;
+		QByteArray tid( QByteArray::number(buffer->id) );
+
+		if( buffer->name )
+		{
+			json += (first ? "" : ",\n");
+			json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"" + QByteArray(buffer->name) + "\"}}";
+			first = false;
+		}
+
+		const quint64 capacity = BUFFER_EVENTS;
+		quint64 count = buffer->count.loadAcquire();
+		quint64 start = ((count > capacity) ? (count - capacity + TRACE_SAFETY_EVENTS) : 0);
+		for(quint64 j=start; j<count; j++)
+		{
+			const sEvent &e = buffer->events[j % BUFFER_EVENTS];
+			json += (first ? "" : ",\n");
+			json += "{\"name\":\"" + QByteArray(e.name) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid;
+			json += ",\"ts\":" + QByteArray::number(e.startNS/1000.0, 'f', 3);
+			json += ",\"dur\":" + QByteArray::number(e.durationNS/1000.0, 'f', 3) + "}";
+			first = false;
+		}
+	}
+
+	sm_Mutex.unlock();
+
+	json += "\n]}\n";
+	bool ok = (file.write(json) == json.size());
+	file.close();
+	return ok;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Trace::Shutdown()
+{
+	// only once every traced thread has stopped
+	sm_Mutex.lock();
+	for(BUFFERS::const_iterator i=sm_Buffers.begin(); i!=sm_Buffers.end(); i++)
+		delete *i;
+	sm_Buffers.clear();
+	sm_Mutex.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TraceZone::TraceZone(const char *name)
+	: m_Name(name)
+	, m_StartNS( Utils::GetTimeNS() )
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+TraceZone::~TraceZone()
+{
+	Trace::Add(m_Name, m_StartNS, Utils::GetTimeNS()-m_StartNS);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
@@ -0,0 +1,109 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#pragma once
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifndef QT_INCLUDE_H
+#include "QtInclude.h"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// scoped timeline zones, saved on demand as a chrome trace json file that
+// chrome://tracing and perfetto can open
+//
+// compiled out entirely unless OSCWIDGETS_TRACE is defined (qmake CONFIG+=trace)
+
+#ifdef OSCWIDGETS_TRACE
+
+#include <vector>
+
+#define TRACE_CONCAT_IMPL(a,b)	a##b
+#define TRACE_CONCAT(a,b)		TRACE_CONCAT_IMPL(a,b)
+#define TRACE_ZONE(name)		TraceZone TRACE_CONCAT(traceZone,__LINE__)(name)
+#define TRACE_THREAD_NAME(name)	Trace::SetThreadName(name)
+
+class Trace
+{
+public:
+	enum EnumConstants
+	{
+		BUFFER_EVENTS	= 65536		// per thread, oldest events are overwritten
+	};
+
+	static void Add(const char *name, qint64 startNS, qint64 durationNS);
+	static void SetThreadName(const char *name);
+	static bool Save(const QString &path);
+	static void Shutdown();
+
+private:
+	struct sEvent
+	{
+		const char	*name;	// string literal
+		qint64		startNS;
+		qint64		durationNS;
+	};
+
+	// written only by its own thread, readers use the published count
+	struct sThreadBuffer
+	{
+		sThreadBuffer();
+		quint64					id;
+		const char				*name;
+		QAtomicInteger<quint64>	count;
+		sEvent					events[BUFFER_EVENTS];
+	};
+
+	typedef std::vector<sThreadBuffer*> BUFFERS;
+
+	static sThreadBuffer* GetThreadBuffer();
+
+	static QMutex	sm_Mutex;	// guards registering threads and saving only
+	static BUFFERS	sm_Buffers;
+	static thread_local sThreadBuffer *sm_ThreadBuffer;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class TraceZone
+{
+public:
+	TraceZone(const char *name);
+	~TraceZone();
+
+private:
+	const char	*m_Name;
+	qint64		m_StartNS;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_THREAD_NAME(name)
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#endif
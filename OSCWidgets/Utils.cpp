@@ -19,6 +19,7 @@
 // THE SOFTWARE.
 
 #include "Utils.h"
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -106,13 +107,23 @@ void Utils::GetItemsFromQuotedString(const QString &str, QStringList &items)
 ////////////////////////////////////////////////////////////////////////////////
 
 PixmapCache::PixmapCache()
+	: m_Budget(0)
+	, m_SourceBytes(0)
+	, m_ScaledBytes(0)
+	, m_UseCount(0)
+	, m_Evictions(0)
 {
+	// leave a core for the gui
+	int numThreads = qBound(1, QThread::idealThreadCount()-1, 4);
+	m_Loader = new PixmapLoader(*this, numThreads);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
 PixmapCache::~PixmapCache()
 {
+	delete m_Loader;
+	m_Loader = 0;
 	Clear();
 }
 
@@ -120,28 +131,26 @@ PixmapCache::~PixmapCache()
 
 void PixmapCache::Clear()
 {
-	for(PIXMAP_LIST::const_iterator i=m_List.begin(); i!=m_List.end(); i++)
-		delete i->second.pixmap;
+	m_Clients.clear();
+	m_ScaledList.clear();
 	m_List.clear();
+	m_SourceBytes = 0;
+	m_ScaledBytes = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-const QPixmap* PixmapCache::Create(const QString &path)
+void PixmapCache::Create(const QString &path)
 {
 	if( path.isEmpty() )
-		return 0;
+		return;
 
-	PIXMAP_LIST::iterator i = m_List.find(path);
-	if(i == m_List.end())
-	{
-		sPixmapCacheItem item = {new QPixmap(path), 1};
-		m_List[path] = item;
-		return item.pixmap;
-	}
+	sPixmapCacheItem &item = m_List[path];
+	item.refCount++;
+	item.lastUsed = ++m_UseCount;
 
-	i->second.refCount++;
-	return i->second.pixmap;
+	if(!item.decoded && !item.loading)
+		Decode(path, item);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -153,13 +162,33 @@ void PixmapCache::Destroy(const QString &path)
 		PIXMAP_LIST::iterator i = m_List.find(path);
 		if(i != m_List.end())
 		{
-			if(i->second.refCount != 0)
-				i->second.refCount--;
+			sPixmapCacheItem &item = i->second;
+			if(item.refCount != 0)
+				item.refCount--;
 
-			if(i->second.refCount == 0)
+			if(item.refCount == 0)
 			{
-				delete i->second.pixmap;
-				m_List.erase(i);
+				// decoded images stay cached until the budget needs the space,
+				// without a budget nothing would evict them so they go now
+				if(item.image.isNull() || m_Budget==0)
+				{
+					SetSourceImage(item, QImage());
+					if(m_Budget == 0)
+						TrimScaled(path);
+
+					// and any sizes still waiting on it
+					for(SCALED_LIST::iterator j=m_ScaledList.begin(); j!=m_ScaledList.end(); )
+					{
+						if(j->second.pending && j->second.refCount==0 && j->first.path==path)
+							m_ScaledList.erase(j++);
+						else
+							j++;
+					}
+					m_List.erase(i);
+				}
+				else
+					item.lastUsed = ++m_UseCount;
+				Trim();
 			}
 		}
 	}
@@ -167,54 +196,381 @@ void PixmapCache::Destroy(const QString &path)
 
 ////////////////////////////////////////////////////////////////////////////////
 
-const QPixmap* PixmapCache::Get(const QString &path) const
+void PixmapCache::Decode(const QString &path, sPixmapCacheItem &item)
 {
-	PIXMAP_LIST::const_iterator i = m_List.find(path);
-	return ((i==m_List.end()) ? 0 : i->second.pixmap);
+	// decode off the gui thread
+	item.loading = true;
+
+	PixmapLoader::sJob job;
+	job.path = path;
+	job.decode = true;
+	m_Loader->Load(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::SetSourceImage(sPixmapCacheItem &item, const QImage &image)
+{
+	m_SourceBytes -= GetBytes(item.image);
+	item.image = image;
+	m_SourceBytes += GetBytes(item.image);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::SetScaledPixmap(sScaledItem &item, const QPixmap &pixmap)
+{
+	m_ScaledBytes -= GetBytes(item.pixmap);
+	item.pixmap = pixmap;
+	m_ScaledBytes += GetBytes(item.pixmap);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 PixmapCache::GetBytes(const QImage &image)
+{
+	return (static_cast<qint64>(image.bytesPerLine()) * image.height());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+qint64 PixmapCache::GetBytes(const QPixmap &pixmap)
+{
+	return ((static_cast<qint64>(pixmap.width()) * pixmap.height() * pixmap.depth()) / 8);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void PixmapCache::Get(const QString &path, QPixmap &pixmap) const
+void PixmapCache::SetBudget(qint64 bytes)
 {
-	const QPixmap *p = Get(path);
-	pixmap = (p ? (*p) : QPixmap());
+	m_Budget = qMax(static_cast<qint64>(0), bytes);
+	Trim();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void PixmapCache::GetScaledToFit(const QString &path, const QSize &size, QPixmap &pixmap) const
+void PixmapCache::Trim()
 {
-	const QPixmap *p = Get(path);
-	if(p && !p->isNull() && !size.isEmpty())
+	if(m_Budget > 0)
 	{
-		QRect r(0, 0, p->width(), p->height());
-		if( FitRectInBounds(QRect(0,0,size.width(),size.height()),Qt::AlignCenter,r) )
-			pixmap = p->scaled(r.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		while(GetBytes() > m_Budget)
+		{
+			if( !EvictOldest() )
+				break;	// everything left is on screen
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PixmapCache::EvictOldest()
+{
+	// least recently used scaled pixmap nobody draws, or decoded source not being loaded
+	SCALED_LIST::iterator oldestScaled = m_ScaledList.end();
+	for(SCALED_LIST::iterator i=m_ScaledList.begin(); i!=m_ScaledList.end(); i++)
+	{
+		const sScaledItem &item = i->second;
+		if(item.refCount==0 && !item.pending)
+		{
+			if(oldestScaled==m_ScaledList.end() || item.lastUsed<oldestScaled->second.lastUsed)
+				oldestScaled = i;
+		}
+	}
+
+	PIXMAP_LIST::iterator oldestSource = m_List.end();
+	for(PIXMAP_LIST::iterator i=m_List.begin(); i!=m_List.end(); i++)
+	{
+		const sPixmapCacheItem &item = i->second;
+		if(!item.loading && !item.image.isNull())
+		{
+			if(oldestSource==m_List.end() || item.lastUsed<oldestSource->second.lastUsed)
+				oldestSource = i;
+		}
+	}
+
+	if(oldestScaled!=m_ScaledList.end() && (oldestSource==m_List.end() || oldestScaled->second.lastUsed<=oldestSource->second.lastUsed))
+	{
+		SetScaledPixmap(oldestScaled->second, QPixmap());
+		m_ScaledList.erase(oldestScaled);
+		m_Evictions++;
+		return true;
+	}
+
+	if(oldestSource != m_List.end())
+	{
+		sPixmapCacheItem &item = oldestSource->second;
+		SetSourceImage(item, QImage());
+		if(item.refCount == 0)
+			m_List.erase(oldestSource);
 		else
-			pixmap = QPixmap();
+			item.decoded = false;	// still referenced, decoded again when a new size is needed
+		m_Evictions++;
+		return true;
 	}
-	else
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PixmapCache::IsLoading(const QString &path) const
+{
+	PIXMAP_LIST::const_iterator i = m_List.find(path);
+	return (i!=m_List.end() && i->second.loading);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QSize PixmapCache::GetScaledSize(const QSize &sourceSize, const QSize &size, EnumScaleMode mode)
+{
+	if(sourceSize.isEmpty() || size.isEmpty())
+		return QSize();
+
+	if(mode == SCALE_TO_FIT)
+	{
+		QRect r(0, 0, sourceSize.width(), sourceSize.height());
+		if( FitRectInBounds(QRect(0,0,size.width(),size.height()),Qt::AlignCenter,r) )
+			return r.size();
+		return QSize();
+	}
+
+	// scale to bounds width
+	float t = (size.width() / static_cast<float>(sourceSize.width()));
+	int h = qRound(sourceSize.height() * t);
+	if(h < size.height())
+		t = (size.height() / static_cast<float>(sourceSize.height()));
+
+	return QSize(qRound(sourceSize.width()*t), qRound(sourceSize.height()*t));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool PixmapCache::sScaledKey::operator<(const sScaledKey &other) const
+{
+	if(mode != other.mode)
+		return (mode < other.mode);
+	if(size.width() != other.size.width())
+		return (size.width() < other.size.width());
+	if(size.height() != other.size.height())
+		return (size.height() < other.size.height());
+	return (path < other.path);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::CreateScaled(const QString &path, const QSize &size, EnumScaleMode mode, QPixmap &pixmap, Client *pClient/* =0 */)
+{
+	if(path.isEmpty() || size.isEmpty())
+	{
 		pixmap = QPixmap();
+		return;
+	}
+
+	// every widget showing this image at this size shares one scaled pixmap
+	sScaledKey key(path, size, mode);
+	SCALED_LIST::iterator i = m_ScaledList.find(key);
+	bool created = (i == m_ScaledList.end());
+	if( created )
+		i = m_ScaledList.insert( SCALED_LIST_PAIR(key,sScaledItem()) ).first;
+
+	sScaledItem &item = i->second;
+	if(item.refCount == 0)
+		Create(path);	// users of a scaled pixmap keep its source referenced
+	item.refCount++;
+	item.lastUsed = ++m_UseCount;
+
+	if( created )
+	{
+		sPixmapCacheItem &source = m_List[path];
+		if( source.loading )
+		{
+			// scaled on the loader once the source is decoded
+			item.pending = true;
+		}
+		else
+		{
+			// source already decoded, a single scale is cheaper than a round trip
+			QSize scaledSize = GetScaledSize(source.image.size(), size, mode);
+			if( !scaledSize.isEmpty() )
+				SetScaledPixmap(item, QPixmap::fromImage(source.image.scaled(scaledSize,Qt::IgnoreAspectRatio,Qt::SmoothTransformation)));
+			source.lastUsed = ++m_UseCount;
+			Trim();
+		}
+	}
+
+	pixmap = item.pixmap;
+
+	if(item.pending && pClient)
+		m_Clients.insert( CLIENTS_PAIR(path,pClient) );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void PixmapCache::GetScaledToFill(const QString &path, const QSize &size, QPixmap &pixmap) const
+void PixmapCache::GetScaled(const QString &path, const QSize &size, EnumScaleMode mode, QPixmap &pixmap) const
 {
-	const QPixmap *p = Get(path);
-	if(p && !p->isNull() && !size.isEmpty())
+	SCALED_LIST::const_iterator i = m_ScaledList.find( sScaledKey(path,size,mode) );
+	pixmap = ((i==m_ScaledList.end()) ? QPixmap() : i->second.pixmap);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::DestroyScaled(const QString &path, const QSize &size, EnumScaleMode mode)
+{
+	if(path.isEmpty() || size.isEmpty())
+		return;
+
+	SCALED_LIST::iterator i = m_ScaledList.find( sScaledKey(path,size,mode) );
+	if(i != m_ScaledList.end())
 	{
-		// scale to bounds width
-		float t = (size.width() / static_cast<float>(p->width()));
-		int h = qRound(p->height() * t);
-		if(h < size.height())
-			t = (size.height() / static_cast<float>(p->height()));
+		if(i->second.refCount != 0)
+			i->second.refCount--;
 
-		pixmap = p->scaled(QSize(qRound(p->width()*t),qRound(p->height()*t)), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		if(i->second.refCount == 0)
+		{
+			// stays cached for reuse until the budget needs the space
+			i->second.lastUsed = ++m_UseCount;
+			TrimScaled(path);
+			Destroy(path);
+		}
 	}
-	else
-		pixmap = QPixmap();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::TrimScaled(const QString &path)
+{
+	// without a budget nothing else would ever evict them
+	size_t maxIdle = ((m_Budget > 0) ? MAX_IDLE_SCALED : 0);
+
+	for(;;)
+	{
+		size_t numIdle = 0;
+		SCALED_LIST::iterator oldest = m_ScaledList.end();
+		for(SCALED_LIST::iterator i=m_ScaledList.begin(); i!=m_ScaledList.end(); i++)
+		{
+			const sScaledItem &item = i->second;
+			if(item.refCount==0 && i->first.path==path)
+			{
+				numIdle++;
+				if(oldest==m_ScaledList.end() || item.lastUsed<oldest->second.lastUsed)
+					oldest = i;
+			}
+		}
+
+		if(numIdle <= maxIdle)
+			break;
+
+		SetScaledPixmap(oldest->second, QPixmap());
+		m_ScaledList.erase(oldest);
+		m_Evictions++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::RemoveClient(Client *pClient)
+{
+	for(CLIENTS::iterator i=m_Clients.begin(); i!=m_Clients.end(); )
+	{
+		if(i->second == pClient)
+			m_Clients.erase(i++);
+		else
+			i++;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::QueuePendingScales(const QString &path, const QImage &source)
+{
+	PixmapLoader::sJob job;
+	job.path = path;
+	job.source = source;
+
+	for(SCALED_LIST::iterator i=m_ScaledList.begin(); i!=m_ScaledList.end(); i++)
+	{
+		sScaledItem &item = i->second;
+		if(item.pending && !item.queued && i->first.path==path)
+		{
+			if( source.isNull() )
+			{
+				// nothing to scale, stays blank
+				item.pending = false;
+			}
+			else
+			{
+				PixmapLoader::sScaled scaled;
+				scaled.size = i->first.size;
+				scaled.mode = static_cast<int>(i->first.mode);
+				job.scaled.push_back(scaled);
+				item.queued = true;
+			}
+		}
+	}
+
+	if( !job.scaled.empty() )
+		m_Loader->Load(job);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::NotifyClients(const QString &path)
+{
+	for(SCALED_LIST::const_iterator i=m_ScaledList.begin(); i!=m_ScaledList.end(); i++)
+	{
+		if(i->second.pending && i->first.path==path)
+			return;	// more to come
+	}
+
+	std::pair<CLIENTS::iterator,CLIENTS::iterator> range = m_Clients.equal_range(path);
+	if(range.first == range.second)
+		return;
+
+	std::vector<Client*> clients;
+	for(CLIENTS::iterator i=range.first; i!=range.second; i++)
+	{
+		if(std::find(clients.begin(),clients.end(),i->second) == clients.end())
+			clients.push_back(i->second);
+	}
+	m_Clients.erase(range.first, range.second);
+
+	for(std::vector<Client*>::const_iterator i=clients.begin(); i!=clients.end(); i++)
+		(*i)->PixmapCacheClient_Loaded(path);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void PixmapCache::PixmapLoaderClient_Loaded(PixmapLoader::sJob &job)
+{
+	PIXMAP_LIST::iterator i = m_List.find(job.path);
+	if(i == m_List.end())
+		return;	// released while loading
+
+	sPixmapCacheItem &source = i->second;
+	if( job.decode )
+	{
+		SetSourceImage(source, job.source);
+		source.loading = false;
+		source.decoded = true;
+	}
+
+	for(PixmapLoader::SCALED_LIST::const_iterator j=job.scaled.begin(); j!=job.scaled.end(); j++)
+	{
+		SCALED_LIST::iterator k = m_ScaledList.find( sScaledKey(job.path,j->size,static_cast<EnumScaleMode>(j->mode)) );
+		if(k!=m_ScaledList.end() && k->second.pending)
+		{
+			SetScaledPixmap(k->second, QPixmap::fromImage(j->image));
+			k->second.pending = false;
+			k->second.queued = false;
+		}
+	}
+
+	// sizes asked for while the source was decoding
+	if( !source.loading )
+		QueuePendingScales(job.path, source.image);
+
+	NotifyClients(job.path);
+	Trim();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -434,3 +790,18 @@ void Utils::Snap(int snap, QPoint &point)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+
+qint64 Utils::GetTimeNS()
+{
+	// monotonic, shared by all threads so timestamps can be compared across them
+	struct sClock
+	{
+		sClock() {timer.start();}
+		QElapsedTimer timer;
+	};
+
+	static sClock clock;
+	return clock.timer.nsecsElapsed();
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +30,10 @@
 #include <Windows.h>
 #endif
 
+#ifndef PIXMAP_LOADER_H
+#include "PixmapLoader.h"
+#endif
+
 #include <map>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -49,6 +53,7 @@ public:
 	static void MakeDarkerColor(float percent, QColor &color);
 	static void Snap(int snap, int &value);
 	static void Snap(int snap, QPoint &point);
+	static qint64 GetTimeNS();
 
 #ifdef WIN32
 	typedef BOOL (WINAPI *FuncRegisterTouchWindow)(HWND hWnd, ULONG ulFlags);
@@ -62,37 +67,134 @@ public:
 ////////////////////////////////////////////////////////////////////////////////
 
 class PixmapCache
+	: private PixmapLoader::Client
 {
 public:
+	enum EnumScaleMode
+	{
+		SCALE_TO_FIT,
+		SCALE_TO_FILL
+	};
+
+	enum EnumConstants
+	{
+		MAX_IDLE_SCALED	= 4	// unreferenced sizes kept per image, resizing leaves one behind per step
+	};
+
 	struct sPixmapCacheItem
 	{
-		const QPixmap	*pixmap;
+		sPixmapCacheItem()
+			: refCount(0)
+			, loading(false)
+			, decoded(false)
+			, lastUsed(0)
+		{}
+
+		QImage			image;	// decoded source, only ever scaled from
 		unsigned int	refCount;
+		bool			loading;
+		bool			decoded;	// false again once evicted, decoded again on demand
+		quint64			lastUsed;
 	};
 
 	typedef std::map<QString,sPixmapCacheItem>	PIXMAP_LIST;
 
+	struct sScaledKey
+	{
+		sScaledKey(const QString &Path, const QSize &Size, EnumScaleMode Mode)
+			: path(Path)
+			, size(Size)
+			, mode(Mode)
+		{}
+
+		bool operator<(const sScaledKey &other) const;
+
+		QString			path;
+		QSize			size;
+		EnumScaleMode	mode;
+	};
+
+	struct sScaledItem
+	{
+		sScaledItem()
+			: refCount(0)
+			, pending(false)
+			, queued(false)
+			, lastUsed(0)
+		{}
+
+		QPixmap			pixmap;
+		unsigned int	refCount;
+		bool			pending;	// waiting on the loader, pixmap is a placeholder
+		bool			queued;
+		quint64			lastUsed;
+	};
+
+	typedef std::map<sScaledKey,sScaledItem>	SCALED_LIST;
+	typedef std::pair<sScaledKey,sScaledItem>	SCALED_LIST_PAIR;
+
+	// told when images it asked for finish loading
+	class Client
+	{
+	public:
+		virtual void PixmapCacheClient_Loaded(const QString &path) = 0;
+	};
+
+	typedef std::multimap<QString,Client*>	CLIENTS;
+	typedef std::pair<QString,Client*>		CLIENTS_PAIR;
+
 	PixmapCache();
 	virtual ~PixmapCache();
 
 	virtual void Clear();
-	virtual const QPixmap* Create(const QString &path);
-	virtual const QPixmap* Get(const QString &path) const;
+	virtual void Create(const QString &path);
 	virtual void Destroy(const QString &path);
+	virtual bool IsLoading(const QString &path) const;
 	virtual const PIXMAP_LIST& GetList() const {return m_List;}
-	virtual void Get(const QString &path, QPixmap &pixmap) const;
-	virtual void GetScaledToFit(const QString &path, const QSize &size, QPixmap &pixmap) const;
-	virtual void GetScaledToFill(const QString &path, const QSize &size, QPixmap &pixmap) const;
+	virtual void CreateScaled(const QString &path, const QSize &size, EnumScaleMode mode, QPixmap &pixmap, Client *pClient=0);
+	virtual void GetScaled(const QString &path, const QSize &size, EnumScaleMode mode, QPixmap &pixmap) const;
+	virtual void DestroyScaled(const QString &path, const QSize &size, EnumScaleMode mode);
+	virtual const SCALED_LIST& GetScaledList() const {return m_ScaledList;}
+	virtual void RemoveClient(Client *pClient);
+	virtual qint64 GetBudget() const {return m_Budget;}
+	virtual void SetBudget(qint64 bytes);
+	virtual qint64 GetSourceBytes() const {return m_SourceBytes;}
+	virtual qint64 GetScaledBytes() const {return m_ScaledBytes;}
+	virtual qint64 GetBytes() const {return (m_SourceBytes + m_ScaledBytes);}
+	virtual unsigned int GetEvictions() const {return m_Evictions;}
+	virtual void Trim();
 
 	static void Instantiate();
 	static void Shutdown();
 	static PixmapCache& Instance() {return *sm_Instance;}
 	static bool FitRectInBounds(const QRect &bounds, Qt::Alignment alignment, QRect &r);
+	static QSize GetScaledSize(const QSize &sourceSize, const QSize &size, EnumScaleMode mode);
+	static qint64 GetBytes(const QImage &image);
+	static qint64 GetBytes(const QPixmap &pixmap);
 
 protected:
-	PIXMAP_LIST	m_List;
+	PIXMAP_LIST		m_List;
+	SCALED_LIST		m_ScaledList;
+	CLIENTS			m_Clients;
+	PixmapLoader	*m_Loader;
+	qint64			m_Budget;	// 0 = unlimited, but unreferenced scaled sizes are not kept
+	qint64			m_SourceBytes;
+	qint64			m_ScaledBytes;
+	quint64			m_UseCount;
+	unsigned int	m_Evictions;
 
 	static PixmapCache	*sm_Instance;
+
+	virtual void Decode(const QString &path, sPixmapCacheItem &item);
+	virtual void SetSourceImage(sPixmapCacheItem &item, const QImage &image);
+	virtual void SetScaledPixmap(sScaledItem &item, const QPixmap &pixmap);
+	virtual bool EvictOldest();
+	virtual void TrimScaled(const QString &path);
+	virtual void QueuePendingScales(const QString &path, const QImage &source);
+	virtual void NotifyClients(const QString &path);
+
+private:
+	virtual void PixmapLoaderClient_Loaded(PixmapLoader::sJob &job);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
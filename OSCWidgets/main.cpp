@@ -24,6 +24,9 @@
 #include "EosTimer.h"
 #include "QtInclude.h"
 #include "MainWindow.h"
+#include "AnimationDriver.h"
+#include "Metrics.h"
+#include "Trace.h"
 #include "Utils.h"
 #include "EosPlatform.h"
 
@@ -94,14 +97,24 @@ int main(int argc, char* argv[])
 	QFont fnt("Roboto", 10);
 	app.setFont(fnt);
 
+	TRACE_THREAD_NAME("gui");
+
+	Metrics::Instantiate();
 	PixmapCache::Instantiate();
+	AnimationDriver::Instantiate();
 
 	MainWindow *mainWindow = new MainWindow(platform);
 	mainWindow->show();
 	int result = app.exec();
 	delete mainWindow;
 
+	AnimationDriver::Shutdown();
 	PixmapCache::Shutdown();
+	Metrics::Shutdown();
+
+#ifdef OSCWIDGETS_TRACE
+	Trace::Shutdown();
+#endif
     
     if(platform)
         delete platform;
@@ -0,0 +1,357 @@
+// Copyright (c) 2018 Electronic Theatre Controls, Inc., http://www.etcconnect.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "QtInclude.h"
+#include "AnimationDriver.h"
+#include "Clock.h"
+#include "Metrics.h"
+#include "OSCParser.h"
+#include "ToyFlicker.h"
+#include "ToyMetro.h"
+#include "ToyPedal.h"
+#include "ToySine.h"
+#include "Utils.h"
+#include <QtTest>
+
+////////////////////////////////////////////////////////////////////////////////
+
+// installed for the life of a check, so a failed check cannot leave it behind
+class VirtualClockScope
+	: public VirtualClock
+{
+public:
+	VirtualClockScope() {Clock::SetInstance(this);}
+	virtual ~VirtualClockScope() {Clock::SetInstance(0);}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// keeps what generators send: immediate packets at the clock time they were
+// sent, packets queued ahead at their due time until cancelled
+class CaptureClient
+	: public Toy::Client
+{
+public:
+	struct sPacket
+	{
+		sPacket()
+			: timeNS(0)
+			, hasValue(false)
+			, value(0)
+			, owner(0)
+		{}
+
+		qint64		timeNS;
+		bool		hasValue;
+		float		value;
+		const void	*owner;
+	};
+
+	typedef std::vector<sPacket> PACKETS;
+
+	const PACKETS& GetSent() const {return m_Sent;}
+	const PACKETS& GetQueued() const {return m_Queued;}
+
+	virtual bool ToyClient_Send(bool local, char *data, size_t size);
+	virtual bool ToyClient_SendAt(char *data, size_t size, qint64 dueNS, const void *owner);
+	virtual void ToyClient_CancelSends(const void *owner);
+	virtual void ToyClient_ResourceRelativePathToAbsolute(QString& /*path*/) {}
+
+private:
+	PACKETS	m_Sent;
+	PACKETS	m_Queued;
+
+	static void Capture(char *data, size_t size, sPacket &packet);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CaptureClient::Capture(char *data, size_t size, sPacket &packet)
+{
+	size_t argCount = 0xffffffff;
+	OSCArgument *args = OSCArgument::GetArgs(data, size, argCount);
+	if( args )
+	{
+		if(argCount != 0)
+			packet.hasValue = args[0].GetFloat(packet.value);
+		delete[] args;
+	}
+
+	delete[] data;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool CaptureClient::ToyClient_Send(bool /*local*/, char *data, size_t size)
+{
+	sPacket packet;
+	packet.timeNS = CLOCK.GetTimeNS();
+	Capture(data, size, packet);
+	m_Sent.push_back(packet);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool CaptureClient::ToyClient_SendAt(char *data, size_t size, qint64 dueNS, const void *owner)
+{
+	sPacket packet;
+	packet.timeNS = dueNS;
+	packet.owner = owner;
+	Capture(data, size, packet);
+	m_Queued.push_back(packet);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void CaptureClient::ToyClient_CancelSends(const void *owner)
+{
+	// packets already due would have gone out
+	qint64 nowNS = CLOCK.GetTimeNS();
+	for(PACKETS::iterator i=m_Queued.begin(); i!=m_Queued.end(); )
+	{
+		if(i->owner==owner && i->timeNS>nowNS)
+			i = m_Queued.erase(i);
+		else
+			++i;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// generator grids stepped on a VirtualClock, checked against what they send
+class Tests
+	: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void virtualClockSine();
+	void virtualClockPedal();
+	void virtualClockFlicker();
+	void virtualClockMetro();
+
+private:
+	static void StepGrid(ToyGrid &grid, VirtualClock &clock, unsigned int durationMS, unsigned int stepMS);
+	static void RunFlicker(CaptureClient::PACKETS &sent);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::initTestCase()
+{
+	// refresh and send rates of a fresh app
+	Toy::RestoreDefaultSettings();
+	Metrics::Instantiate();
+	PixmapCache::Instantiate();
+	AnimationDriver::Instantiate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::cleanupTestCase()
+{
+	AnimationDriver::Shutdown();
+	PixmapCache::Shutdown();
+	Metrics::Shutdown();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::StepGrid(ToyGrid &grid, VirtualClock &clock, unsigned int durationMS, unsigned int stepMS)
+{
+	// what the grid's timer does, without waiting for it
+	for(unsigned int ms=0; ms<durationMS; ms+=stepMS)
+	{
+		clock.AdvanceMS(stepMS);
+		grid.Step();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::virtualClockSine()
+{
+	VirtualClockScope clock;
+	CaptureClient client;
+	ToySineGrid grid(&client, /*parent*/0, 0);
+	grid.SetGridSize( QSize(1,1) );
+	grid.SetSendRate("100");
+	QCOMPARE(grid.GetWidgets().size(), static_cast<size_t>(1));
+
+	ToySineWidget *sine = static_cast<ToySineWidget*>( grid.GetWidgets().front() );
+	sine->SetPath("/eos/bench/sine");
+	sine->SetMin("0");
+	sine->SetMax("100");
+	sine->GetSine().SetPaused(false);
+
+	// 60 bpm is a full swing every 2 s, sent no faster than the grid's send rate
+	StepGrid(grid, clock, 10000, Toy::GetSineRefreshRateMS());
+
+	const CaptureClient::PACKETS &sent = client.GetSent();
+	QVERIFY(sent.size() >= 90);
+	QVERIFY(sent.size() <= 100);
+
+	float minValue = 0;
+	float maxValue = 0;
+	for(size_t i=0; i<sent.size(); i++)
+	{
+		QVERIFY(sent[i].hasValue);
+		minValue = qMin(minValue, sent[i].value);
+		maxValue = qMax(maxValue, sent[i].value);
+		if(i != 0)
+			QVERIFY(sent[i].timeNS-sent[i-1].timeNS >= Q_INT64_C(100000000));
+	}
+
+	// min + (max-min)*sin
+	QVERIFY(maxValue > 90);
+	QVERIFY(maxValue <= 100.01f);
+	QVERIFY(minValue < -90);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::virtualClockPedal()
+{
+	VirtualClockScope clock;
+	CaptureClient client;
+	ToyPedalGrid grid(&client, /*parent*/0, 0);
+	grid.SetGridSize( QSize(1,1) );
+	QCOMPARE(grid.GetWidgets().size(), static_cast<size_t>(1));
+
+	ToyPedalWidget *pedal = static_cast<ToyPedalWidget*>( grid.GetWidgets().front() );
+	pedal->SetPath("/eos/bench/pedal");
+	pedal->SetMin("0");
+	pedal->SetMax("100");
+
+	// default 250 ms up and 1000 ms down, every refresh sent
+	unsigned int stepMS = Toy::GetPedalRefreshRateMS();
+	pedal->GetPedal().Press();
+	StepGrid(grid, clock, 300, stepMS);
+	const CaptureClient::PACKETS &sent = client.GetSent();
+	QCOMPARE(sent.size(), static_cast<size_t>(1 + 250/stepMS));
+	QVERIFY(qAbs(sent.front().value) < 0.01f);
+	QCOMPARE(sent.back().value, 100.0f);
+
+	size_t upCount = sent.size();
+	pedal->GetPedal().Release();
+	StepGrid(grid, clock, 1100, stepMS);
+	QCOMPARE(sent.size(), upCount + 1 + 1000/stepMS);
+	QCOMPARE(sent.back().value, 0.0f);
+	QCOMPARE(sent.back().timeNS, Q_INT64_C(1300000000));
+
+	for(size_t i=1; i<sent.size(); i++)
+	{
+		QVERIFY(sent[i].hasValue);
+		if(i < upCount)
+			QVERIFY(sent[i].value > sent[i-1].value);
+		else if(i > upCount)
+			QVERIFY(sent[i].value < sent[i-1].value);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::RunFlicker(CaptureClient::PACKETS &sent)
+{
+	VirtualClockScope clock;
+	CaptureClient client;
+	ToyFlickerGrid grid(&client, /*parent*/0, 0);
+	grid.SetGridSize( QSize(1,1) );
+
+	ToyFlickerWidget *flicker = static_cast<ToyFlickerWidget*>( grid.GetWidgets().front() );
+	flicker->SetPath("/eos/bench/flicker");
+	flicker->SetMin("0");
+	flicker->SetMax("100");
+	flicker->GetFlicker().SetPaused(false);
+
+	StepGrid(grid, clock, 10000, Toy::GetFlickerRefreshRateMS());
+	sent = client.GetSent();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::virtualClockFlicker()
+{
+	// a show seed makes the sequence replay exactly, see ToyFlickerWidget::UpdateSeed
+	unsigned int showSeed = Toy::GetFlickerSeed();
+	Toy::SetFlickerSeed(1234);
+
+	CaptureClient::PACKETS sent;
+	RunFlicker(sent);
+	CaptureClient::PACKETS replay;
+	RunFlicker(replay);
+
+	Toy::SetFlickerSeed(showSeed);
+
+	// default 600 bpm is a beat every 100 ms
+	QCOMPARE(sent.size(), static_cast<size_t>(100));
+	QCOMPARE(replay.size(), sent.size());
+	for(size_t i=0; i<sent.size(); i++)
+	{
+		QVERIFY(sent[i].hasValue);
+		QVERIFY(sent[i].value>=0 && sent[i].value<=100);
+		QCOMPARE(sent[i].timeNS, static_cast<qint64>(i+1)*Q_INT64_C(100000000));
+		QCOMPARE(replay[i].value, sent[i].value);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::virtualClockMetro()
+{
+	VirtualClockScope clock;
+	CaptureClient client;
+	ToyMetroGrid grid(&client, /*parent*/0, 0);
+	grid.SetGridSize( QSize(1,1) );
+	QCOMPARE(grid.GetWidgets().size(), static_cast<size_t>(1));
+
+	ToyMetroWidget *metro = static_cast<ToyMetroWidget*>( grid.GetWidgets().front() );
+	metro->SetPath("/eos/bench/metro");
+	metro->SetMin("0");
+	metro->SetMax("1");
+	metro->GetMetro().SetPaused(false);
+
+	// 60 bpm swings right then left, a beat a second, queued ahead at exact due times
+	StepGrid(grid, clock, 10000, Toy::GetMetroRefreshRateMS());
+
+	QVERIFY( client.GetSent().empty() );
+
+	const CaptureClient::PACKETS &queued = client.GetQueued();
+	QCOMPARE(queued.size(), static_cast<size_t>(10));
+	for(size_t i=0; i<queued.size(); i++)
+	{
+		QVERIFY(queued[i].hasValue);
+		QCOMPARE(queued[i].value, (i%2 == 0) ? 1.0f : 0.0f);
+
+		qint64 expectedNS = (Q_INT64_C(500000000) + static_cast<qint64>(i)*Q_INT64_C(1000000000));
+		QVERIFY(qAbs(queued[i].timeNS-expectedNS) < Q_INT64_C(1000000));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+QTEST_MAIN(Tests)
+#include "Tests.moc"
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,31 @@
+# Pass/fail checks for OSCWidgets, built from the app sources. Generator grids
+# are stepped on a VirtualClock, so an hour of output runs in milliseconds.
+#
+#   mkdir build-tests && cd build-tests
+#   qmake ../Tests/Tests.pro && make
+#   QT_QPA_PLATFORM=offscreen ./OSCWidgetsTests
+
+APP_ROOT = $$PWD/..
+include($$APP_ROOT/OSCWidgets.pro)
+
+TARGET = OSCWidgetsTests
+QT += testlib
+CONFIG += console
+CONFIG -= app_bundle
+
+# app paths are relative to the app project, and main() comes from QTEST_MAIN
+defineReplace(appPaths) {
+    result =
+    for(file, 1) {
+        !equals(file, OSCWidgets/main.cpp): result += $$APP_ROOT/$$file
+    }
+    return($$result)
+}
+
+HEADERS = $$appPaths($$HEADERS)
+SOURCES = $$appPaths($$SOURCES)
+OBJECTIVE_SOURCES = $$appPaths($$OBJECTIVE_SOURCES)
+RESOURCES = $$appPaths($$RESOURCES)
+INCLUDEPATH = $$appPaths($$INCLUDEPATH)
+
+SOURCES += Tests.cpp